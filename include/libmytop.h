@@ -0,0 +1,134 @@
+/**
+ * @file libmytop.h
+ * @brief Embeddable collection API (libmytop.a / libmytop.so)
+ *
+ * A context owns everything a scan needs: the process lists, the string
+ * table, the io_uring instance and the /proc/meminfo descriptor. Each
+ * mytop_sample() writes a snapshot into buffers the caller provides, so
+ * nothing is allocated per call once the lists have grown to the
+ * process count. Contexts share no state: any number of them can run,
+ * one per thread, but a single context must not be used from two
+ * threads at once. The library prints nothing; messages go to the log
+ * sink of the context.
+ */
+
+#ifndef LIBMYTOP_H
+#define LIBMYTOP_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Symbols exported by libmytop.so (everything else is hidden)
+#define MYTOP_API __attribute__((visibility("default")))
+
+#define MYTOP_CMD_LEN 128  // Command line bytes kept per snapshot record (NUL included)
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* --------- Status Codes (0 is success, negetive is failure) --------- */
+typedef enum {
+  MYTOP_OK          =  0,  // Success
+  MYTOP_ERR         = -1,  // General error
+  MYTOP_ERR_IO      = -2,  // File I/O failure
+  MYTOP_ERR_PARSE   = -3,  // Parsing/format error
+  MYTOP_ERR_PARAM   = -4,  // Invalid parameter (e.g., NULL pointer)
+  MYTOP_ERR_NOMEM   = -5,  // Memory allocation failure
+  MYTOP_ERR_RANGE   = -6,  // Numerical overflow
+  MYTOP_NO_FILE     = -7,  // File does not exist
+  MYTOP_NO_DATA     = -8,  // File is empty
+} mytop_status_t;
+
+// Collection context (opaque)
+typedef struct mytop_ctx mytop_ctx_t;
+
+// Severity of a library message
+typedef enum {
+  MYTOP_LOG_DEBUG = 0,
+  MYTOP_LOG_INFO,
+  MYTOP_LOG_WARN,
+  MYTOP_LOG_ERROR,
+  MYTOP_LOG_FATAL
+} mytop_log_level_t;
+
+// Receives each message at or above the sink's level, already formatted
+typedef void (*mytop_log_fn)(void *user, mytop_log_level_t level, const char *module,
+                             const char *file, int line, const char *msg);
+
+// Destination of the messages of a context
+typedef struct {
+  mytop_log_fn fn;        // NULL discards the messages
+  void *user;             // Passed back to fn
+  mytop_log_level_t level; // Minimum level delivered
+} mytop_log_sink_t;
+
+// Record order of a snapshot
+typedef enum {
+  MYTOP_SORT_CPU,         // Descending CPU%
+  MYTOP_SORT_MEM,         // Descending resident set size
+  MYTOP_SORT_PID          // Descending PID
+} mytop_sort_t;
+
+// Options of a context, see mytop_options_init() for the defaults
+typedef struct {
+  bool schedstat;         // Nanosecond CPU accounting where the kernel provides it
+  bool children;          // Charge reaped children's CPU time to their parents
+  bool use_uring;         // Batch the /proc reads through io_uring where it works
+  mytop_sort_t sort;      // Record order; a short snapshot buffer keeps the first ones
+  mytop_log_sink_t log;   // Destination of messages (fn NULL discards them)
+} mytop_options_t;
+
+// A process of a snapshot
+typedef struct {
+  uint64_t pid;
+  uint64_t ppid;
+  uint64_t pgrp;
+  char state;             // R, S, D, Z, ...
+  double cpu_percent;     // Since the previous sample (100% = one core)
+  double delay_percent;   // Runnable but waiting for a CPU (schedstat accounting only)
+  uint64_t utime_ms;      // User time since the process started
+  uint64_t stime_ms;      // Kernel time since the process started
+  uint64_t virt_kb;       // Virtual memory size
+  uint64_t res_kb;        // Resident set size
+  uint64_t starttime;     // Start time after boot (jiffies): tells a reused PID apart
+  char command[MYTOP_CMD_LEN]; // Command line (comm for kernel threads), truncated
+} mytop_proc_t;
+
+// Memory summary of a snapshot (/proc/meminfo, same formulas as free(1))
+typedef struct {
+  uint64_t total_kb;      // MemTotal
+  uint64_t free_kb;       // MemFree
+  uint64_t available_kb;  // MemAvailable
+  uint64_t used_kb;       // MemTotal - MemAvailable
+  uint64_t buff_cache_kb; // Buffers + Cached + SReclaimable
+  uint64_t swap_total_kb; // SwapTotal
+  uint64_t swap_used_kb;  // SwapTotal - SwapFree
+  double used_percent;    // used_kb over total_kb (0.0 - 100.0)
+} mytop_mem_t;
+
+// System-wide part of a snapshot and the caller's record buffer
+typedef struct {
+  mytop_proc_t *procs;    // Caller-owned records [in]
+  size_t capacity;        // Entries available in procs [in]
+  size_t count;           // Entries written
+  size_t nprocs;          // Processes on the system (may exceed count)
+  uint64_t sample_ns;     // CLOCK_MONOTONIC time of the scan
+  double cpu_percent;     // Whole-system CPU usage since the previous sample
+  uint64_t births;        // Processes started since the previous sample
+  uint64_t deaths;        // Processes exited since the previous sample
+  uint64_t forks;         // clone() calls since the previous sample (threads included)
+  mytop_mem_t mem;        // Memory summary
+} mytop_snapshot_t;
+
+MYTOP_API void mytop_options_init(mytop_options_t *opts);
+MYTOP_API mytop_status_t mytop_open(mytop_ctx_t **ctx, const mytop_options_t *opts);
+MYTOP_API mytop_status_t mytop_sample(mytop_ctx_t *ctx, mytop_snapshot_t *snap);
+MYTOP_API void mytop_close(mytop_ctx_t *ctx);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // !LIBMYTOP_H
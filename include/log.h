@@ -16,12 +16,21 @@ typedef enum {
   LOG_FATAL
 } log_level_t;
 
-// Controls the minimum log level that the current program will output.
-// For example:
-// IF 'g_log_level = LOG_INFO'; THEN:
-// * DEBUG -> not printed
-// * INFO/WARN/ERROR -> printed
-extern log_level_t g_log_level;
+// Receives each message at or above the sink's level, already formatted
+typedef void (*log_sink_fn)(void *user, log_level_t level, const char *module,
+                            const char *file, int line, const char *msg);
+
+// Destination of the log messages of a thread
+typedef struct {
+  log_sink_fn fn;         // NULL discards the messages
+  void *user;             // Passed back to fn
+  log_level_t level;      // Minimum level delivered
+} log_sink_t;
+
+// Threads that never install a sink write INFO and above to stderr, in the
+// format above, and LOG_FATAL ends the process. An installed sink only
+// receives the message: a library caller is never terminated.
+const log_sink_t *log_set_sink(const log_sink_t *sink);
 
 void log_write(log_level_t level,
                const char *module,
@@ -11,23 +11,149 @@
 #define MYTOP_H
 
 #include "mytop_types.h"
+#include <stdbool.h>
 #include <stdint.h>
+#include <poll.h>
 
 /* --------- System Interfaces --------- */
 mytop_status_t parse_version(sys_info_t *sys);
-mytop_status_t parse_meminfo(mem_info_t *mem);
-void print_system_snapshot(const sys_info_t *sys, const mem_info_t *mem);
+int meminfo_open(void);
+mytop_status_t parse_meminfo(int fd, mem_info_t *mem);
 
 /* --------- CPU Interfaces --------- */
 mytop_status_t parse_cpu_stat(cpu_stat_t *stat);
 double calculate_cpu_usage(const cpu_stat_t *prev, const cpu_stat_t *curr, uint64_t *total_delta);
+uint32_t calculate_core_usage(const cpu_stat_t *prev, const cpu_stat_t *curr,
+                              float *usage, size_t cap);
 
 /* --------- Process Interfaces --------- */
-proc_list_t *create_procs_list(size_t capacity_hint);
+proc_list_t *create_procs_list(size_t capacity_hint, str_table_t *strtab);
 void free_procs_list(proc_list_t *list);
+void clear_procs_list(proc_list_t *list);
+mytop_status_t reserve_procs_list(proc_list_t *list, size_t capacity);
+mytop_status_t copy_procs_list(proc_list_t *dst, const proc_list_t *src);
+void trim_procs_list(proc_list_t *list);
+size_t procs_keep_for_memory(uint64_t max_bytes, size_t nprocs);
+mytop_status_t cap_procs_list(proc_list_t *list, size_t keep);
 mytop_status_t parse_procs(proc_list_t *list);
-void calculate_procs_cpu(const proc_list_t *prev, proc_list_t *curr, uint64_t total_delta);
+mytop_status_t parse_procs_bounded(proc_list_t *list, uint64_t budget_ns);
+mytop_status_t parse_procs_sampled(proc_list_t *list, proc_list_t *prev, uint32_t slices,
+                                   uint64_t scan);
+bool procs_attach_uring(uring_t *ring, proc_list_t *a, proc_list_t *b);
+mytop_status_t watch_add_pids(watch_t *w, const char *arg);
+bool watch_enabled(const watch_t *w);
+void procs_attach_watch(watch_t *w, proc_list_t *a, proc_list_t *b);
+void watch_free(watch_t *w);
+bool schedstat_available(void);
+mytop_status_t parse_smaps_rollup(uint64_t pid, smaps_info_t *smaps);
+mytop_status_t read_proc_starttime(uint64_t pid, uint64_t *starttime);
+mytop_status_t parse_proc_ctxsw(uint64_t pid, uint64_t *vcsw, uint64_t *nvcsw);
+void calculate_procs_cpu(proc_list_t *prev, proc_list_t *curr, lifecycle_t *lc);
+void estimate_procs_cpu(proc_list_t *list);
+void procs_lifecycle(proc_list_t *prev, proc_list_t *curr, lifecycle_t *lc);
 void sort_procs_by_mode(proc_list_t *list, sort_mode_t mode);
-void print_procs(const proc_list_t *list);
+mytop_status_t sort_procs_incremental(const proc_list_t *prev, proc_list_t *curr, sort_mode_t mode);
+mytop_status_t select_procs_window(proc_list_t *list, sort_mode_t mode, size_t lo, size_t hi);
+void view_follow(proc_view_t *view, const proc_list_t *list, size_t visible);
+void view_move(proc_view_t *view, proc_list_t *list, sort_mode_t mode, long delta, size_t visible);
+void view_resort(proc_view_t *view, proc_list_t *list, sort_mode_t mode, size_t visible);
+
+/* --------- Display Interfaces (front end only, not in libmytop) --------- */
+void print_system_snapshot(const sys_info_t *sys, const mem_info_t *mem);
+int print_cores(const proc_list_t *list, const float *usage, size_t ncores, int rows);
+int print_pressure(const psi_info_t *psi);
+int iostat_panel_lines(const iostat_t *io);
+int print_iostat(const iostat_t *io);
+int lifecycle_panel_lines(const lifecycle_t *lc, bool show_exits);
+int print_lifecycle(const lifecycle_t *lc, size_t nprocs, size_t unread,
+                    const proc_summary_t *dropped, bool show_exits);
+size_t procs_visible_count(const proc_list_t *list, int header_lines);
+
+/* --------- Column Interfaces --------- */
+column_set_t columns_default(void);
+mytop_status_t columns_parse(const char *spec, column_set_t *set, const char **bad);
+void columns_format(column_set_t set, char *out, size_t out_sz);
+uint32_t columns_sources(column_set_t set, sort_mode_t sort, int *stat_fields);
+void print_procs(const proc_list_t *list, const proc_track_t *track,
+                 column_set_t set, int header_lines, const proc_view_t *view);
+
+/* --------- String Table Interfaces --------- */
+str_table_t *create_str_table(void);
+void free_str_table(str_table_t *tab);
+uint32_t strtab_intern(str_table_t *tab, const char *s, size_t len);
+void strtab_release(str_table_t *tab, uint32_t handle);
+void strtab_ref(str_table_t *tab, uint32_t handle);
+const char *strtab_get(const str_table_t *tab, uint32_t handle);
+size_t strtab_len(const str_table_t *tab, uint32_t handle);
+
+/* --------- Shared Snapshot Interfaces --------- */
+mytop_status_t shm_publisher_open(shm_snapshot_t *shm, const char *name, uint64_t interval_ms,
+                                  bool shared);
+mytop_status_t shm_publish(shm_snapshot_t *shm, const mem_info_t *mem,
+                           double cpu_usage, const proc_list_t *list);
+mytop_status_t shm_viewer_open(shm_snapshot_t *shm, const char *name);
+mytop_status_t shm_read(shm_snapshot_t *shm, mem_info_t *mem,
+                        double *cpu_usage, proc_list_t *list);
+void shm_close(shm_snapshot_t *shm);
+
+/* --------- Pressure Interfaces --------- */
+mytop_status_t psi_open(psi_info_t *psi);
+mytop_status_t psi_sample(psi_info_t *psi);
+mytop_status_t psi_arm_triggers(psi_info_t *psi, uint64_t stall_us, uint64_t window_us);
+size_t psi_fill_pollfds(const psi_info_t *psi, struct pollfd *fds, size_t cap);
+bool psi_handle_events(psi_info_t *psi, const struct pollfd *fds, size_t n);
+void psi_close(psi_info_t *psi);
+const char *psi_resource_name(int res);
+
+/* --------- Disk & Network Interfaces --------- */
+mytop_status_t iostat_open(iostat_t *io);
+mytop_status_t iostat_sample(iostat_t *io);
+void iostat_close(iostat_t *io);
+size_t iostat_busiest_disks(const iostat_t *io, const disk_stat_t **rows);
+size_t iostat_busiest_nets(const iostat_t *io, const net_stat_t **rows);
+
+/* --------- io_uring Interfaces --------- */
+mytop_status_t uring_init(uring_t *ring, size_t nslots);
+void uring_free(uring_t *ring);
+void uring_queue_read(uring_t *ring, size_t slot, const char *path);
+mytop_status_t uring_submit(uring_t *ring, uring_read_fn on_read, void *ctx);
+
+/* --------- Batch Output Interfaces --------- */
+mytop_status_t batch_writer_open(batch_writer_t *w, int fd, batch_format_t fmt);
+mytop_status_t batch_write_tick(batch_writer_t *w, const mem_info_t *mem, double cpu_usage,
+                                const proc_list_t *list, size_t limit);
+mytop_status_t batch_flush(batch_writer_t *w);
+void batch_writer_close(batch_writer_t *w);
+
+/* --------- Pipeline Interfaces --------- */
+mytop_status_t pipeline_start(pipeline_t *pl, uint64_t interval_ms, cpu_acct_t acct, bool children,
+                              const char *shm_name, uint64_t psi_trigger_ms,
+                              uint32_t sources, int stat_fields, bool use_uring,
+                              uint64_t max_memory, uint32_t sample_slices, watch_t *watch);
+bool pipeline_acquire(pipeline_t *pl);
+snapshot_t *pipeline_front(pipeline_t *pl);
+void pipeline_set_sort(pipeline_t *pl, sort_mode_t mode);
+void pipeline_set_sources(pipeline_t *pl, uint32_t sources, int stat_fields);
+void pipeline_refresh(pipeline_t *pl);
+int pipeline_notify_fd(const pipeline_t *pl);
+void pipeline_drain_notify(pipeline_t *pl);
+void pipeline_stop(pipeline_t *pl);
+
+/* --------- Track Interfaces --------- */
+proc_track_t *create_proc_track(size_t max_pids);
+void free_proc_track(proc_track_t *track);
+void track_update(proc_track_t *track, const proc_list_t *list);
+void track_open_pidfds(proc_track_t *track, const proc_list_t *list);
+const track_entry_t *track_lookup(const proc_track_t *track, uint64_t pid);
+void track_refresh_smaps(proc_track_t *track, const proc_list_t *list,
+                         size_t first, size_t visible, size_t budget);
+void track_refresh_ctxsw(proc_track_t *track, const proc_list_t *list,
+                         size_t first, size_t visible);
+void track_format_sparkline(const track_entry_t *e, spark_series_t series, char *out,
+                            size_t out_sz);
+mytop_status_t track_signal(const proc_track_t *track, uint64_t pid,
+                            uint64_t starttime, int sig);
+size_t track_signal_matching(const proc_track_t *track, const proc_list_t *list,
+                             const char *pattern, int sig, size_t *failed);
 
 #endif // !MYTOP_H
@@ -1,28 +1,49 @@
 #ifndef MYTOP_TYPES_H
 #define MYTOP_TYPES_H
 
+#include "libmytop.h"  // Status codes, shared with the public interface
+#include <pthread.h>
+#include <stdatomic.h>
 #include <stdint.h>
 #include <stddef.h>
 
-/* --------- Status Codes (0 is success, negetive is failure) --------- */
-typedef enum {
-  MYTOP_OK          =  0,  // Success
-  MYTOP_ERR         = -1,  // General error
-  MYTOP_ERR_IO      = -2,  // File I/O failure
-  MYTOP_ERR_PARSE   = -3,  // Parsing/format error
-  MYTOP_ERR_PARAM   = -4,  // Invalid parameter (e.g., NULL pointer)
-  MYTOP_ERR_NOMEM   = -5,  // Memory allocation failure
-  MYTOP_ERR_RANGE   = -6,  // Numerical overflow
-  MYTOP_NO_FILE     = -7,  // File does not exist
-  MYTOP_NO_DATA     = -8,  // File is empty
-} mytop_status_t;
-
 /* --------- Constant definition --------- */
 #define BUFFER_SIZE      1024
+#define MEMINFO_BUF_SIZE 8192  // /proc/meminfo is read in one pread()
 #define KERNEL_VER_LEN   64
 #define MACHINE_ARCH_LEN 32
-#define MAX_CMD_LEN      256
+#define STRTAB_CHUNK     1024  // String table entries per chunk
+#define STRTAB_MAX_CHUNK 4096  // Chunk directory size (max ~4M distinct strings)
 #define DEFAULT_CAPACITY 512
+#define HISTORY_LEN      16    // Samples kept per process for sparklines
+#define MAX_TRACKED_PIDS 8192  // Default bound on processes with history
+#define SMAPS_BUDGET     8     // Default smaps_rollup reads per tick
+#define SMAPS_MAX_BUDGET 64    // Upper bound on smaps_rollup reads per tick
+#define DEV_NAME_LEN     32    // Block device / interface name length
+#define MAX_DISKS        64    // Block devices tracked by the disk panel
+#define MAX_NETIFS       64    // Interfaces tracked by the network panel
+#define IOSTAT_ROWS      4     // Rows shown per throughput panel
+#define IOSTAT_BUF_SIZE  16384 // Initial read buffer for diskstats/net/dev
+#define BATCH_BUF_SIZE   65536 // Batch output buffer, flushed with write()
+#define EXIT_RING_LEN    8     // Departed processes kept for the recent exits panel
+#define EXIT_CMD_LEN     64    // Command bytes kept per departed process
+#define PSI_WINDOW_US    2000000  // PSI trigger window (unprivileged minimum granularity)
+#define SHM_POLL_MS      100   // Viewer re-check delay while no new snapshot
+#define MAX_CORES        256   // Cores followed by the per-core view
+#define CORE_TOP_PROCS   3     // Processes listed under each core
+#define SHRINK_TICKS     60    // Scans using under a quarter of a list before it shrinks
+#define MIN_KEPT_PROCS   64    // Processes kept under --max-memory whatever the budget
+#define SCAN_LISTS       2     // Collector lists (prev and curr), each with a sort buffer
+#define SNAPSHOT_SLOTS   3     // Snapshot copies of the collector/UI triple buffer
+#define SAMPLE_HOT_PROCS 256   // Top processes re-read every tick in sampled mode
+#define SAMPLE_MAX_SLICES 64   // Largest --sample N (full coverage every N ticks)
+#define WATCH_MAX_PROCS  256   // Processes a watch list follows at most
+#define WATCH_RESCAN_MS  5000  // Period of the /proc walk looking for new watch matches
+#define WATCH_INTERVAL_MS 100  // Default refresh interval of a watch list
+#define WATCH_NAME_LEN   64    // --match pattern length
+#define URING_BATCH      128   // Processes per io_uring submission
+#define URING_SLOT_SIZE  1024  // Registered buffer bytes per file read
+#define URING_PATH_LEN   32    // "/proc/[pid]/schedstat" and the like
 
 /* --------- Data structure definition --------- */
 // System information
@@ -31,16 +52,73 @@ typedef struct {
     char machine[MACHINE_ARCH_LEN];
 } sys_info_t;
 
-// Memory information
+// Memory information (/proc/meminfo, values in kB unless noted)
 typedef struct {
-  uint64_t total;         // MemTotal: Total physical memory (kB)
-  uint64_t free;          // MemFree: Unused memory (kB)
-  uint64_t buffers;       // Buffers: Memory used for block device cache (kB)
-  uint64_t cached;        // Cached: Memory used for file cache (kB)
-  uint64_t available;     // MemAvailable: Estimated available memory (kB)
-  
-  uint64_t used;          // Memory used (kB) = Total - Free - Buffers - Cached 
-  double used_percent;    // Memory usage rate (0.0 - 100.0)
+  uint64_t total;              // MemTotal: Total usable physical memory (kB)
+  uint64_t free;               // MemFree: Unused memory (kB)
+  uint64_t available;          // MemAvailable: Estimated memory available without swapping (kB)
+  uint64_t buffers;            // Buffers: Block device cache (kB)
+  uint64_t cached;             // Cached: Page cache (excluding swap cache) (kB)
+  uint64_t swap_cached;        // SwapCached (kB)
+  uint64_t active;             // Active (kB)
+  uint64_t inactive;           // Inactive (kB)
+  uint64_t active_anon;        // Active(anon) (kB)
+  uint64_t inactive_anon;      // Inactive(anon) (kB)
+  uint64_t active_file;        // Active(file) (kB)
+  uint64_t inactive_file;      // Inactive(file) (kB)
+  uint64_t unevictable;        // Unevictable (kB)
+  uint64_t mlocked;            // Mlocked (kB)
+  uint64_t swap_total;         // SwapTotal (kB)
+  uint64_t swap_free;          // SwapFree (kB)
+  uint64_t zswap;              // Zswap (kB)
+  uint64_t zswapped;           // Zswapped (kB)
+  uint64_t dirty;              // Dirty (kB)
+  uint64_t writeback;          // Writeback (kB)
+  uint64_t anon_pages;         // AnonPages (kB)
+  uint64_t mapped;             // Mapped (kB)
+  uint64_t shmem;              // Shmem (kB)
+  uint64_t kreclaimable;       // KReclaimable (kB)
+  uint64_t slab;               // Slab (kB)
+  uint64_t sreclaimable;       // SReclaimable (kB)
+  uint64_t sunreclaim;         // SUnreclaim (kB)
+  uint64_t kernel_stack;       // KernelStack (kB)
+  uint64_t page_tables;        // PageTables (kB)
+  uint64_t sec_page_tables;    // SecPageTables (kB)
+  uint64_t nfs_unstable;       // NFS_Unstable (kB)
+  uint64_t bounce;             // Bounce (kB)
+  uint64_t writeback_tmp;      // WritebackTmp (kB)
+  uint64_t commit_limit;       // CommitLimit (kB)
+  uint64_t committed_as;       // Committed_AS (kB)
+  uint64_t vmalloc_total;      // VmallocTotal (kB)
+  uint64_t vmalloc_used;       // VmallocUsed (kB)
+  uint64_t vmalloc_chunk;      // VmallocChunk (kB)
+  uint64_t percpu;             // Percpu (kB)
+  uint64_t hardware_corrupted; // HardwareCorrupted (kB)
+  uint64_t anon_huge_pages;    // AnonHugePages (kB)
+  uint64_t shmem_huge_pages;   // ShmemHugePages (kB)
+  uint64_t shmem_pmd_mapped;   // ShmemPmdMapped (kB)
+  uint64_t file_huge_pages;    // FileHugePages (kB)
+  uint64_t file_pmd_mapped;    // FilePmdMapped (kB)
+  uint64_t cma_total;          // CmaTotal (kB)
+  uint64_t cma_free;           // CmaFree (kB)
+  uint64_t unaccepted;         // Unaccepted (kB)
+  uint64_t balloon;            // Balloon (kB)
+  uint64_t huge_pages_total;   // HugePages_Total (pages)
+  uint64_t huge_pages_free;    // HugePages_Free (pages)
+  uint64_t huge_pages_rsvd;    // HugePages_Rsvd (pages)
+  uint64_t huge_pages_surp;    // HugePages_Surp (pages)
+  uint64_t huge_page_size;     // Hugepagesize (kB)
+  uint64_t hugetlb;            // Hugetlb (kB)
+  uint64_t direct_map_4k;      // DirectMap4k (kB)
+  uint64_t direct_map_2m;      // DirectMap2M (kB)
+  uint64_t direct_map_4m;      // DirectMap4M (kB)
+  uint64_t direct_map_1g;      // DirectMap1G (kB)
+
+  // Derived with the same formulas as free(1)
+  uint64_t buff_cache;         // Buffers + Cached + SReclaimable (kB)
+  uint64_t used;               // MemTotal - MemAvailable (kB)
+  uint64_t swap_used;          // SwapTotal - SwapFree (kB)
+  double used_percent;         // Memory usage rate (0.0 - 100.0)
 } mem_info_t;
 
 // CPU statistics
@@ -53,33 +131,412 @@ typedef struct {
   uint64_t irq;           // Time the CPU spends on hard interrupts (jiffies)
   uint64_t softirq;       // Time the CPU spends on soft interrupts (jiffies) 
   uint64_t steal;         // Virtualization (jiffies) 
+  uint64_t processes;     // Forks since boot ("processes" line)
+  uint32_t ncores;        // Highest "cpuN" line + 1 (up to MAX_CORES)
+  uint64_t core_busy[MAX_CORES];  // Non-idle jiffies of each core
+  uint64_t core_total[MAX_CORES]; // All jiffies of each core (0 = offline)
 } cpu_stat_t;
 
 // A single process information
 typedef struct {
   uint64_t pid;           // (1) Process ID
   char state;             // (3) Process state (R, S, Z, etc.)
-  char cmd[MAX_CMD_LEN];  // (2) Filename of the executable (in parenthess)
+  uint32_t cmd;           // (2) Handle of the interned command line (0 = none)
 
   uint64_t ppid;          // (4) Parent PID
   uint64_t pgrp;          // (5) Process Group ID
 
   uint64_t utime;         // (14) User time (jiffies)
   uint64_t stime;         // (15) Kernel time (jiffies)
+  uint64_t cutime;        // (16) User time of waited-for children (jiffies)
+  uint64_t cstime;        // (17) Kernel time of waited-for children (jiffies)
+
+  uint64_t starttime;     // (22) Time the process started after boot (jiffies)
+  uint64_t ino;           // Inode of /proc/[pid] when read, renewed when the PID is reused
+
+  uint64_t run_ns;        // schedstat (1) Time spent on the CPU (ns)
+  uint64_t wait_ns;       // schedstat (2) Time spent waiting on a run queue (ns)
+  uint64_t timeslices;    // schedstat (3) Number of timeslices run on this CPU
+  int has_schedstat;      // Non-zero if the schedstat fields above are valid
 
   uint64_t vsize;         // (23) Virtual memory size (byte)
   uint64_t rss;           // (24) Resident Set Size (Number of pages of physical memory 
                           //      actually occupied by the process)
+  uint64_t minflt;        // (10) Minor faults (no disk access needed)
+  uint64_t majflt;        // (12) Major faults (page read from disk)
+  uint64_t blkio_ticks;   // (42) Time blocked on block I/O (jiffies, needs delay accounting)
+  int processor;          // (39) CPU the process last ran on (-1 = not parsed)
+  uint64_t migrations;    // Last-CPU changes seen across scans since first seen
+  uint64_t sample_ns;     // CLOCK_MONOTONIC time the counters above were read
+  int stale;              // Kept from an earlier scan, not re-read (sampled mode)
+  uint64_t shared;        // statm (3) Resident shared pages
+  uint64_t read_bytes;    // io read_bytes: Bytes fetched from storage
+  uint64_t write_bytes;   // io write_bytes: Bytes sent to storage
+  int has_io;             // Non-zero if the io fields above are valid
   double cpu_percent;     
+  double delay_percent;   // Share of the interval spent runnable but not running
+  double minflt_rate;     // Minor faults per second
+  double majflt_rate;     // Major faults per second
+  double iodelay_percent; // Share of the interval blocked on block I/O
+  double read_rate;       // Storage reads (bytes/s)
+  double write_rate;      // Storage writes (bytes/s)
+  double migrate_rate;    // Last-CPU changes per second (at most one per scan)
+  double child_percent;   // Part of cpu_percent charged for reaped children
+  uint64_t child_ticks;   // Children jiffies behind child_percent
 } proc_info_t;
 
+// Interned string (one per distinct command line)
+typedef struct {
+  char *str;              // Heap copy, NUL-terminated, full length
+  uint32_t len;           // Length without the terminator
+  uint32_t hash;          // FNV-1a hash of the string
+  uint32_t refs;          // Number of records referring to the string
+  uint32_t next_free;     // Free-list link (slot + 1, 0 = end) while unused
+} str_entry_t;
+
+// Refcounted, hash-interned string table
+typedef struct {
+  str_entry_t *chunks[STRTAB_MAX_CHUNK]; // Fixed directory, chunks never move
+  size_t nchunks;         // Chunks allocated so far
+  uint32_t *index;        // Open-addressing table: hash -> handle (0 = empty)
+  size_t index_mask;      // Index table size - 1 (power of two)
+  size_t count;           // Live strings
+  size_t bytes;           // Bytes held by live strings
+  uint32_t free_head;     // Head of the free-slot list (slot + 1, 0 = empty)
+} str_table_t;
+
+// Per-process CPU accounting backend
+typedef enum {
+  ACCT_JIFFIES,           // utime + stime from stat (USER_HZ resolution)
+  ACCT_SCHEDSTAT          // On-CPU/run-queue nanoseconds from schedstat
+} cpu_acct_t;
+
+// Per-process files a column can depend on (/proc/[pid]/stat is always read)
+#define SRC_CMDLINE    (1u << 0)  // cmdline (comm for kernel threads)
+#define SRC_SCHEDSTAT  (1u << 1)  // schedstat, with ACCT_SCHEDSTAT
+#define SRC_STATM      (1u << 2)  // statm
+#define SRC_IO         (1u << 3)  // io (other users' processes need privileges)
+#define SRC_STATUS     (1u << 4)  // status, read for visible rows only
+#define SRC_SMAPS      (1u << 5)  // smaps_rollup, read for visible rows only
+#define SRC_SCAN       (SRC_CMDLINE | SRC_SCHEDSTAT | SRC_STATM | SRC_IO) // Read by parse_procs()
+#define STAT_MIN_FIELD 22         // stat is parsed at least up to starttime (identity, CPU time)
+#define STAT_MAX_FIELD 42         // Highest stat field any column uses
+
+// Bit i selects column i of the process table registry
+typedef uint64_t column_set_t;
+
+// CPU counters of a process dropped by the memory cap, so it can be ranked next scan
+typedef struct {
+  uint64_t pid;
+  uint64_t starttime;
+  uint64_t cpu_ticks;     // utime + stime (jiffies)
+  uint64_t run_ns;
+  uint64_t wait_ns;
+  int has_schedstat;
+  uint64_t sample_ns;     // When they were read
+} proc_carry_t;
+
+// Processes left out of a list by the memory cap
+typedef struct {
+  size_t count;
+  double cpu_percent;     // Sum of their CPU usage
+  uint64_t rss;           // Sum of their resident pages
+} proc_summary_t;
+
+// A watched process, read through descriptors kept open across scans
+typedef struct {
+  uint64_t pid;
+  uint64_t starttime;     // Start time read when the process was first opened
+  int dir_fd;             // /proc/[pid], pins the process (files opened relative to it)
+  int stat_fd;
+  int schedstat_fd;       // -1 until a column needs the file
+  int statm_fd;
+  int io_fd;
+  uint32_t cmd;           // Command line, interned once (the watch holds a reference)
+} watch_proc_t;
+
+// Fixed set of processes read instead of walking /proc (-p, --pidfile, --match)
+typedef struct {
+  uint64_t pids[WATCH_MAX_PROCS]; // PIDs given with -p
+  uint64_t pid_starts[WATCH_MAX_PROCS]; // Start time of the process each one named
+  uint8_t pid_seen[WATCH_MAX_PROCS]; // pid_starts[i] is known
+  size_t npids;
+  const char *pidfile;    // File holding a PID, read again at every rescan (NULL = none)
+  char match[WATCH_NAME_LEN]; // Substring of the comm to follow ("" = none)
+  watch_proc_t procs[WATCH_MAX_PROCS]; // Processes currently followed
+  size_t count;
+  uint64_t next_rescan_ns; // CLOCK_MONOTONIC time of the next lookup for new processes
+  str_table_t *strtab;    // Table of the cmd references (set at the first scan)
+} watch_t;
+
+// Per-process files read through one io_uring submission (slot = proc * URING_FILES + file)
+typedef enum {
+  URING_CMDLINE,
+  URING_STAT,
+  URING_SCHEDSTAT,
+  URING_STATM,
+  URING_IO,
+  URING_FILES
+} uring_file_t;
+
+// Raw io_uring instance batching /proc reads (no liburing)
+typedef struct {
+  int fd;                     // Ring descriptor (-1 = not set up)
+  void *sq_ring;              // Submission ring mapping
+  void *cq_ring;              // Completion ring mapping (may alias sq_ring)
+  void *sqes;                 // Submission queue entries mapping
+  size_t sq_ring_sz;
+  size_t cq_ring_sz;
+  size_t sqes_sz;
+  unsigned *sq_head, *sq_tail, *sq_mask, *sq_array;
+  unsigned *cq_head, *cq_tail, *cq_mask;
+  void *cqes;
+  unsigned sq_entries;
+  unsigned queued;            // SQEs filled since the last submission
+  size_t nslots;              // File reads per submission
+  char *bufs;                 // nslots * URING_SLOT_SIZE read buffers
+  char (*paths)[URING_PATH_LEN]; // Path of each slot (kept until submitted)
+  int fixed_bufs;             // bufs are registered (READ_FIXED)
+  uint64_t enters;            // io_uring_enter() calls so far
+} uring_t;
+
+// Called for each completed read: slot, bytes read (or -errno) and the buffer
+typedef void (*uring_read_fn)(void *ctx, size_t slot, int res, char *buf);
+
 // Process list container
 typedef struct {
   proc_info_t *procs;
   size_t count;
   size_t capacity;
+
+  cpu_acct_t acct;        // Accounting backend used by parse_procs()
+  int children;           // Charge the CPU time of reaped children to their parents
+  uint64_t sample_ns;     // CLOCK_MONOTONIC time of the scan
+  uint32_t sources;       // SRC_* files read by parse_procs()
+  int stat_fields;        // Highest /proc/[pid]/stat field parsed
+  uring_t *uring;         // Batched reads, or NULL for plain read() (shared between lists)
+  watch_t *watch;         // Read only these processes, or NULL to walk /proc (shared)
+
+  proc_summary_t dropped; // Processes beyond the memory cap, not in procs
+  size_t unread;          // Processes listed but not read by a bounded scan
+  proc_carry_t *carry;    // Their CPU counters, by ascending PID (ncarry entries)
+  size_t ncarry;
+  size_t carry_cap;
+  size_t peak_count;      // Largest count while using under a quarter of the capacity
+  uint32_t low_ticks;     // Consecutive scans using under a quarter of the capacity
+
+  str_table_t *strtab;    // Table holding the cmd strings (shared between lists)
+  char *cmd_buf;          // Scratch buffer for reading cmdline (grows, never shrinks)
+  size_t cmd_buf_cap;
+
+  proc_info_t *sort_buf;  // Merge buffer of the incremental sort (sort_cap records)
+  int32_t *sort_index;    // PID hash -> record index (2 * sort_cap slots, power of two)
+  uint8_t *sort_placed;   // Records already carried over from the previous order
+  size_t sort_cap;
+  size_t sort_index_mask;
+
+  uint32_t *pid_order;    // Record indices by ascending PID (pid_cap entries)
+  uint32_t *pid_tmp;      // Radix sort scratch (pid_cap entries)
+  size_t pid_cap;
 } proc_list_t;
 
+// A process that left between two scans
+typedef struct {
+  uint64_t pid;
+  uint64_t cpu_ticks;     // Final utime + stime (jiffies)
+  uint64_t run_ns;        // Final on-CPU time (ns, 0 without schedstat)
+  char cmd[EXIT_CMD_LEN]; // Command line, truncated
+} proc_exit_t;
+
+// Births and deaths between consecutive scans
+typedef struct {
+  uint64_t births;        // PIDs in this scan and not the previous one
+  uint64_t deaths;        // PIDs in the previous scan and not this one
+  uint64_t forks;         // clone() calls in the interval ("processes" of /proc/stat)
+  uint64_t total_exits;   // Deaths seen since start
+  proc_exit_t exits[EXIT_RING_LEN]; // Ring of the most recent departures
+  uint32_t exit_head;     // Next write position in exits
+  uint32_t exit_count;    // Valid entries in exits (<= EXIT_RING_LEN)
+} lifecycle_t;
+
+// Proportional memory accounting from /proc/[pid]/smaps_rollup
+typedef struct {
+  uint64_t pss;           // Pss: Proportional set size (kB)
+  uint64_t uss;           // Private_Clean + Private_Dirty + Private_Hugetlb (kB)
+  uint64_t swap;          // Swap: Swapped-out anonymous memory (kB)
+} smaps_info_t;
+
+// Series of a process history drawn as a sparkline
+typedef enum {
+  SPARK_CPU,              // CPU%, against one full core
+  SPARK_RSS,              // Resident set size, against its peak in the window
+} spark_series_t;
+
+// Per-process sample history (one slab slot per tracked process)
+typedef struct {
+  uint64_t pid;                // Owner PID
+  uint64_t starttime;          // Owner start time, distinguishes PID reuse
+  uint64_t seen_tick;          // Last tick in which the owner was observed
+  float    cpu[HISTORY_LEN];   // Ring of CPU usage percentages
+  uint64_t rss[HISTORY_LEN];   // Ring of resident set sizes (pages)
+  smaps_info_t smaps;          // Cached smaps_rollup values
+  uint64_t smaps_tick;         // Tick of the last smaps_rollup read (0 = never)
+  int32_t  smaps_valid;        // Non-zero if the last read succeeded
+  uint64_t vcsw;               // voluntary_ctxt_switches at the last status read
+  uint64_t nvcsw;              // nonvoluntary_ctxt_switches at the last status read
+  uint64_t csw_ns;             // Monotonic time of the last status read (0 = never)
+  float    vcsw_rate;          // Voluntary context switches per second
+  float    nvcsw_rate;         // Involuntary context switches per second
+  int32_t  csw_valid;          // Non-zero once two reads gave the rates
+  uint32_t head;               // Next write position in the rings
+  uint32_t len;                // Number of valid samples (<= HISTORY_LEN)
+  int32_t  pidfd;              // pidfd_open() handle of the owner (-1 = none)
+  int32_t  next_free;          // Free-list link while the slot is unused
+  int32_t  in_use;             // Non-zero while owned by a live process
+} track_entry_t;
+
+// Bounded per-process tracking table
+typedef struct {
+  track_entry_t *slab;         // Preallocated pool of max_entries slots
+  int32_t *index;              // Open-addressing table: PID -> slab slot (-1 = empty)
+  size_t index_mask;           // Index table size - 1 (power of two)
+  size_t max_entries;          // Upper bound on tracked processes
+  size_t used;                 // Slots currently owned by processes
+  int32_t free_head;           // Head of the free-slot list (-1 = exhausted)
+  uint64_t tick;               // Update counter, used to detect exited processes
+  size_t pidfd_count;          // pidfds currently held by slots
+  size_t pidfd_max;            // Cap on held pidfds (0 = pidfd_open() unusable)
+} proc_track_t;
+
+// Shared-memory snapshot segment (collector or viewer side)
+typedef struct {
+  int fd;                 // shm_open() descriptor (-1 = closed)
+  void *base;             // Mapping of the whole segment
+  size_t map_size;        // Bytes currently mapped
+  int writer;             // Non-zero on the collector side
+  char name[64];          // POSIX shm object name
+  uint64_t last_tick;     // Viewer: last snapshot consumed
+  uint64_t publish_tick;  // Collector: snapshots published so far
+
+  // Collector: offset of each command string written in this snapshot,
+  // indexed by string table handle, so shared strings are stored once
+  uint64_t *str_tick;     // Snapshot in which the string was last written
+  uint64_t *str_off;      // Offset of the string in the string area
+  size_t str_slots;
+} shm_snapshot_t;
+
+// Pressure Stall Information resources (/proc/pressure/*)
+typedef enum {
+  PSI_CPU,
+  PSI_MEMORY,
+  PSI_IO,
+  PSI_COUNT
+} psi_kind_t;
+
+// One "some" or "full" line of a PSI file
+typedef struct {
+  double avg10;           // Stall share over the last 10s (%)
+  double avg60;           // Stall share over the last 60s (%)
+  double avg300;          // Stall share over the last 300s (%)
+  uint64_t total;         // Cumulative stall time (us)
+} psi_line_t;
+
+// Pressure of one resource
+typedef struct {
+  psi_line_t some;        // At least one task stalled
+  psi_line_t full;        // All non-idle tasks stalled (absent for cpu on old kernels)
+  uint64_t some_delta;    // Stall time since the previous sample (us)
+  uint64_t full_delta;
+  int has_full;
+  int sampled;            // Non-zero once a sample was taken
+} psi_resource_t;
+
+// PSI panel state
+typedef struct {
+  int fd[PSI_COUNT];            // Persistent read descriptors (-1 = unavailable)
+  int trigger_fd[PSI_COUNT];    // Registered poll triggers (-1 = none)
+  psi_resource_t res[PSI_COUNT];
+  uint64_t events[PSI_COUNT];   // Triggers fired so far
+  int available;                // Number of readable resources
+} psi_info_t;
+
+// Cumulative counters of a block device (/proc/diskstats)
+typedef struct {
+  uint64_t reads;            // Reads completed
+  uint64_t sectors_read;     // 512-byte sectors read
+  uint64_t read_ms;          // Time spent reading (ms)
+  uint64_t writes;           // Writes completed
+  uint64_t sectors_written;  // 512-byte sectors written
+  uint64_t write_ms;         // Time spent writing (ms)
+} disk_counters_t;
+
+// Block device throughput
+typedef struct {
+  char name[DEV_NAME_LEN];
+  disk_counters_t prev;      // Counters of the previous sample
+  disk_counters_t curr;      // Counters of the current sample
+  double read_mbs;           // Read throughput (MB/s)
+  double write_mbs;          // Write throughput (MB/s)
+  double iops;               // Completed reads + writes per second
+  double await_ms;           // Average time per completed request (ms)
+  uint64_t seen_tick;        // Last sample containing the device
+  int whole;                 // Non-zero for whole disks (not partitions/loop/ram)
+} disk_stat_t;
+
+// Cumulative counters of a network interface (/proc/net/dev)
+typedef struct {
+  uint64_t rx_bytes;
+  uint64_t rx_packets;
+  uint64_t tx_bytes;
+  uint64_t tx_packets;
+} net_counters_t;
+
+// Network interface throughput
+typedef struct {
+  char name[DEV_NAME_LEN];
+  net_counters_t prev;
+  net_counters_t curr;
+  double rx_mbs;             // Receive throughput (MB/s)
+  double tx_mbs;             // Transmit throughput (MB/s)
+  double rx_pps;             // Received packets per second
+  double tx_pps;             // Transmitted packets per second
+  uint64_t seen_tick;
+} net_stat_t;
+
+// Disk and network panel state (all storage preallocated)
+typedef struct {
+  int disk_fd;               // Persistent /proc/diskstats descriptor (-1 = none)
+  int net_fd;                // Persistent /proc/net/dev descriptor (-1 = none)
+  char *buf;                 // Read buffer, only grows when a file outgrows it
+  size_t buf_cap;
+  disk_stat_t disks[MAX_DISKS];
+  size_t ndisks;
+  net_stat_t nets[MAX_NETIFS];
+  size_t nnets;
+  uint64_t tick;             // Sample counter
+  uint64_t prev_ns;          // Monotonic time of the previous sample
+  double dt;                 // Seconds between the last two samples (0 = first)
+} iostat_t;
+
+// Batch output formats
+typedef enum {
+  FMT_JSON,               // One JSON object per tick and line (NDJSON)
+  FMT_CSV,                // RFC 4180 rows, "sys" and "proc" record types
+  FMT_TSV                 // Tab-separated rows, same columns as CSV
+} batch_format_t;
+
+// Buffered batch output writer
+typedef struct {
+  int fd;                 // Output descriptor
+  batch_format_t fmt;
+  char *buf;              // BATCH_BUF_SIZE bytes
+  size_t len;             // Bytes pending in buf
+  int header_done;        // CSV/TSV column header already written
+  int error;              // Non-zero after a failed write (e.g. EPIPE)
+  uint64_t pagesize;      // For RSS pages -> kB
+  uint64_t hz;            // For jiffies -> ms
+} batch_writer_t;
+
 // Sort status
 typedef enum {
     SORT_CPU,
@@ -87,4 +544,65 @@ typedef enum {
     SORT_PID
 } sort_mode_t;
 
+// Scroll position over the process table
+typedef struct {
+  size_t offset;          // Index of the first displayed row
+  size_t cursor;          // Index of the selected row
+  uint64_t selected_pid;  // Process under the cursor, followed across re-sorts (0 = none)
+  int window_only;        // Only rows [offset, offset + visible) are in order
+} proc_view_t;
+
+// One complete sample handed from the collector thread to the UI
+typedef struct {
+  proc_list_t *procs;     // Sorted processes (strings live in the collector's table)
+  mem_info_t mem;
+  double cpu_usage;
+  psi_info_t psi;         // Copy of the pressure panel state
+  iostat_t io;            // Copy of the disk/network rates (io.buf is not for the UI)
+  int io_ok;              // Non-zero if io holds samples
+  lifecycle_t lc;         // Births, deaths and recent exits
+  float core_usage[MAX_CORES]; // Utilization of each core (%, negative if offline)
+  uint32_t ncores;        // Entries in core_usage
+  sort_mode_t sort_mode;  // Key procs are sorted by
+  uint64_t seq;           // Snapshots published before this one
+} snapshot_t;
+
+// Collector thread publishing snapshots through a triple buffer
+typedef struct {
+  pthread_t thread;
+  snapshot_t slots[SNAPSHOT_SLOTS];
+  _Atomic uint32_t middle;   // Slot handed over last, | SNAP_FRESH until taken
+  uint32_t back;             // Slot being filled (collector thread only)
+  uint32_t front;            // Slot on screen (UI thread only)
+  _Atomic int sort_mode;     // Sort key requested by the UI
+  _Atomic uint64_t sources;  // SRC_* | stat fields << 32 needed by the UI
+  _Atomic int stop;          // Set by the UI to end the thread
+  int wake_fd;               // eventfd, UI -> collector: stop or collect now
+  int notify_fd;             // eventfd, collector -> UI: a snapshot is ready
+
+  // Collector thread only
+  str_table_t *strtab;       // Command lines of every list (read-only for the UI)
+  proc_list_t *prev;
+  proc_list_t *curr;
+  cpu_stat_t prev_cpu;
+  int meminfo_fd;
+  psi_info_t psi;
+  iostat_t io;
+  int io_ok;
+  lifecycle_t lc;
+  float core_usage[MAX_CORES];
+  uint32_t ncores;
+  uring_t uring;             // Batched /proc reads (fd -1 = read() fallback)
+  int use_uring;             // Read through uring when scanning locally (also after a fallback)
+  uint64_t max_memory;       // Budget of the process lists in bytes (0 = unbounded)
+  uint32_t sample_slices;    // Re-read 1/N of the processes per scan (0 = all)
+  uint64_t scans;            // Local scans taken, selects the slice
+  watch_t *watch;            // Processes followed instead of /proc (NULL = all)
+  shm_snapshot_t shm;
+  int shm_attached;          // Reading a running collector instead of /proc
+  uint64_t interval_ms;
+  uint64_t seq;
+  int running;               // Non-zero once the thread was started
+} pipeline_t;
+
 #endif // !MYTOP_TYPES_H
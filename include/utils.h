@@ -37,6 +37,10 @@ const char *skip_spaces(const char *p);
 bool is_numeric_name(const char *name);
 // Convert a numeric string to a numeric type (e.g., int, unsigned long)
 mytop_status_t str_to_num(const char *s, int base, numtype_t type, void *out);
+// Parse a signal name ("TERM", "SIGKILL") or number.
+int parse_signal(const char *s);
+// Name of a signal without the "SIG" prefix.
+const char *signal_name(int sig);
 
 /* --------- Formatting & Conversion Utilities --------- */
 
@@ -47,15 +51,21 @@ void format_time_hms(char *out, size_t out_sz, uint64_t jiffies, long hz);
 // Perform computer storage unit conversion.
 double mem_uint_convert(uint64_t value, mem_uint_t from, mem_uint_t to);
 
-/* --------- Terminal Control & UI Utilities --------- */
+// Current CLOCK_MONOTONIC time in nanoseconds.
+uint64_t monotonic_ns(void);
+uint64_t boottime_ns(void);
 // Get the count of cores.
 long get_core_count();
+
+/* --------- Terminal Control & UI Utilities (term.c) --------- */
 // Get the current terminal column width and row.
 void get_term_size(int *rows, int *cols);
 // Enable/disable raw mode (Raw Mode)
 int set_raw_mode(bool enable);
 // Read one line of input in Raw Mode (blocking)
 int term_read_line(char *buf, size_t maxlen);
+// Feed one key to a line being edited (non-blocking)
+int term_edit_line(char *buf, size_t *len, size_t maxlen, int c);
 // Check for key input (non-blocking)
 bool kbhit();
 // Clear screen.
@@ -0,0 +1,444 @@
+#include "log.h"
+#include "mytop.h"
+#include "mytop_types.h"
+#include "utils.h"
+#include <errno.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+// Worst case of one number or escaped byte, so appends reserve once
+#define NUM_MAX 24
+
+static const char csv_header[] =
+  "ts_ms,type,pid,ppid,pgrp,state,cpu,delay,virt_kb,res_kb,utime_ms,stime_ms,command\n";
+
+/**
+ * Helper function
+ *
+ * @brief Make room for n more bytes, flushing the buffer when full.
+ */
+static inline void reserve(batch_writer_t *w, size_t n) {
+  if (w->len + n > BATCH_BUF_SIZE)
+    batch_flush(w);
+}
+
+/**
+ * Helper function
+ *
+ * @brief Append raw bytes (which may exceed the buffer size).
+ */
+static void put_bytes(batch_writer_t *w, const char *s, size_t n) {
+  while (n > 0) {
+    reserve(w, 1);
+    size_t room = BATCH_BUF_SIZE - w->len;
+    size_t chunk = n < room ? n : room;
+    memcpy(w->buf + w->len, s, chunk);
+    w->len += chunk;
+    s += chunk;
+    n -= chunk;
+  }
+}
+
+static inline void put_char(batch_writer_t *w, char c) {
+  reserve(w, 1);
+  w->buf[w->len ++] = c;
+}
+
+#define put_lit(w, s) put_bytes(w, s, sizeof(s) - 1)
+
+/**
+ * Helper function
+ *
+ * @brief Append an unsigned decimal number without printf.
+ */
+static void put_u64(batch_writer_t *w, uint64_t v) {
+  char tmp[20];
+  size_t n = 0;
+  do {
+    tmp[n ++] = (char)('0' + v % 10);
+    v /= 10;
+  } while (v != 0);
+
+  reserve(w, n);
+  while (n > 0)
+    w->buf[w->len ++] = tmp[-- n];
+}
+
+/**
+ * Helper function
+ *
+ * @brief Append a non-negative value with two decimals ("12.34").
+ */
+static void put_fixed2(batch_writer_t *w, double v) {
+  if (!(v > 0)) v = 0;   // Also catches NaN
+  if (v > 1e15) v = 1e15;
+
+  uint64_t hundredths = (uint64_t)(v * 100.0 + 0.5);
+  put_u64(w, hundredths / 100);
+
+  reserve(w, 3);
+  w->buf[w->len ++] = '.';
+  w->buf[w->len ++] = (char)('0' + hundredths / 10 % 10);
+  w->buf[w->len ++] = (char)('0' + hundredths % 10);
+}
+
+/**
+ * Helper function
+ *
+ * @brief Length of the valid UTF-8 sequence at s, or 0 if invalid.
+ */
+static size_t utf8_seq_len(const unsigned char *s, size_t n) {
+  size_t len;
+  uint32_t min;
+  if (s[0] < 0x80)              return 1;
+  else if ((s[0] & 0xe0) == 0xc0) { len = 2; min = 0x80; }
+  else if ((s[0] & 0xf0) == 0xe0) { len = 3; min = 0x800; }
+  else if ((s[0] & 0xf8) == 0xf0) { len = 4; min = 0x10000; }
+  else                          return 0;
+
+  if (len > n)
+    return 0;
+
+  uint32_t cp = s[0] & (0x7f >> len);
+  for (size_t i = 1; i < len; ++ i) {
+    if ((s[i] & 0xc0) != 0x80)
+      return 0;
+    cp = (cp << 6) | (s[i] & 0x3f);
+  }
+
+  // Overlong encodings, surrogates and out-of-range code points
+  if (cp < min || cp > 0x10ffff || (cp >= 0xd800 && cp <= 0xdfff))
+    return 0;
+
+  return len;
+}
+
+/**
+ * Helper function
+ *
+ * @brief Append a JSON string literal.
+ *
+ * Command lines are arbitrary bytes, so control characters are escaped
+ * and invalid UTF-8 is replaced with U+FFFD to keep the stream valid.
+ */
+static void put_json_str(batch_writer_t *w, const char *s, size_t n) {
+  static const char hex[] = "0123456789abcdef";
+  const unsigned char *p = (const unsigned char *)s;
+
+  put_char(w, '"');
+  size_t run = 0;   // Start of the pending run of bytes copied verbatim
+  size_t i = 0;
+  while (i < n) {
+    unsigned char c = p[i];
+    if (c >= 0x20 && c != '"' && c != '\\' && c < 0x80) {
+      i ++;
+      continue;
+    }
+
+    size_t seq = c >= 0x80 ? utf8_seq_len(p + i, n - i) : 0;
+    if (seq > 0) {
+      i += seq;
+      continue;
+    }
+
+    put_bytes(w, s + run, i - run);
+    reserve(w, NUM_MAX);
+    if (c == '"' || c == '\\') {
+      w->buf[w->len ++] = '\\';
+      w->buf[w->len ++] = (char)c;
+    } else if (c < 0x20) {
+      memcpy(w->buf + w->len, "\\u00", 4);
+      w->len += 4;
+      w->buf[w->len ++] = hex[c >> 4];
+      w->buf[w->len ++] = hex[c & 0xf];
+    } else {
+      memcpy(w->buf + w->len, "\\ufffd", 6);
+      w->len += 6;
+    }
+    run = ++ i;
+  }
+  put_bytes(w, s + run, n - run);
+  put_char(w, '"');
+}
+
+/**
+ * Helper function
+ *
+ * @brief Append a CSV field, quoted only when it has to be.
+ */
+static void put_csv_str(batch_writer_t *w, const char *s, size_t n) {
+  if (strcspn(s, ",\"\r\n") >= n) {
+    put_bytes(w, s, n);
+    return;
+  }
+
+  put_char(w, '"');
+  size_t run = 0;
+  for (size_t i = 0; i < n; ++ i) {
+    if (s[i] == '"') {
+      put_bytes(w, s + run, i + 1 - run);
+      run = i;   // The quote is written again, doubling it
+    }
+  }
+  put_bytes(w, s + run, n - run);
+  put_char(w, '"');
+}
+
+/**
+ * Helper function
+ *
+ * @brief Append a TSV field; TSV has no quoting, so tabs and line
+ *        breaks are replaced with spaces.
+ */
+static void put_tsv_str(batch_writer_t *w, const char *s, size_t n) {
+  size_t run = 0;
+  for (size_t i = 0; i < n; ++ i) {
+    if (s[i] == '\t' || s[i] == '\n' || s[i] == '\r') {
+      put_bytes(w, s + run, i - run);
+      put_char(w, ' ');
+      run = i + 1;
+    }
+  }
+  put_bytes(w, s + run, n - run);
+}
+
+/**
+ * @brief Prepare a batch writer on fd.
+ */
+mytop_status_t batch_writer_open(batch_writer_t *w, int fd, batch_format_t fmt) {
+  // Check input parameters
+  if (!w || fd < 0)
+    return MYTOP_ERR_PARAM;
+
+  memset(w, 0, sizeof(*w));
+  w->buf = malloc(BATCH_BUF_SIZE);
+  if (!w->buf)
+    return MYTOP_ERR_NOMEM;
+
+  w->fd = fd;
+  w->fmt = fmt;
+
+  long pagesize = sysconf(_SC_PAGESIZE);
+  long hz = sysconf(_SC_CLK_TCK);
+  w->pagesize = pagesize > 0 ? (uint64_t)pagesize : 4096u;
+  w->hz = hz > 0 ? (uint64_t)hz : 100u;
+
+  return MYTOP_OK;
+}
+
+/**
+ * @brief Write out everything buffered so far.
+ *
+ * @return MYTOP_OK, or MYTOP_ERR_IO once the reader has gone away.
+ */
+mytop_status_t batch_flush(batch_writer_t *w) {
+  if (!w)
+    return MYTOP_ERR_PARAM;
+
+  size_t off = 0;
+  while (off < w->len && !w->error) {
+    ssize_t n = write(w->fd, w->buf + off, w->len - off);
+    if (n < 0) {
+      if (errno == EINTR)
+        continue;
+      w->error = errno;
+      break;
+    }
+    off += (size_t)n;
+  }
+
+  // Output is dropped after an error so callers need not check every append
+  w->len = 0;
+
+  return w->error ? MYTOP_ERR_IO : MYTOP_OK;
+}
+
+/**
+ * @brief Flush pending output and free the buffer.
+ */
+void batch_writer_close(batch_writer_t *w) {
+  if (!w || !w->buf)
+    return;
+
+  batch_flush(w);
+  free(w->buf);
+  w->buf = NULL;
+}
+
+/**
+ * Helper function
+ *
+ * @brief Write one tick as a JSON object on a single line:
+ *
+ * {"ts_ms":...,"cpu":1.23,"mem":{...},"procs":[{"pid":1,...},...]}
+ */
+static void write_json(batch_writer_t *w, uint64_t ts_ms, const mem_info_t *mem,
+                       double cpu_usage, const proc_list_t *list, size_t limit) {
+  put_lit(w, "{\"ts_ms\":");
+  put_u64(w, ts_ms);
+  put_lit(w, ",\"cpu\":");
+  put_fixed2(w, cpu_usage);
+  put_lit(w, ",\"mem\":{\"total_kb\":");
+  put_u64(w, mem->total);
+  put_lit(w, ",\"used_kb\":");
+  put_u64(w, mem->used);
+  put_lit(w, ",\"available_kb\":");
+  put_u64(w, mem->available);
+  put_lit(w, ",\"buff_cache_kb\":");
+  put_u64(w, mem->buff_cache);
+  put_lit(w, ",\"swap_total_kb\":");
+  put_u64(w, mem->swap_total);
+  put_lit(w, ",\"swap_used_kb\":");
+  put_u64(w, mem->swap_used);
+  put_lit(w, "},\"count\":");
+  put_u64(w, list->count);
+  put_lit(w, ",\"procs\":[");
+
+  for (size_t i = 0; i < limit; ++ i) {
+    const proc_info_t *p = &list->procs[i];
+    if (i > 0) put_char(w, ',');
+    put_lit(w, "{\"pid\":");
+    put_u64(w, p->pid);
+    put_lit(w, ",\"ppid\":");
+    put_u64(w, p->ppid);
+    put_lit(w, ",\"pgrp\":");
+    put_u64(w, p->pgrp);
+    put_lit(w, ",\"state\":\"");
+    put_char(w, p->state >= 0x20 && p->state < 0x7f && p->state != '"' && p->state != '\\' ?
+                p->state : '?');
+    put_lit(w, "\",\"cpu\":");
+    put_fixed2(w, p->cpu_percent);
+    if (p->stale)
+      put_lit(w, ",\"stale\":true");
+    if (p->has_schedstat) {
+      put_lit(w, ",\"delay\":");
+      put_fixed2(w, p->delay_percent);
+    }
+    put_lit(w, ",\"virt_kb\":");
+    put_u64(w, p->vsize / 1024);
+    put_lit(w, ",\"res_kb\":");
+    put_u64(w, pages_to_kb(p->rss, w->pagesize));
+    put_lit(w, ",\"utime_ms\":");
+    put_u64(w, p->utime * 1000 / w->hz);
+    put_lit(w, ",\"stime_ms\":");
+    put_u64(w, p->stime * 1000 / w->hz);
+    put_lit(w, ",\"command\":");
+    put_json_str(w, strtab_get(list->strtab, p->cmd), strtab_len(list->strtab, p->cmd));
+    put_char(w, '}');
+  }
+
+  put_lit(w, "]}\n");
+}
+
+/**
+ * Helper function
+ *
+ * @brief Write one tick as CSV/TSV rows: a "sys" row (cpu = total CPU
+ *        usage, virt_kb = MemTotal, res_kb = used) and one "proc" row
+ *        per process.
+ */
+static void write_rows(batch_writer_t *w, uint64_t ts_ms, const mem_info_t *mem,
+                       double cpu_usage, const proc_list_t *list, size_t limit) {
+  const char sep = w->fmt == FMT_TSV ? '\t' : ',';
+
+  if (!w->header_done) {
+    if (sep == ',') {
+      put_lit(w, csv_header);
+    } else {
+      for (const char *c = csv_header; *c; ++ c)
+        put_char(w, *c == ',' ? '\t' : *c);
+    }
+    w->header_done = 1;
+  }
+
+  // ts,sys,,,,,cpu,,total,used,,,
+  put_u64(w, ts_ms);
+  put_char(w, sep);
+  put_lit(w, "sys");
+  for (int i = 0; i < 4; ++ i) put_char(w, sep);
+  put_char(w, sep);
+  put_fixed2(w, cpu_usage);
+  put_char(w, sep);
+  put_char(w, sep);
+  put_u64(w, mem->total);
+  put_char(w, sep);
+  put_u64(w, mem->used);
+  for (int i = 0; i < 3; ++ i) put_char(w, sep);
+  put_char(w, '\n');
+
+  for (size_t i = 0; i < limit; ++ i) {
+    const proc_info_t *p = &list->procs[i];
+    put_u64(w, ts_ms);
+    put_char(w, sep);
+    put_lit(w, "proc");
+    put_char(w, sep);
+    put_u64(w, p->pid);
+    put_char(w, sep);
+    put_u64(w, p->ppid);
+    put_char(w, sep);
+    put_u64(w, p->pgrp);
+    put_char(w, sep);
+    put_char(w, p->state > 0x20 && p->state < 0x7f && p->state != ',' && p->state != '"' ?
+                p->state : '?');
+    put_char(w, sep);
+    put_fixed2(w, p->cpu_percent);
+    put_char(w, sep);
+    if (p->has_schedstat)
+      put_fixed2(w, p->delay_percent);
+    put_char(w, sep);
+    put_u64(w, p->vsize / 1024);
+    put_char(w, sep);
+    put_u64(w, pages_to_kb(p->rss, w->pagesize));
+    put_char(w, sep);
+    put_u64(w, p->utime * 1000 / w->hz);
+    put_char(w, sep);
+    put_u64(w, p->stime * 1000 / w->hz);
+    put_char(w, sep);
+
+    const char *cmd = strtab_get(list->strtab, p->cmd);
+    size_t cmd_len = strtab_len(list->strtab, p->cmd);
+    if (sep == ',')
+      put_csv_str(w, cmd, cmd_len);
+    else
+      put_tsv_str(w, cmd, cmd_len);
+    put_char(w, '\n');
+  }
+}
+
+/**
+ * @brief Stream one tick of system and process records.
+ *
+ * Everything goes through the writer buffer with hand-written number
+ * formatting; the buffer is flushed once per tick so consumers see
+ * whole records in time.
+ *
+ * @param w         Batch writer.
+ * @param mem       Memory snapshot.
+ * @param cpu_usage Total CPU usage (%).
+ * @param list      Process list, in output order.
+ * @param limit     Number of processes to write from the top of list.
+ *
+ * @return MYTOP_OK, or MYTOP_ERR_IO if the output is gone.
+ */
+mytop_status_t batch_write_tick(batch_writer_t *w, const mem_info_t *mem, double cpu_usage,
+                                const proc_list_t *list, size_t limit) {
+  // Check input parameters
+  if (!w || !w->buf || !mem || !list)
+    return MYTOP_ERR_PARAM;
+
+  if (limit > list->count) limit = list->count;
+
+  struct timespec ts;
+  clock_gettime(CLOCK_REALTIME, &ts);
+  uint64_t ts_ms = (uint64_t)ts.tv_sec * 1000 + (uint64_t)ts.tv_nsec / 1000000;
+
+  if (w->fmt == FMT_JSON)
+    write_json(w, ts_ms, mem, cpu_usage, list, limit);
+  else
+    write_rows(w, ts_ms, mem, cpu_usage, list, limit);
+
+  return batch_flush(w);
+}
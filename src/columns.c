@@ -0,0 +1,381 @@
+#include "mytop.h"
+#include "mytop_types.h"
+#include "utils.h"
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <strings.h>
+#include <unistd.h>
+
+// Values shared by the cells of one row
+typedef struct {
+  const proc_list_t *list;
+  const proc_info_t *p;
+  const track_entry_t *e;   // History and visible-row caches (may be NULL)
+  long hz;
+  uint64_t pagesize;
+} cell_ctx_t;
+
+typedef void (*cell_fn)(const cell_ctx_t *c, int width);
+
+// One column of the process table
+typedef struct {
+  const char *name;       // Header, and name accepted by --columns
+  int width;              // Cell width (COMMAND: minimum, it takes the rest of the line)
+  int stat_field;         // Highest /proc/[pid]/stat field the cell shows (0 = none)
+  uint32_t sources;       // Other SRC_* files the cell needs
+  int sort;               // sort_mode_t ordering by this column (-1 = none)
+  int left;               // Left-aligned
+  int schedstat_only;     // Only meaningful with ACCT_SCHEDSTAT
+  cell_fn print;
+} column_t;
+
+/**
+ * Helper function
+ *
+ * @brief Print a placeholder for a value that was not measured.
+ */
+static void cell_missing(int width) {
+  printf("%*s", width, "-");
+}
+
+static void cell_pid(const cell_ctx_t *c, int w)   { printf("%*" PRIu64, w, c->p->pid); }
+static void cell_state(const cell_ctx_t *c, int w) { printf("%*c", w, c->p->state); }
+static void cell_ppid(const cell_ctx_t *c, int w)  { printf("%*" PRIu64, w, c->p->ppid); }
+static void cell_pgrp(const cell_ctx_t *c, int w)  { printf("%*" PRIu64, w, c->p->pgrp); }
+static void cell_processor(const cell_ctx_t *c, int w) {
+  if (c->p->processor >= 0) printf("%*d", w, c->p->processor);
+  else cell_missing(w);
+}
+
+static void cell_migrate(const cell_ctx_t *c, int w) { printf("%*.1f", w, c->p->migrate_rate); }
+// A stale value (sampled scan) ends in '~' instead of '%'
+static void cell_cpu(const cell_ctx_t *c, int w) {
+  printf("%*.2f%c", w - 1, c->p->cpu_percent, c->p->stale ? '~' : '%');
+}
+
+static void cell_delay(const cell_ctx_t *c, int w) {
+  if (c->p->has_schedstat)
+    printf("%*.2f%%", w - 1, c->p->delay_percent);
+  else
+    cell_missing(w);
+}
+
+static void cell_virt(const cell_ctx_t *c, int w) {
+  uint64_t virt_kb = mem_uint_convert(c->p->vsize, MEM_B, MEM_KIB);
+  printf("%*" PRIu64, w, virt_kb);
+}
+
+static void cell_res(const cell_ctx_t *c, int w) {
+  printf("%*" PRIu64, w, pages_to_kb(c->p->rss, c->pagesize));
+}
+
+static void cell_shr(const cell_ctx_t *c, int w) {
+  printf("%*" PRIu64, w, pages_to_kb(c->p->shared, c->pagesize));
+}
+
+// Not read yet (or not readable): leave the cells blank
+static void cell_pss(const cell_ctx_t *c, int w) {
+  if (c->e && c->e->smaps_valid) printf("%*" PRIu64, w, c->e->smaps.pss);
+  else cell_missing(w);
+}
+
+static void cell_uss(const cell_ctx_t *c, int w) {
+  if (c->e && c->e->smaps_valid) printf("%*" PRIu64, w, c->e->smaps.uss);
+  else cell_missing(w);
+}
+
+static void cell_swap(const cell_ctx_t *c, int w) {
+  if (c->e && c->e->smaps_valid) printf("%*" PRIu64, w, c->e->smaps.swap);
+  else cell_missing(w);
+}
+
+static void cell_minflt(const cell_ctx_t *c, int w) { printf("%*.0f", w, c->p->minflt_rate); }
+static void cell_majflt(const cell_ctx_t *c, int w) { printf("%*.0f", w, c->p->majflt_rate); }
+static void cell_iod(const cell_ctx_t *c, int w)    { printf("%*.1f%%", w - 1, c->p->iodelay_percent); }
+
+static void cell_rkb(const cell_ctx_t *c, int w) {
+  if (c->p->has_io) printf("%*.0f", w, c->p->read_rate / 1024);
+  else cell_missing(w);
+}
+
+static void cell_wkb(const cell_ctx_t *c, int w) {
+  if (c->p->has_io) printf("%*.0f", w, c->p->write_rate / 1024);
+  else cell_missing(w);
+}
+
+// Switch rates need two status reads of a visible row
+static void cell_vcsw(const cell_ctx_t *c, int w) {
+  if (c->e && c->e->csw_valid) printf("%*.0f", w, c->e->vcsw_rate);
+  else cell_missing(w);
+}
+
+static void cell_ivcsw(const cell_ctx_t *c, int w) {
+  if (c->e && c->e->csw_valid) printf("%*.0f", w, c->e->nvcsw_rate);
+  else cell_missing(w);
+}
+
+static void cell_time(const cell_ctx_t *c, int w) {
+  char timebuf[16];
+  format_time_hms(timebuf, sizeof(timebuf), c->p->utime + c->p->stime, c->hz);
+  printf("%*s", w, timebuf);
+}
+
+static void cell_history(const cell_ctx_t *c, int w) {
+  (void)w;
+  // Always HISTORY_LEN terminal columns
+  char sparkbuf[HISTORY_LEN * 4 + 1];
+  track_format_sparkline(c->e, SPARK_CPU, sparkbuf, sizeof(sparkbuf));
+  printf("%s", sparkbuf);
+}
+
+static void cell_rss_history(const cell_ctx_t *c, int w) {
+  (void)w;
+  char sparkbuf[HISTORY_LEN * 4 + 1];
+  track_format_sparkline(c->e, SPARK_RSS, sparkbuf, sizeof(sparkbuf));
+  printf("%s", sparkbuf);
+}
+
+static void cell_command(const cell_ctx_t *c, int w) {
+  printf("%-.*s", w, strtab_get(c->list->strtab, c->p->cmd));
+}
+
+// Registry, in display order. CPU time needs stat fields 14-15 and the
+// identity checks field 22, which every scan parses (STAT_MIN_FIELD).
+static const column_t columns[] = {
+  {"PID",      6, 0,  0,             SORT_PID, 0, 0, cell_pid},
+  {"S",        1, 3,  0,             -1,       0, 0, cell_state},
+  {"PPID",     6, 4,  0,             -1,       0, 0, cell_ppid},
+  {"PGRP",     6, 5,  0,             -1,       0, 0, cell_pgrp},
+  {"P",        3, 39, 0,             -1,       0, 0, cell_processor},
+  {"MIG/s",    5, 39, 0,             -1,       0, 0, cell_migrate},
+  {"CPU",      8, 15, SRC_SCHEDSTAT, SORT_CPU, 0, 0, cell_cpu},
+  {"DELAY",    8, 0,  SRC_SCHEDSTAT, -1,       0, 1, cell_delay},
+  {"VIRT",     8, 23, 0,             -1,       0, 0, cell_virt},
+  {"RES",      8, 24, 0,             SORT_MEM, 0, 0, cell_res},
+  {"SHR",      8, 0,  SRC_STATM,     -1,       0, 0, cell_shr},
+  {"PSS",      8, 0,  SRC_SMAPS,     -1,       0, 0, cell_pss},
+  {"USS",      8, 0,  SRC_SMAPS,     -1,       0, 0, cell_uss},
+  {"SWAP",     8, 0,  SRC_SMAPS,     -1,       0, 0, cell_swap},
+  {"MINF/s",   7, 10, 0,             -1,       0, 0, cell_minflt},
+  {"MAJF/s",   7, 12, 0,             -1,       0, 0, cell_majflt},
+  {"IOD",      6, 42, 0,             -1,       0, 0, cell_iod},
+  {"RKB/s",    8, 0,  SRC_IO,        -1,       0, 0, cell_rkb},
+  {"WKB/s",    8, 0,  SRC_IO,        -1,       0, 0, cell_wkb},
+  {"VCSW/s",   7, 0,  SRC_STATUS,    -1,       0, 0, cell_vcsw},
+  {"IVCSW/s",  7, 0,  SRC_STATUS,    -1,       0, 0, cell_ivcsw},
+  {"TIME+",   10, 15, 0,             -1,       0, 0, cell_time},
+  {"HISTORY", HISTORY_LEN, 15, SRC_SCHEDSTAT, -1, 1, 0, cell_history},
+  {"RSSHIST", HISTORY_LEN, 24, 0,            -1, 1, 0, cell_rss_history},
+  {"COMMAND", 10, 0,  SRC_CMDLINE,   -1,       1, 0, cell_command},
+};
+
+#define NCOLUMNS    (sizeof(columns) / sizeof(columns[0]))
+#define COL_COMMAND (NCOLUMNS - 1)
+
+/**
+ * @brief Columns shown when none are picked.
+ */
+column_set_t columns_default(void) {
+  column_set_t set = 0;
+  const char *names[] = { "PID", "S", "PPID", "PGRP", "CPU", "DELAY",
+                          "VIRT", "RES", "TIME+", "HISTORY", "COMMAND" };
+
+  for (size_t i = 0; i < sizeof(names) / sizeof(names[0]); ++ i) {
+    for (size_t k = 0; k < NCOLUMNS; ++ k) {
+      if (strcmp(columns[k].name, names[i]) == 0)
+        set |= (column_set_t)1 << k;
+    }
+  }
+
+  return set;
+}
+
+/**
+ * @brief Apply a column list to a column set.
+ *
+ * Names are separated by commas or spaces and matched without regard
+ * to case; "default" stands for columns_default(). A list whose first
+ * name starts with '+' or '-' edits *set ("+PSS,-PGRP"), otherwise it
+ * replaces it ("pid,cpu,command").
+ *
+ * @param spec Column list.
+ * @param set  Column set to update (unchanged on error). [in/out]
+ * @param bad  Set to the first unknown name on MYTOP_ERR_PARSE (may be NULL).
+ *
+ * @return
+ *  - MYTOP_OK on success.
+ *  - MYTOP_ERR_PARSE if a name is unknown.
+ *  - MYTOP_NO_DATA if no column would be left.
+ */
+mytop_status_t columns_parse(const char *spec, column_set_t *set, const char **bad) {
+  // Check input parameters
+  if (!spec || !set)
+    return MYTOP_ERR_PARAM;
+
+  const char *seps = ", ";
+  const char *p = spec + strspn(spec, seps);
+  column_set_t result = (*p == '+' || *p == '-') ? *set : 0;
+
+  while (*p) {
+    char op = '+';
+    if (*p == '+' || *p == '-')
+      op = *p ++;
+
+    size_t len = strcspn(p, seps);
+    column_set_t bits = 0;
+    if (len == 7 && strncasecmp(p, "default", len) == 0) {
+      bits = columns_default();
+    } else {
+      for (size_t k = 0; k < NCOLUMNS; ++ k) {
+        if (strlen(columns[k].name) == len && strncasecmp(columns[k].name, p, len) == 0)
+          bits = (column_set_t)1 << k;
+      }
+    }
+
+    if (bits == 0) {
+      if (bad) *bad = p;
+      return MYTOP_ERR_PARSE;
+    }
+
+    result = op == '-' ? result & ~bits : result | bits;
+    p += len;
+    p += strspn(p, seps);
+  }
+
+  if (result == 0)
+    return MYTOP_NO_DATA;
+
+  *set = result;
+  return MYTOP_OK;
+}
+
+/**
+ * @brief Write the names of a column set as a comma-separated list.
+ */
+void columns_format(column_set_t set, char *out, size_t out_sz) {
+  if (!out || out_sz == 0)
+    return;
+
+  size_t len = 0;
+  out[0] = '\0';
+  for (size_t k = 0; k < NCOLUMNS; ++ k) {
+    if (!(set & ((column_set_t)1 << k)))
+      continue;
+    int n = snprintf(out + len, out_sz - len, "%s%s", len ? "," : "", columns[k].name);
+    if (n < 0 || (size_t)n >= out_sz - len)
+      break;
+    len += (size_t)n;
+  }
+}
+
+/**
+ * @brief Union of the data sources needed to show a column set sorted
+ *        by a key.
+ *
+ * @param set         Shown columns.
+ * @param sort        Sort key (the column declaring it is always read).
+ * @param stat_fields Highest /proc/[pid]/stat field needed. [out]
+ *
+ * @return SRC_* bits of the files to read.
+ */
+uint32_t columns_sources(column_set_t set, sort_mode_t sort, int *stat_fields) {
+  uint32_t sources = 0;
+  int fields = STAT_MIN_FIELD;
+
+  for (size_t k = 0; k < NCOLUMNS; ++ k) {
+    const column_t *col = &columns[k];
+    if (!(set & ((column_set_t)1 << k)) && col->sort != (int)sort)
+      continue;
+    sources |= col->sources;
+    if (col->stat_field > fields) fields = col->stat_field;
+  }
+
+  if (stat_fields) *stat_fields = fields;
+  return sources;
+}
+
+/**
+ * @brief Debug print: Output information of the window of processes.
+ *
+ * Only the rows of the window are formatted, and only the columns of
+ * the set; COMMAND takes what is left of the terminal width.
+ *
+ * @param list         Sorted process list.
+ * @param track        Per-process history used for the sparkline,
+ *                     smaps and context switch columns (may be NULL).
+ * @param set          Columns to show.
+ * @param header_lines Lines printed above the process table.
+ * @param view         Scroll state (NULL shows the top rows).
+ */
+void print_procs(const proc_list_t *list, const proc_track_t *track,
+                 column_set_t set, int header_lines, const proc_view_t *view) {
+  if (!list)
+    return;
+
+  int cols;
+  // Get terminal width
+  get_term_size(NULL, &cols);
+
+  // Read system time unit and page size
+  const long hz = sysconf(_SC_CLK_TCK);
+  const long pagesize_l = sysconf(_SC_PAGESIZE);
+  // sysconf fails and returns -1
+  const uint64_t pagesize = (pagesize_l > 0) ? (uint64_t)pagesize_l : 4096u;
+
+  // Columns actually shown, and the width left for COMMAND
+  size_t shown[NCOLUMNS];
+  size_t nshown = 0;
+  int fixed_width = 0;
+  for (size_t k = 0; k < NCOLUMNS; ++ k) {
+    if (!(set & ((column_set_t)1 << k)))
+      continue;
+    // Run delay is only measured by the schedstat backend
+    if (columns[k].schedstat_only && list->acct != ACCT_SCHEDSTAT)
+      continue;
+    shown[nshown ++] = k;
+    if (k != COL_COMMAND)
+      fixed_width += columns[k].width + 1;
+  }
+
+  int cmd_width = cols - fixed_width - 1;
+  if (cmd_width < columns[COL_COMMAND].width) cmd_width = columns[COL_COMMAND].width;
+  if (cmd_width > 80) cmd_width = 80;
+
+  // Print table header
+  for (size_t i = 0; i < nshown; ++ i) {
+    const column_t *col = &columns[shown[i]];
+    if (i > 0)
+      putchar(' ');
+    if (i + 1 == nshown && col->left)
+      printf("%s", col->name);
+    else
+      printf(col->left ? "%-*s" : "%*s", col->width, col->name);
+  }
+  printf("\n");
+
+  size_t limit = procs_visible_count(list, header_lines);
+  size_t first = view ? view->offset : 0;
+  if (first > list->count) first = list->count;
+  if (limit > list->count - first) limit = list->count - first;
+
+  cell_ctx_t ctx = { .list = list, .hz = hz, .pagesize = pagesize };
+  for (size_t i = first; i < first + limit; i++) {
+    ctx.p = &list->procs[i];
+    ctx.e = track_lookup(track, ctx.p->pid);
+    // Reverse video on the selected row
+    bool selected = view && view->selected_pid == ctx.p->pid;
+    if (selected)
+      printf("\033[7m");
+
+    for (size_t j = 0; j < nshown; ++ j) {
+      const column_t *col = &columns[shown[j]];
+      col->print(&ctx, shown[j] == COL_COMMAND ? cmd_width : col->width);
+      if (j + 1 < nshown)
+        putchar(' ');
+    }
+    printf(selected ? "\033[K\033[0m\n" : "\n");
+  }
+}
@@ -1,16 +1,49 @@
 #include "log.h"
 #include "mytop.h"
+#include "utils.h"
+#include <ctype.h>
 #include <errno.h>
 #include <inttypes.h>
 #include <stdint.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 
+/**
+ * Helper function
+ *
+ * @brief Parse one "cpuN user nice system idle iowait irq softirq steal"
+ *        line (p points at N) into the per-core counters.
+ */
+static void parse_core_line(const char *p, cpu_stat_t *stat) {
+  char *end;
+  unsigned long core = strtoul(p, &end, 10);
+  if (end == p || core >= MAX_CORES)
+    return;
+
+  uint64_t v[8];
+  p = end;
+  for (int i = 0; i < 8; ++ i) {
+    errno = 0;
+    v[i] = strtoull(p, &end, 10);
+    if (end == p || errno == ERANGE)
+      return;
+    p = end;
+  }
+
+  // Same split as calculate_cpu_usage(): idle and iowait are idle time
+  stat->core_busy[core] = v[0] + v[1] + v[2] + v[5] + v[6] + v[7];
+  stat->core_total[core] = stat->core_busy[core] + v[3] + v[4];
+  if (core + 1 > stat->ncores)
+    stat->ncores = (uint32_t)core + 1;
+}
+
 /**
  * @brief Parse /proc/stat to obtain global CPU data.
  *
- * Only reads the first line (starting with "cpu "), 
- * filling the first 8 numerical values into the structure.
+ * Reads the first line (starting with "cpu "), filling the first 8
+ * numerical values into the structure, the "cpuN" lines of each core
+ * and the "processes" line (forks since boot).
  *
  * @param stat Stores the parsing result.
  *
@@ -66,6 +99,24 @@ mytop_status_t parse_cpu_stat(cpu_stat_t *stat) {
     }
   }
 
+  // Offline cores have no line
+  stat->ncores = 0;
+  memset(stat->core_busy, 0, sizeof(stat->core_busy));
+  memset(stat->core_total, 0, sizeof(stat->core_total));
+
+  // Per-CPU, interrupt and context switch lines come first
+  while (fgets(line, sizeof line, fp)) {
+    if (strncmp(line, "cpu", 3) == 0 && isdigit((unsigned char)line[3])) {
+      parse_core_line(line + 3, stat);
+      continue;
+    }
+    if (strncmp(line, "processes ", 10) == 0) {
+      sscanf(line + 10, "%" SCNu64, &stat->processes);
+      break;
+    }
+  }
+
+  fclose(fp);
   return MYTOP_OK;
 }
 
@@ -74,8 +125,7 @@ mytop_status_t parse_cpu_stat(cpu_stat_t *stat) {
  *
  * @param prev        Data from the previous sample.
  * @param curr        Data from the current sample.
- * @param total_delta Total CPU time interval, used for subsequent calculation
- *                    of process CPU usage percentage. [out]
+ * @param total_delta Total CPU time interval (jiffies, all cores). [out, may be NULL]
  *
  * @return double CPU usage percentage (0.0 - 100.0)
  */
@@ -98,7 +148,8 @@ double calculate_cpu_usage(const cpu_stat_t *prev, const cpu_stat_t *curr, uint6
   uint64_t delta_idle = curr_idle - prev_idle;
   uint64_t delta_total = curr_total - prev_total;
   
-  *total_delta = delta_total;
+  if (total_delta)
+    *total_delta = delta_total;
 
   if (delta_total == 0) 
     return 0.0;
@@ -106,3 +157,33 @@ double calculate_cpu_usage(const cpu_stat_t *prev, const cpu_stat_t *curr, uint6
   // 4. Compute cpu usage percentage
   return ((double)(delta_total - delta_idle) / delta_total) * 100;
 }
+
+/**
+ * @brief Calculate the utilization of each core between two samples.
+ *
+ * @param prev  Data from the previous sample.
+ * @param curr  Data from the current sample.
+ * @param usage Utilization per core (%, -1 for a core offline in either sample). [out]
+ * @param cap   Entries available in usage.
+ *
+ * @return Number of entries written.
+ */
+uint32_t calculate_core_usage(const cpu_stat_t *prev, const cpu_stat_t *curr,
+                              float *usage, size_t cap) {
+  if (!prev || !curr || !usage)
+    return 0;
+
+  uint32_t n = curr->ncores;
+  if (n > cap) n = (uint32_t)cap;
+
+  for (uint32_t k = 0; k < n; ++ k) {
+    uint64_t total = curr->core_total[k] - prev->core_total[k];
+    if (prev->core_total[k] == 0 || curr->core_total[k] == 0 || total == 0) {
+      usage[k] = -1.0f;
+      continue;
+    }
+    usage[k] = (float)((double)(curr->core_busy[k] - prev->core_busy[k]) / total * 100);
+  }
+
+  return n;
+}
@@ -0,0 +1,295 @@
+#include "mytop.h"
+#include "mytop_types.h"
+#include "utils.h"
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <unistd.h>
+
+#define CORE_BAR_WIDTH 20
+
+/**
+ * @brief Print system snapshot to terminal.
+ *
+ * Formatted output of system version, machine architecture and memory usage.
+ * Kernel : [version]
+ * Machine: [Arch]
+ * Memory : [Used] GB / [Total] GB ([Percent]%)  buff/cache [GB]  avail [GB]
+ * Swap   : [Used] GB / [Total] GB  dirty [MB]  slab [MB]  commit [GB] / [GB]
+ *
+ * @param sys Pointer to the populated system information structure.
+ * @param mem Pointer to the populated memory information structure
+ */
+void print_system_snapshot(const sys_info_t *sys, const mem_info_t *mem) {
+  // Check input parameters 
+  if (!sys || !mem)
+    return;
+
+  printf("Kernel : %s\n", sys->release);
+  printf("Machine: %s\n", sys->machine);
+  printf("Memory : %.2lf GB / %.2lf GB (%.2lf%%)",
+         mem_uint_convert(mem->used, MEM_KIB, MEM_GIB),
+         mem_uint_convert(mem->total, MEM_KIB, MEM_GIB),
+         mem->used_percent);
+  printf("  buff/cache %.2lf GB  avail %.2lf GB\n",
+         mem_uint_convert(mem->buff_cache, MEM_KIB, MEM_GIB),
+         mem_uint_convert(mem->available, MEM_KIB, MEM_GIB));
+  printf("Swap   : %.2lf GB / %.2lf GB  dirty %.1lf MB  slab %.1lf MB  commit %.2lf GB / %.2lf GB\n",
+         mem_uint_convert(mem->swap_used, MEM_KIB, MEM_GIB),
+         mem_uint_convert(mem->swap_total, MEM_KIB, MEM_GIB),
+         mem_uint_convert(mem->dirty, MEM_KIB, MEM_MIB),
+         mem_uint_convert(mem->slab, MEM_KIB, MEM_MIB),
+         mem_uint_convert(mem->committed_as, MEM_KIB, MEM_GIB),
+         mem_uint_convert(mem->commit_limit, MEM_KIB, MEM_GIB));
+}
+
+/**
+ * @brief Print the per-core view: the utilization bar of each core with
+ *        the busiest processes that last ran on it underneath.
+ *
+ * cpu2  [||||||||||          ]  51.0%
+ *         4242  48.20%  0.0/s  stress-ng --cpu 4
+ *
+ * Processes are grouped by stat field 39 (last CPU), so a process that
+ * migrated during the interval is listed under the core it ended on.
+ *
+ * @param list   Processes of the snapshot (any order).
+ * @param usage  Utilization of each core (see calculate_core_usage()).
+ * @param ncores Entries in usage.
+ * @param rows   Lines available for the view.
+ *
+ * @return Number of lines printed.
+ */
+int print_cores(const proc_list_t *list, const float *usage, size_t ncores, int rows) {
+  if (!list || !usage || ncores == 0 || rows <= 0)
+    return 0;
+
+  int cols;
+  get_term_size(NULL, &cols);
+
+  if (ncores > (size_t)rows) ncores = (size_t)rows;
+  int per_core = rows / (int)ncores - 1;
+  if (per_core > CORE_TOP_PROCS) per_core = CORE_TOP_PROCS;
+  if (per_core < 0) per_core = 0;
+
+  // Busiest processes of each core, by insertion into a short ranking
+  uint32_t top[MAX_CORES][CORE_TOP_PROCS];
+  uint32_t ntop[MAX_CORES] = {0};
+  for (size_t i = 0; per_core > 0 && i < list->count; ++ i) {
+    const proc_info_t *p = &list->procs[i];
+    if (p->processor < 0 || (size_t)p->processor >= ncores || p->cpu_percent <= 0)
+      continue;
+
+    uint32_t *t = top[p->processor];
+    uint32_t *n = &ntop[p->processor];
+    uint32_t pos = *n < (uint32_t)per_core ? (*n) ++ : (uint32_t)per_core;
+    while (pos > 0 && list->procs[t[pos - 1]].cpu_percent < p->cpu_percent) {
+      if (pos < (uint32_t)per_core)
+        t[pos] = t[pos - 1];
+      pos --;
+    }
+    if (pos < (uint32_t)per_core)
+      t[pos] = (uint32_t)i;
+  }
+
+  int lines = 0;
+  int cmd_width = cols - 34;
+  if (cmd_width < 10) cmd_width = 10;
+  for (size_t k = 0; k < ncores; ++ k) {
+    if (usage[k] < 0) {
+      printf("cpu%-3zu offline\n", k);
+      lines ++;
+      continue;
+    }
+
+    char bar[CORE_BAR_WIDTH + 1];
+    int fill = (int)(usage[k] / 100 * CORE_BAR_WIDTH + 0.5f);
+    for (int b = 0; b < CORE_BAR_WIDTH; ++ b)
+      bar[b] = b < fill ? '|' : ' ';
+    bar[CORE_BAR_WIDTH] = '\0';
+    printf("cpu%-3zu [%s] %5.1f%%\n", k, bar, usage[k]);
+    lines ++;
+
+    for (uint32_t j = 0; j < ntop[k]; ++ j) {
+      const proc_info_t *p = &list->procs[top[k][j]];
+      printf("      %7" PRIu64 " %6.2f%% %5.1f/s  %-.*s\n",
+             p->pid, p->cpu_percent, p->migrate_rate,
+             cmd_width, strtab_get(list->strtab, p->cmd));
+      lines ++;
+    }
+  }
+
+  return lines;
+}
+
+/**
+ * @brief Print the pressure panel, one line per resource.
+ *
+ * PSI cpu    : some  1.20%  0.80% (+12345us)  full  0.00%  0.00% (+0us)
+ *
+ * @return Number of lines printed.
+ */
+int print_pressure(const psi_info_t *psi) {
+  if (!psi || !psi->available)
+    return 0;
+
+  int lines = 0;
+  for (int k = 0; k < PSI_COUNT; ++ k) {
+    if (psi->fd[k] == -1)
+      continue;
+
+    const psi_resource_t *res = &psi->res[k];
+    printf("PSI %-7s: some %5.2f%% %5.2f%% (+%" PRIu64 "us)",
+           psi_resource_name(k), res->some.avg10, res->some.avg60, res->some_delta);
+    if (res->has_full)
+      printf("  full %5.2f%% %5.2f%% (+%" PRIu64 "us)",
+             res->full.avg10, res->full.avg60, res->full_delta);
+    if (psi->trigger_fd[k] != -1)
+      printf("  events %" PRIu64, psi->events[k]);
+    printf("\n");
+    lines ++;
+  }
+
+  return lines;
+}
+
+/**
+ * @brief Number of lines print_iostat() will print.
+ */
+int iostat_panel_lines(const iostat_t *io) {
+  if (!io)
+    return 0;
+
+  const disk_stat_t *disks[IOSTAT_ROWS];
+  const net_stat_t *nets[IOSTAT_ROWS];
+  size_t nd = iostat_busiest_disks(io, disks);
+  size_t nn = iostat_busiest_nets(io, nets);
+
+  return (int)((nd ? nd + 1 : 0) + (nn ? nn + 1 : 0));
+}
+
+/**
+ * @brief Print the disk and network panels, busiest devices first.
+ *
+ * DISK         READ MB/s  WRITE MB/s      IOPS    AWAIT
+ * vda               0.00        0.12       3.0    0.50ms
+ * NET            RX MB/s     TX MB/s    RX p/s    TX p/s
+ * eth0              0.01        0.00      12.0       9.0
+ *
+ * @return Number of lines printed.
+ */
+int print_iostat(const iostat_t *io) {
+  if (!io)
+    return 0;
+
+  const disk_stat_t *disks[IOSTAT_ROWS];
+  const net_stat_t *nets[IOSTAT_ROWS];
+  size_t nd = iostat_busiest_disks(io, disks);
+  size_t nn = iostat_busiest_nets(io, nets);
+
+  int lines = 0;
+  if (nd > 0) {
+    printf("%-12s %10s %11s %9s %9s\n", "DISK", "READ MB/s", "WRITE MB/s", "IOPS", "AWAIT");
+    for (size_t i = 0; i < nd; ++ i)
+      printf("%-12s %10.2f %11.2f %9.1f %7.2fms\n", disks[i]->name,
+             disks[i]->read_mbs, disks[i]->write_mbs, disks[i]->iops, disks[i]->await_ms);
+    lines += (int)nd + 1;
+  }
+
+  if (nn > 0) {
+    printf("%-12s %10s %11s %9s %9s\n", "NET", "RX MB/s", "TX MB/s", "RX p/s", "TX p/s");
+    for (size_t i = 0; i < nn; ++ i)
+      printf("%-12s %10.2f %11.2f %9.1f %9.1f\n", nets[i]->name,
+             nets[i]->rx_mbs, nets[i]->tx_mbs, nets[i]->rx_pps, nets[i]->tx_pps);
+    lines += (int)nn + 1;
+  }
+
+  return lines;
+}
+
+/**
+ * @brief Lines used by the lifecycle panel.
+ */
+int lifecycle_panel_lines(const lifecycle_t *lc, bool show_exits) {
+  if (!lc)
+    return 0;
+
+  return 1 + (show_exits ? 1 + (int)lc->exit_count : 0);
+}
+
+/**
+ * @brief Print the process lifecycle line and the recent exits panel.
+ *
+ * Tasks: 312 total, +5 started, -3 exited, 120 forks (115 unseen)
+ *
+ * Forks count every clone() in the interval (threads included), so the
+ * "unseen" estimate of processes that started and exited between two
+ * scans is an upper bound. Processes left out by --max-memory are
+ * counted in the total and summed at the end of the line, as are the
+ * processes a bounded first scan listed but did not read yet.
+ *
+ * @param unread  Processes not read yet.
+ * @param dropped Processes summarized instead of kept (may be NULL).
+ *
+ * @return Number of lines printed.
+ */
+int print_lifecycle(const lifecycle_t *lc, size_t nprocs, size_t unread,
+                    const proc_summary_t *dropped, bool show_exits) {
+  if (!lc)
+    return 0;
+
+  size_t ndropped = dropped ? dropped->count : 0;
+  uint64_t unseen = lc->forks > lc->births ? lc->forks - lc->births : 0;
+  printf("Tasks: %zu total, +%" PRIu64 " started, -%" PRIu64 " exited, "
+         "%" PRIu64 " forks (%" PRIu64 " unseen)",
+         nprocs + unread + ndropped, lc->births, lc->deaths, lc->forks, unseen);
+  if (unread)
+    printf(", %zu not read yet", unread);
+  if (ndropped) {
+    uint64_t rss_kb = pages_to_kb(dropped->rss, (uint64_t)sysconf(_SC_PAGESIZE));
+    printf(", %zu summarized (%.1f%% CPU, %.1f MiB RES)", ndropped, dropped->cpu_percent,
+           mem_uint_convert(rss_kb, MEM_KIB, MEM_MIB));
+  }
+  printf("\n");
+  if (!show_exits)
+    return 1;
+
+  printf("Recent exits (%" PRIu64 " total):\n", lc->total_exits);
+  const long hz = sysconf(_SC_CLK_TCK);
+  for (uint32_t k = 0; k < lc->exit_count; ++ k) {
+    // Newest first
+    const proc_exit_t *x = &lc->exits[(lc->exit_head + EXIT_RING_LEN - 1 - k) % EXIT_RING_LEN];
+    char timebuf[16];
+    format_time_hms(timebuf, sizeof(timebuf), x->cpu_ticks, hz);
+    if (x->run_ns)
+      printf("  %7" PRIu64 " %10.3fs  %s\n", x->pid, x->run_ns / 1e9, x->cmd);
+    else
+      printf("  %7" PRIu64 " %11s  %s\n", x->pid, timebuf, x->cmd);
+  }
+
+  return 2 + (int)lc->exit_count;
+}
+
+/**
+ * @brief Number of process rows that fit on the terminal.
+ *
+ * @param list         Process list.
+ * @param header_lines Lines printed above the process table.
+ */
+size_t procs_visible_count(const proc_list_t *list, int header_lines) {
+  if (!list)
+    return 0;
+
+  int rows, cols;
+  // Get terminal width and length
+  get_term_size(&rows, &cols);
+  int reserved_lines = header_lines + 1 + 1 + 2;
+  int max_procs_to_show = rows - reserved_lines;
+  if (max_procs_to_show < 0) max_procs_to_show = 0;
+
+  size_t limit = (size_t)max_procs_to_show;
+  if (limit > list->count) limit = list->count;
+
+  return limit;
+}
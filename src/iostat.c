@@ -0,0 +1,441 @@
+#include "log.h"
+#include "mytop.h"
+#include "mytop_types.h"
+#include "utils.h"
+#include <fcntl.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define SECTOR_SIZE 512
+
+struct column {
+  size_t index;    // Counter column, counted from 0 after the device name
+  size_t offset;   // The offset of this counter within the counters structure
+};
+
+// "major minor name reads merged sectors ms writes merged sectors ms ..."
+static const struct column disk_columns[] = {
+  {0, offsetof(disk_counters_t, reads)},
+  {2, offsetof(disk_counters_t, sectors_read)},
+  {3, offsetof(disk_counters_t, read_ms)},
+  {4, offsetof(disk_counters_t, writes)},
+  {6, offsetof(disk_counters_t, sectors_written)},
+  {7, offsetof(disk_counters_t, write_ms)},
+};
+
+// "name: rx_bytes rx_packets errs drop fifo frame compressed multicast tx_bytes tx_packets ..."
+static const struct column net_columns[] = {
+  {0, offsetof(net_counters_t, rx_bytes)},
+  {1, offsetof(net_counters_t, rx_packets)},
+  {8, offsetof(net_counters_t, tx_bytes)},
+  {9, offsetof(net_counters_t, tx_packets)},
+};
+
+/**
+ * Helper function
+ *
+ * @brief Parse a decimal number at *p and advance past it.
+ *
+ * @return false if *p does not start with a digit.
+ */
+static inline bool parse_u64(const char **p, const char *end, uint64_t *out) {
+  const char *s = *p;
+  if (s == end || *s < '0' || *s > '9')
+    return false;
+
+  uint64_t v = 0;
+  for (; s < end && *s >= '0' && *s <= '9'; ++ s)
+    v = v * 10 + (uint64_t)(*s - '0');
+
+  *p = s;
+  *out = v;
+  return true;
+}
+
+/**
+ * Helper function
+ *
+ * @brief Skip spaces and tabs.
+ */
+static inline const char *skip_blank(const char *p, const char *end) {
+  for (; p < end && (*p == ' ' || *p == '\t'); ++ p);
+  return p;
+}
+
+/**
+ * Helper function
+ *
+ * @brief Store the counter columns of one line into dst, driven by cols[].
+ *
+ * @param p    First counter of the line.
+ * @param end  End of the line.
+ * @param cols Columns to extract, in ascending index order.
+ * @param dst  Counters structure receiving the values.
+ *
+ * @return MYTOP_OK, or MYTOP_ERR_PARSE if the line is too short.
+ */
+static mytop_status_t parse_columns(const char *p, const char *end,
+                                    const struct column *cols, size_t ncols, void *dst) {
+  size_t k = 0;
+  for (size_t index = 0; k < ncols; ++ index) {
+    uint64_t value;
+    p = skip_blank(p, end);
+    if (!parse_u64(&p, end, &value))
+      return MYTOP_ERR_PARSE;
+
+    if (index == cols[k].index) {
+      *(uint64_t *)((char *)dst + cols[k].offset) = value;
+      k ++;
+    }
+  }
+
+  return MYTOP_OK;
+}
+
+/**
+ * Helper function
+ *
+ * @brief Read a whole /proc file through its persistent descriptor.
+ *
+ * The buffer is reused across ticks and only grows when the file no
+ * longer fits (e.g. new devices appeared).
+ *
+ * @return The number of bytes read, or -1 on failure.
+ */
+static ssize_t read_whole(iostat_t *io, int fd) {
+  size_t len = 0;
+  for (;;) {
+    if (len == io->buf_cap) {
+      char *buf = realloc(io->buf, io->buf_cap * 2);
+      if (!buf)
+        return -1;
+      io->buf = buf;
+      io->buf_cap *= 2;
+    }
+
+    ssize_t n = pread(fd, io->buf + len, io->buf_cap - len, (off_t)len);
+    if (n < 0)
+      return -1;
+    if (n == 0)
+      break;
+    len += (size_t)n;
+  }
+
+  return (ssize_t)len;
+}
+
+/**
+ * Helper function
+ *
+ * @brief Counter difference, tolerating counter resets.
+ */
+static inline double delta(uint64_t curr, uint64_t prev) {
+  return curr >= prev ? (double)(curr - prev) : 0.0;
+}
+
+/**
+ * Helper function
+ *
+ * @brief Decide once per device whether it is a whole disk.
+ *
+ * Partitions would double count their disk, and loop/ram devices are
+ * noise, so only entries of /sys/block other than those are shown.
+ */
+static int is_whole_disk(const char *name) {
+  if (strncmp(name, "loop", 4) == 0 || strncmp(name, "ram", 3) == 0)
+    return 0;
+
+  char path[64 + DEV_NAME_LEN];
+  snprintf(path, sizeof(path), "/sys/block/%s", name);
+  return access(path, F_OK) == 0;
+}
+
+/**
+ * Helper function
+ *
+ * @brief Find the slot named name[0..len), or claim a new one.
+ *
+ * The files list devices in a stable order, so the slot at position
+ * hint is tried first and the scan is skipped in the common case.
+ * A claimed slot is zeroed (seen_tick == 0 marks it as new); the name
+ * must be the first member of the slot structure.
+ *
+ * @return The slot index, or -1 if the table is full.
+ */
+static long find_slot(char *names, size_t stride, size_t *count, size_t max,
+                      size_t hint, const char *name, size_t len) {
+  if (len >= DEV_NAME_LEN)
+    len = DEV_NAME_LEN - 1;
+
+  if (hint < *count) {
+    const char *n = names + hint * stride;
+    if (strncmp(n, name, len) == 0 && n[len] == '\0')
+      return (long)hint;
+  }
+
+  for (size_t i = 0; i < *count; ++ i) {
+    const char *n = names + i * stride;
+    if (strncmp(n, name, len) == 0 && n[len] == '\0')
+      return (long)i;
+  }
+
+  if (*count == max)
+    return -1;
+
+  char *n = names + (*count) * stride;
+  memset(n, 0, stride);
+  memcpy(n, name, len);
+  n[len] = '\0';
+  return (long)(*count) ++;
+}
+
+/**
+ * Helper function
+ *
+ * @brief Parse /proc/diskstats into the disk table.
+ */
+static void sample_disks(iostat_t *io) {
+  ssize_t len = read_whole(io, io->disk_fd);
+  if (len < 0)
+    return;
+
+  const char *p = io->buf, *end = io->buf + len;
+  size_t line_no = 0;
+  while (p < end) {
+    const char *eol = memchr(p, '\n', (size_t)(end - p));
+    if (!eol) eol = end;
+
+    // Skip major and minor numbers
+    uint64_t skip;
+    const char *q = skip_blank(p, eol);
+    bool ok = parse_u64(&q, eol, &skip);
+    q = skip_blank(q, eol);
+    ok = ok && parse_u64(&q, eol, &skip);
+    q = skip_blank(q, eol);
+
+    const char *name = q;
+    for (; q < eol && *q != ' '; ++ q);
+    size_t name_len = (size_t)(q - name);
+
+    if (ok && name_len > 0) {
+      long slot = find_slot(io->disks[0].name, sizeof(disk_stat_t), &io->ndisks,
+                            MAX_DISKS, line_no, name, name_len);
+      if (slot != -1) {
+        disk_stat_t *d = &io->disks[slot];
+        if (d->seen_tick == 0)
+          d->whole = is_whole_disk(d->name);
+
+        if (parse_columns(q, eol, disk_columns,
+                          sizeof(disk_columns) / sizeof(disk_columns[0]), &d->curr) == MYTOP_OK) {
+          // New devices get their first rates on the next sample
+          if (d->seen_tick == 0) d->prev = d->curr;
+          d->seen_tick = io->tick;
+        }
+      }
+    }
+
+    p = eol + 1;
+    line_no ++;
+  }
+}
+
+/**
+ * Helper function
+ *
+ * @brief Parse /proc/net/dev into the interface table.
+ */
+static void sample_nets(iostat_t *io) {
+  ssize_t len = read_whole(io, io->net_fd);
+  if (len < 0)
+    return;
+
+  const char *p = io->buf, *end = io->buf + len;
+  size_t line_no = 0;
+  while (p < end) {
+    const char *eol = memchr(p, '\n', (size_t)(end - p));
+    if (!eol) eol = end;
+
+    // Two header lines, then "  name: counters..."
+    const char *colon = memchr(p, ':', (size_t)(eol - p));
+    if (line_no >= 2 && colon) {
+      const char *name = skip_blank(p, colon);
+      long slot = find_slot(io->nets[0].name, sizeof(net_stat_t), &io->nnets,
+                            MAX_NETIFS, line_no - 2, name, (size_t)(colon - name));
+      if (slot != -1) {
+        net_stat_t *n = &io->nets[slot];
+        if (parse_columns(colon + 1, eol, net_columns,
+                          sizeof(net_columns) / sizeof(net_columns[0]), &n->curr) == MYTOP_OK) {
+          if (n->seen_tick == 0) n->prev = n->curr;
+          n->seen_tick = io->tick;
+        }
+      }
+    }
+
+    p = eol + 1;
+    line_no ++;
+  }
+}
+
+/**
+ * @brief Open /proc/diskstats and /proc/net/dev once for the panels.
+ *
+ * @return
+ *  - MYTOP_OK if at least one of the files could be opened.
+ *  - MYTOP_NO_FILE if neither is available.
+ *  - MYTOP_ERR_NOMEM if the read buffer cannot be allocated.
+ */
+mytop_status_t iostat_open(iostat_t *io) {
+  // Check input parameters
+  if (!io)
+    return MYTOP_ERR_PARAM;
+
+  memset(io, 0, sizeof(*io));
+  io->disk_fd = open("/proc/diskstats", O_RDONLY | O_CLOEXEC);
+  io->net_fd = open("/proc/net/dev", O_RDONLY | O_CLOEXEC);
+
+  io->buf = malloc(IOSTAT_BUF_SIZE);
+  if (!io->buf) {
+    iostat_close(io);
+    return MYTOP_ERR_NOMEM;
+  }
+  io->buf_cap = IOSTAT_BUF_SIZE;
+
+  if (io->disk_fd == -1 && io->net_fd == -1)
+    return MYTOP_NO_FILE;
+
+  return MYTOP_OK;
+}
+
+/**
+ * @brief Sample all devices and interfaces and compute their rates.
+ *
+ * Devices that disappeared are dropped; the tables keep the order of
+ * the files so the next sample finds every slot at its position.
+ */
+mytop_status_t iostat_sample(iostat_t *io) {
+  // Check input parameters
+  if (!io || !io->buf)
+    return MYTOP_ERR_PARAM;
+
+  uint64_t now = monotonic_ns();
+  io->dt = io->prev_ns ? (double)(now - io->prev_ns) / 1e9 : 0.0;
+  io->prev_ns = now;
+  io->tick ++;
+
+  if (io->disk_fd != -1) sample_disks(io);
+  if (io->net_fd != -1) sample_nets(io);
+
+  // Compact away devices that are gone
+  size_t n = 0;
+  for (size_t i = 0; i < io->ndisks; ++ i) {
+    disk_stat_t *d = &io->disks[i];
+    if (d->seen_tick != io->tick)
+      continue;
+
+    double dt = io->dt > 0 ? io->dt : 1.0;
+    double ios = delta(d->curr.reads, d->prev.reads) + delta(d->curr.writes, d->prev.writes);
+    d->read_mbs = delta(d->curr.sectors_read, d->prev.sectors_read) * SECTOR_SIZE / 1e6 / dt;
+    d->write_mbs = delta(d->curr.sectors_written, d->prev.sectors_written) * SECTOR_SIZE / 1e6 / dt;
+    d->iops = ios / dt;
+    d->await_ms = ios > 0 ?
+                  (delta(d->curr.read_ms, d->prev.read_ms) +
+                   delta(d->curr.write_ms, d->prev.write_ms)) / ios :
+                  0.0;
+    d->prev = d->curr;
+
+    if (n != i) io->disks[n] = *d;
+    n ++;
+  }
+  io->ndisks = n;
+
+  n = 0;
+  for (size_t i = 0; i < io->nnets; ++ i) {
+    net_stat_t *e = &io->nets[i];
+    if (e->seen_tick != io->tick)
+      continue;
+
+    double dt = io->dt > 0 ? io->dt : 1.0;
+    e->rx_mbs = delta(e->curr.rx_bytes, e->prev.rx_bytes) / 1e6 / dt;
+    e->tx_mbs = delta(e->curr.tx_bytes, e->prev.tx_bytes) / 1e6 / dt;
+    e->rx_pps = delta(e->curr.rx_packets, e->prev.rx_packets) / dt;
+    e->tx_pps = delta(e->curr.tx_packets, e->prev.tx_packets) / dt;
+    e->prev = e->curr;
+
+    if (n != i) io->nets[n] = *e;
+    n ++;
+  }
+  io->nnets = n;
+
+  return MYTOP_OK;
+}
+
+/**
+ * @brief Close the descriptors and free the read buffer.
+ */
+void iostat_close(iostat_t *io) {
+  if (!io)
+    return;
+
+  if (io->disk_fd != -1) close(io->disk_fd);
+  if (io->net_fd != -1) close(io->net_fd);
+  io->disk_fd = -1;
+  io->net_fd = -1;
+
+  free(io->buf);
+  io->buf = NULL;
+  io->buf_cap = 0;
+}
+
+/**
+ * @brief Pick the IOSTAT_ROWS busiest disks, keeping idle ones out.
+ *
+ * @return Number of rows stored in rows[].
+ */
+size_t iostat_busiest_disks(const iostat_t *io, const disk_stat_t **rows) {
+  size_t picked = 0;
+  for (size_t i = 0; i < io->ndisks; ++ i) {
+    const disk_stat_t *d = &io->disks[i];
+    // Never used since boot
+    if (!d->whole || d->curr.reads + d->curr.writes == 0)
+      continue;
+
+    double load = d->read_mbs + d->write_mbs;
+    if (picked == IOSTAT_ROWS &&
+        load <= rows[picked - 1]->read_mbs + rows[picked - 1]->write_mbs)
+      continue;
+
+    size_t j = picked < IOSTAT_ROWS ? picked ++ : picked - 1;
+    for (; j > 0 && rows[j - 1]->read_mbs + rows[j - 1]->write_mbs < load; -- j)
+      rows[j] = rows[j - 1];
+    rows[j] = d;
+  }
+
+  return picked;
+}
+
+/**
+ * @brief Pick the IOSTAT_ROWS busiest interfaces (loopback excluded).
+ */
+size_t iostat_busiest_nets(const iostat_t *io, const net_stat_t **rows) {
+  size_t picked = 0;
+  for (size_t i = 0; i < io->nnets; ++ i) {
+    const net_stat_t *e = &io->nets[i];
+    if (strcmp(e->name, "lo") == 0 || e->curr.rx_packets + e->curr.tx_packets == 0)
+      continue;
+
+    double load = e->rx_mbs + e->tx_mbs;
+    if (picked == IOSTAT_ROWS && load <= rows[picked - 1]->rx_mbs + rows[picked - 1]->tx_mbs)
+      continue;
+
+    size_t j = picked < IOSTAT_ROWS ? picked ++ : picked - 1;
+    for (; j > 0 && rows[j - 1]->rx_mbs + rows[j - 1]->tx_mbs < load; -- j)
+      rows[j] = rows[j - 1];
+    rows[j] = e;
+  }
+
+  return picked;
+}
@@ -0,0 +1,273 @@
+#include "libmytop.h"
+#include "log.h"
+#include "mytop.h"
+#include "mytop_types.h"
+#include "utils.h"
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+struct mytop_ctx {
+  str_table_t *strtab;    // Command lines of both lists
+  proc_list_t *prev;      // Previous scan, sorted by sort
+  proc_list_t *curr;      // Scan in progress
+  uring_t uring;          // Batched /proc reads (fd -1 = plain read())
+  int meminfo_fd;
+  cpu_stat_t prev_cpu;
+  lifecycle_t lc;
+  sort_mode_t sort;
+  mytop_log_sink_t log;   // The caller's sink
+  log_sink_t sink;        // Installed while a call runs, forwards to log
+  long hz;
+  uint64_t pagesize;
+};
+
+/**
+ * @brief Fill options with the defaults: schedstat accounting, io_uring,
+ *        records by descending CPU%, messages discarded.
+ */
+void mytop_options_init(mytop_options_t *opts) {
+  if (!opts)
+    return;
+
+  memset(opts, 0, sizeof(*opts));
+  opts->schedstat = true;
+  opts->use_uring = true;
+  opts->sort = MYTOP_SORT_CPU;
+  opts->log.level = MYTOP_LOG_WARN;
+}
+
+// The public levels mirror the internal ones
+_Static_assert((int)MYTOP_LOG_DEBUG == (int)LOG_DEBUG && (int)MYTOP_LOG_FATAL == (int)LOG_FATAL,
+               "log levels differ");
+
+/**
+ * Helper function
+ *
+ * @brief Pass a library message on to the caller's sink.
+ */
+static void forward_log(void *user, log_level_t level, const char *module, const char *file,
+                        int line, const char *msg) {
+  const mytop_log_sink_t *log = user;
+  log->fn(log->user, (mytop_log_level_t)level, module, file, line, msg);
+}
+
+/**
+ * Helper function
+ *
+ * @brief Internal sort mode of a public one.
+ *
+ * @return false if the mode is unknown.
+ */
+static bool to_sort_mode(mytop_sort_t sort, sort_mode_t *mode) {
+  switch (sort) {
+    case MYTOP_SORT_CPU: *mode = SORT_CPU; return true;
+    case MYTOP_SORT_MEM: *mode = SORT_MEM; return true;
+    case MYTOP_SORT_PID: *mode = SORT_PID; return true;
+  }
+  return false;
+}
+
+/**
+ * Helper function
+ *
+ * @brief Copy the first records of the current list into the caller's buffer.
+ */
+static void fill_snapshot(const mytop_ctx_t *ctx, mytop_snapshot_t *snap) {
+  const proc_list_t *list = ctx->curr;
+
+  snap->nprocs = list->count;
+  snap->sample_ns = list->sample_ns;
+  snap->births = ctx->lc.births;
+  snap->deaths = ctx->lc.deaths;
+  snap->forks = ctx->lc.forks;
+
+  size_t n = list->count < snap->capacity ? list->count : snap->capacity;
+  for (size_t i = 0; i < n; ++ i) {
+    const proc_info_t *p = &list->procs[i];
+    mytop_proc_t *out = &snap->procs[i];
+
+    out->pid = p->pid;
+    out->ppid = p->ppid;
+    out->pgrp = p->pgrp;
+    out->state = p->state;
+    out->cpu_percent = p->cpu_percent;
+    out->delay_percent = p->delay_percent;
+    out->utime_ms = p->utime * 1000 / (uint64_t)ctx->hz;
+    out->stime_ms = p->stime * 1000 / (uint64_t)ctx->hz;
+    out->virt_kb = p->vsize / 1024;
+    out->res_kb = pages_to_kb(p->rss, ctx->pagesize);
+    out->starttime = p->starttime;
+
+    size_t len = strtab_len(list->strtab, p->cmd);
+    if (len >= MYTOP_CMD_LEN) len = MYTOP_CMD_LEN - 1;
+    memcpy(out->command, strtab_get(list->strtab, p->cmd), len);
+    out->command[len] = '\0';
+  }
+  snap->count = n;
+}
+
+/**
+ * @brief Create a collection context and take its first scan.
+ *
+ * The first scan is the baseline of the CPU percentages of the first
+ * mytop_sample(), which measures the time in between.
+ *
+ * @param ctx  Receives the context. [out]
+ * @param opts Options, or NULL for the defaults (see mytop_options_init()).
+ *
+ * @return
+ *  - MYTOP_OK on success.
+ *  - MYTOP_ERR_PARAM if ctx is NULL or the sort mode is unknown.
+ *  - MYTOP_ERR_NOMEM on allocation failure.
+ *  - MYTOP_ERR_IO if /proc/meminfo cannot be opened.
+ */
+mytop_status_t mytop_open(mytop_ctx_t **ctx, const mytop_options_t *opts) {
+  // Check input parameters
+  if (!ctx)
+    return MYTOP_ERR_PARAM;
+  *ctx = NULL;
+
+  mytop_options_t defaults;
+  if (!opts) {
+    mytop_options_init(&defaults);
+    opts = &defaults;
+  }
+  sort_mode_t sort;
+  if (!to_sort_mode(opts->sort, &sort))
+    return MYTOP_ERR_PARAM;
+
+  mytop_ctx_t *c = calloc(1, sizeof(mytop_ctx_t));
+  if (!c)
+    return MYTOP_ERR_NOMEM;
+
+  c->uring.fd = -1;
+  c->meminfo_fd = -1;
+  c->sort = sort;
+  c->log = opts->log;
+  c->sink.fn = c->log.fn ? forward_log : NULL;
+  c->sink.user = &c->log;
+  c->sink.level = (log_level_t)c->log.level;
+  c->hz = sysconf(_SC_CLK_TCK);
+  c->pagesize = (uint64_t)sysconf(_SC_PAGESIZE);
+  if (c->hz <= 0) c->hz = 100;
+
+  const log_sink_t *saved = log_set_sink(&c->sink);
+  mytop_status_t st = MYTOP_ERR_NOMEM;
+
+  c->strtab = create_str_table();
+  c->prev = create_procs_list(0, c->strtab);
+  c->curr = create_procs_list(0, c->strtab);
+  if (!c->strtab || !c->prev || !c->curr)
+    goto fail;
+
+  c->meminfo_fd = meminfo_open();
+  if (c->meminfo_fd == -1) {
+    st = MYTOP_ERR_IO;
+    goto fail;
+  }
+
+  cpu_acct_t acct = opts->schedstat && schedstat_available() ? ACCT_SCHEDSTAT : ACCT_JIFFIES;
+  c->prev->acct = c->curr->acct = acct;
+  c->prev->children = c->curr->children = opts->children;
+  // Records carry stat fields up to RSS (24), schedstat and the command
+  c->prev->stat_fields = c->curr->stat_fields = 24;
+  if (opts->use_uring)
+    procs_attach_uring(&c->uring, c->prev, c->curr);
+
+  parse_cpu_stat(&c->prev_cpu);
+  st = parse_procs(c->prev);
+  if (st != MYTOP_OK)
+    goto fail;
+  sort_procs_by_mode(c->prev, c->sort);
+
+  log_set_sink(saved);
+  *ctx = c;
+  return MYTOP_OK;
+
+fail:
+  mytop_close(c);
+  log_set_sink(saved);
+  return st;
+}
+
+/**
+ * @brief Scan the system and write a snapshot into the caller's buffer.
+ *
+ * Rates are measured since the previous call (or mytop_open()). The
+ * records come in the context's sort order; when snap->capacity is
+ * smaller than the process count only the first ones are written, and
+ * snap->nprocs still counts every process.
+ *
+ * @param ctx  Context.
+ * @param snap Snapshot: procs and capacity are set by the caller. [in/out]
+ *
+ * @return MYTOP_OK, or the status of the failed read (snap is then untouched
+ *         and the next call measures from the last successful one).
+ */
+mytop_status_t mytop_sample(mytop_ctx_t *ctx, mytop_snapshot_t *snap) {
+  // Check input parameters
+  if (!ctx || !snap || (snap->capacity > 0 && !snap->procs))
+    return MYTOP_ERR_PARAM;
+
+  const log_sink_t *saved = log_set_sink(&ctx->sink);
+
+  cpu_stat_t curr_cpu;
+  mem_info_t mem;
+  mytop_status_t st = parse_cpu_stat(&curr_cpu);
+  if (st == MYTOP_OK)
+    st = parse_meminfo(ctx->meminfo_fd, &mem);
+  if (st == MYTOP_OK) {
+    clear_procs_list(ctx->curr);
+    st = parse_procs(ctx->curr);
+  }
+  if (st != MYTOP_OK) {
+    log_set_sink(saved);
+    return st;
+  }
+
+  snap->cpu_percent = calculate_cpu_usage(&ctx->prev_cpu, &curr_cpu, NULL);
+  snap->mem.total_kb = mem.total;
+  snap->mem.free_kb = mem.free;
+  snap->mem.available_kb = mem.available;
+  snap->mem.used_kb = mem.used;
+  snap->mem.buff_cache_kb = mem.buff_cache;
+  snap->mem.swap_total_kb = mem.swap_total;
+  snap->mem.swap_used_kb = mem.swap_used;
+  snap->mem.used_percent = mem.used_percent;
+  calculate_procs_cpu(ctx->prev, ctx->curr, &ctx->lc);
+  ctx->lc.forks = curr_cpu.processes - ctx->prev_cpu.processes;
+  // Falls back to a full sort if its buffers cannot grow
+  sort_procs_incremental(ctx->prev, ctx->curr, ctx->sort);
+  trim_procs_list(ctx->curr);
+  fill_snapshot(ctx, snap);
+
+  ctx->prev_cpu = curr_cpu;
+  proc_list_t *temp = ctx->prev;
+  ctx->prev = ctx->curr;
+  ctx->curr = temp;
+
+  log_set_sink(saved);
+  return MYTOP_OK;
+}
+
+/**
+ * @brief Release a context and everything it holds.
+ */
+void mytop_close(mytop_ctx_t *ctx) {
+  if (!ctx)
+    return;
+
+  const log_sink_t *saved = log_set_sink(&ctx->sink);
+
+  if (ctx->meminfo_fd != -1) close(ctx->meminfo_fd);
+  uring_free(&ctx->uring);
+  free_procs_list(ctx->prev);
+  free_procs_list(ctx->curr);
+  free_str_table(ctx->strtab);
+
+  log_set_sink(saved);
+  free(ctx);
+}
@@ -12,9 +12,12 @@
 #include <sys/time.h>
 #include <unistd.h>
 
-log_level_t g_log_level = LOG_DEBUG;
+#define LOG_MSG_LEN 1024
 
-static const char *level_str[] = {
+// Sink of the calling thread (NULL = stderr, see log.h)
+static _Thread_local const log_sink_t *thread_sink;
+
+static const char *const level_str[] = {
   "DEBUG",
   "INFO",
   "WARN",
@@ -22,12 +25,44 @@ static const char *level_str[] = {
   "FATAL"
 };
 
+/**
+ * @brief Route the calling thread's messages to a sink.
+ *
+ * The sink is not copied and must outlive its installation.
+ *
+ * @param sink New sink, or NULL for the stderr default.
+ *
+ * @return The sink it replaces, to be reinstalled when done.
+ */
+const log_sink_t *log_set_sink(const log_sink_t *sink) {
+  const log_sink_t *old = thread_sink;
+  thread_sink = sink;
+  return old;
+}
+
 void log_write(log_level_t level,
                const char *module,
                const char *file,
                int line,
                const char *fmt, ...) {
-  if (level < g_log_level)
+  const log_sink_t *sink = thread_sink;
+  if (sink) {
+    if (!sink->fn || level < sink->level)
+      return;
+
+    int saved_errno = errno;
+    char msg[LOG_MSG_LEN];
+    va_list ap;
+    va_start(ap, fmt);
+    vsnprintf(msg, sizeof(msg), fmt, ap);
+    va_end(ap);
+
+    errno = saved_errno;
+    sink->fn(sink->user, level, module, file, line, msg);
+    return;
+  }
+
+  if (level < LOG_INFO)
     return;
 
   // second + microsecond
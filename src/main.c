@@ -2,36 +2,776 @@
 #include "mytop.h"
 #include "mytop_types.h"
 #include "utils.h"
+#include <errno.h>
+#include <getopt.h>
+#include <inttypes.h>
+#include <limits.h>
 #include <signal.h>
+#include <stdlib.h>
+#include <stdbool.h>
 #include <stdint.h>
-#include <sys/select.h>
+#include <string.h>
+#include <poll.h>
+#include <time.h>
 #include <unistd.h>
 #include <stdio.h>
 
-int main() {
-  g_log_level = LOG_INFO;
+#define SHM_DEFAULT_NAME "/mytop"    // Suffixed with ".<uid>": one collector per user
+#define MIN_INTERVAL_MS  50    // Shortest accepted refresh interval
+#define HEADER_LINES     6     // System snapshot, CPU usage and a blank line
+#define STATUS_SHOW_MS   3000  // How long the outcome of an action stays on screen
+#define PROMPT_LEN       256
+
+// Line being typed at the bottom of the screen
+typedef enum {
+  PROMPT_NONE,
+  PROMPT_SIGNAL,    // Signal for the selected process
+  PROMPT_MATCH,     // "[SIGNAL] PATTERN" for every matching process
+  PROMPT_COLUMNS,   // Column list (see columns_parse())
+} prompt_kind_t;
+
+// Column groups toggled by a single key or option
+#define COLUMNS_SMAPS  "PSS,USS,SWAP"
+#define COLUMNS_FAULTS "MINF/s,MAJF/s,IOD,VCSW/s,IVCSW/s"
+
+// Set by SIGINT/SIGTERM in collector mode
+static volatile sig_atomic_t stop_requested = 0;
+
+static void on_stop_signal(int sig) {
+  (void)sig;
+  stop_requested = 1;
+}
+
+// SIGWINCH only needs to interrupt poll() so the frame is redrawn
+static void on_resize_signal(int sig) {
+  (void)sig;
+}
+
+/**
+ * @brief Parse a refresh interval given in (fractional) seconds.
+ *
+ * @return true on success, with the interval stored in *ms.
+ */
+static bool parse_interval(const char *s, uint64_t *ms) {
+  char *end;
+  double secs = strtod(s, &end);
+  if (end == s || *end != '\0' || !(secs * 1000 >= MIN_INTERVAL_MS) || secs > 3600)
+    return false;
+
+  *ms = (uint64_t)(secs * 1000 + 0.5);
+  return true;
+}
+
+/**
+ * @brief Sleep for ms milliseconds (returns early on a signal).
+ */
+static void sleep_ms(uint64_t ms) {
+  struct timespec ts = { (time_t)(ms / 1000), (long)(ms % 1000) * 1000000L };
+  nanosleep(&ts, NULL);
+}
+
+// Navigation keys, decoded from terminal escape sequences
+enum {
+  KEY_UP = 0x100,
+  KEY_DOWN,
+  KEY_PGUP,
+  KEY_PGDN,
+  KEY_HOME,
+  KEY_END
+};
+
+/**
+ * @brief Decode one key from the bytes read from the terminal.
+ *
+ * Handles the CSI/SS3 sequences of the arrow, PgUp/PgDn and Home/End
+ * keys ("\033[A", "\033OA", "\033[5~", "\033[1~", ...). Unknown
+ * sequences are consumed whole and ignored.
+ *
+ * @param buf  Input bytes.
+ * @param len  Number of bytes in buf (> 0).
+ * @param used Set to the number of bytes consumed.
+ *
+ * @return The key: a plain byte, one of KEY_*, or 0 for ignored input.
+ */
+static int decode_key(const char *buf, size_t len, size_t *used) {
+  *used = 1;
+  if (buf[0] != '\033' || len < 3 || (buf[1] != '[' && buf[1] != 'O'))
+    return (unsigned char)buf[0];
+
+  // "ESC [ params final": parameters are digits and ';'
+  size_t i = 2;
+  int param = 0;
+  for (; i < len && ((buf[i] >= '0' && buf[i] <= '9') || buf[i] == ';'); ++ i) {
+    if (buf[i] != ';') param = param * 10 + (buf[i] - '0');
+  }
+  if (i == len)
+    return 0;
+  *used = i + 1;
+
+  switch (buf[i]) {
+    case 'A': return KEY_UP;
+    case 'B': return KEY_DOWN;
+    case 'H': return KEY_HOME;
+    case 'F': return KEY_END;
+    case '~':
+      switch (param) {
+        case 1: case 7: return KEY_HOME;
+        case 4: case 8: return KEY_END;
+        case 5:         return KEY_PGUP;
+        case 6:         return KEY_PGDN;
+      }
+      return 0;
+    default:
+      return 0;
+  }
+}
+
+/**
+ * @brief Find a process of the displayed list by PID.
+ *
+ * @return The process, or NULL if it is not in the list.
+ */
+static const proc_info_t *find_shown(const proc_list_t *list, uint64_t pid) {
+  if (!list)
+    return NULL;
+
+  for (size_t i = 0; i < list->count; ++ i) {
+    if (list->procs[i].pid == pid)
+      return &list->procs[i];
+  }
+  return NULL;
+}
+
+/**
+ * @brief Show or hide a whole group of columns.
+ *
+ * The group is hidden if all of it is shown, shown otherwise.
+ */
+static void toggle_columns(column_set_t *set, const char *group) {
+  column_set_t bits = 0;
+  if (columns_parse(group, &bits, NULL) != MYTOP_OK)
+    return;
+
+  if ((*set & bits) == bits)
+    *set &= ~bits;
+  else
+    *set |= bits;
+}
+
+/**
+ * @brief Work out what the shown columns and the sort key read.
+ *
+ * The per-core view groups processes by last CPU and ranks them by CPU%,
+ * so it needs the P and CPU columns whether they are shown or not.
+ *
+ * @return SRC_* bits the UI can rely on from the next snapshot.
+ */
+static uint32_t needed_sources(column_set_t set, sort_mode_t mode, bool cores, int *stat_fields) {
+  if (cores)
+    columns_parse("+P,+CPU", &set, NULL);
+
+  return columns_sources(set, mode, stat_fields);
+}
+
+/**
+ * Helper function
+ *
+ * @brief Tell the collector which per-process files the display needs.
+ */
+static uint32_t request_sources(pipeline_t *pl, column_set_t set, sort_mode_t mode, bool cores) {
+  int stat_fields;
+  uint32_t sources = needed_sources(set, mode, cores, &stat_fields);
+  pipeline_set_sources(pl, sources, stat_fields);
+  return sources;
+}
+
+/**
+ * @brief Carry out a finished column prompt.
+ *
+ * @return true if the column set changed.
+ */
+static bool run_columns_prompt(const char *line, column_set_t *set, char *msg, size_t msg_sz) {
+  const char *bad = NULL;
+  mytop_status_t st = columns_parse(line, set, &bad);
+  if (st == MYTOP_ERR_PARSE)
+    snprintf(msg, msg_sz, "Unknown column: %.*s", (int)strcspn(bad, ", "), bad);
+  else if (st == MYTOP_NO_DATA)
+    snprintf(msg, msg_sz, "At least one column must be shown");
+  return st == MYTOP_OK;
+}
+
+/**
+ * @brief Carry out a finished signal prompt.
+ *
+ * @param kind   Prompt that was answered.
+ * @param line   Answer: a signal for PROMPT_SIGNAL, "[SIGNAL] PATTERN"
+ *               for PROMPT_MATCH (the signal defaults to TERM).
+ * @param track  Tracking table holding the pidfds.
+ * @param list   Process list on screen.
+ * @param pid    Target of PROMPT_SIGNAL.
+ * @param start  Start time of that target.
+ * @param msg    Outcome shown to the user. [out]
+ * @param msg_sz Size of msg.
+ */
+static void run_signal_prompt(prompt_kind_t kind, char *line, const proc_track_t *track,
+                              const proc_list_t *list, uint64_t pid, uint64_t start,
+                              char *msg, size_t msg_sz) {
+  int sig = SIGTERM;
+  const char *pattern = line;
+
+  if (kind == PROMPT_SIGNAL) {
+    if (*skip_spaces(line) != '\0')
+      sig = parse_signal(line);
+  } else {
+    // A leading word that names a signal selects it, the rest is the pattern
+    char *space = strchr(line, ' ');
+    if (space) {
+      *space = '\0';
+      int named = parse_signal(line);
+      if (named != -1) {
+        sig = named;
+        pattern = skip_spaces(space + 1);
+      } else {
+        *space = ' ';
+      }
+    }
+  }
+
+  if (sig == -1) {
+    snprintf(msg, msg_sz, "Unknown signal: %s", line);
+    return;
+  }
+
+  if (kind == PROMPT_SIGNAL) {
+    mytop_status_t st = track_signal(track, pid, start, sig);
+    if (st == MYTOP_OK)
+      snprintf(msg, msg_sz, "SIG%s sent to PID %" PRIu64, signal_name(sig), pid);
+    else if (st == MYTOP_NO_FILE)
+      snprintf(msg, msg_sz, "PID %" PRIu64 " has exited", pid);
+    else
+      snprintf(msg, msg_sz, "Cannot signal PID %" PRIu64 ": %s", pid, strerror(errno));
+    return;
+  }
+
+  if (*pattern == '\0') {
+    snprintf(msg, msg_sz, "No pattern given");
+    return;
+  }
+
+  size_t failed;
+  size_t sent = track_signal_matching(track, list, pattern, sig, &failed);
+  snprintf(msg, msg_sz, "SIG%s sent to %zu processes matching \"%s\" (%zu failed)",
+           signal_name(sig), sent, pattern, failed);
+}
+
+/**
+ * @brief Run headless as the shared snapshot collector (mytopd).
+ *
+ * Scans /proc once per interval and publishes every snapshot to the
+ * shared-memory segment, so any number of viewers cost a single scan.
+ *
+ * @param shm_name    POSIX shm object name.
+ * @param shm_shared  Let other users' viewers read the snapshot.
+ * @param interval_ms Refresh interval.
+ * @param acct        Per-process CPU accounting backend.
+ * @param children    Charge reaped children's CPU time to their parents.
+ * @param use_uring   Batch the /proc reads through io_uring when possible.
+ *
+ * @return Process exit code.
+ */
+static int run_collector(const char *shm_name, bool shm_shared, uint64_t interval_ms,
+                         cpu_acct_t acct, bool children, bool use_uring) {
+  struct sigaction sa;
+  memset(&sa, 0, sizeof(sa));
+  sa.sa_handler = on_stop_signal;
+  sigaction(SIGINT, &sa, NULL);
+  sigaction(SIGTERM, &sa, NULL);
+
+  str_table_t *strtab = create_str_table();
+  proc_list_t *prev_procs_list = create_procs_list(0, strtab);
+  proc_list_t *curr_procs_list = create_procs_list(0, strtab);
+  int meminfo_fd = meminfo_open();
+
+  shm_snapshot_t shm;
+  int exit_code = 1;
+  if (!strtab || !prev_procs_list || !curr_procs_list || meminfo_fd == -1 ||
+      shm_publisher_open(&shm, shm_name, interval_ms, shm_shared) != MYTOP_OK)
+    goto out;
+
+  prev_procs_list->acct = acct;
+  curr_procs_list->acct = acct;
+  prev_procs_list->children = curr_procs_list->children = children;
+  // Viewers may show any column, but other users never see /proc/[pid]/io
+  uint32_t sources = shm_shared ? SRC_SCAN & ~SRC_IO : SRC_SCAN;
+  prev_procs_list->sources = curr_procs_list->sources = sources;
+  uring_t uring = { .fd = -1 };
+  if (use_uring)
+    procs_attach_uring(&uring, prev_procs_list, curr_procs_list);
+
+  LOG_INFO("Core", "Collector publishing snapshots to %s", shm_name);
+
+  mem_info_t mem_info = {0};
+  cpu_stat_t prev_cpu_info = {0}, curr_cpu_info = {0};
+
+  parse_cpu_stat(&prev_cpu_info);
+  parse_procs(prev_procs_list);
+
+  while (!stop_requested) {
+    // Interrupted early by a stop signal
+    sleep_ms(interval_ms);
+    if (stop_requested)
+      break;
+
+    parse_cpu_stat(&curr_cpu_info);
+    parse_meminfo(meminfo_fd, &mem_info);
+
+    clear_procs_list(curr_procs_list);
+    parse_procs(curr_procs_list);
+
+    double cpu_usage = calculate_cpu_usage(&prev_cpu_info, &curr_cpu_info, NULL);
+    calculate_procs_cpu(prev_procs_list, curr_procs_list, NULL);
+    trim_procs_list(curr_procs_list);
+
+    if (shm_publish(&shm, &mem_info, cpu_usage, curr_procs_list) != MYTOP_OK)
+      LOG_WARN("Shm", "Failed to publish snapshot");
+
+    prev_cpu_info = curr_cpu_info;
+
+    proc_list_t *temp = prev_procs_list;
+    prev_procs_list = curr_procs_list;
+    curr_procs_list = temp;
+  }
+
+  shm_close(&shm);
+  uring_free(&uring);
+  exit_code = 0;
+  LOG_INFO("Core", "Collector exited gracefully.");
+
+out:
+  if (meminfo_fd != -1) close(meminfo_fd);
+  free_procs_list(prev_procs_list);
+  free_procs_list(curr_procs_list);
+  free_str_table(strtab);
+  return exit_code;
+}
+
+/**
+ * @brief Run non-interactively, streaming every tick to stdout.
+ *
+ * @param interval_ms Refresh interval.
+ * @param acct        Per-process CPU accounting backend.
+ * @param children    Charge reaped children's CPU time to their parents.
+ * @param fmt         Output format.
+ * @param iterations  Number of ticks to write (0 = until stopped).
+ * @param sort        Sort the processes before writing.
+ * @param sort_mode   Sort key when sort is set.
+ * @param top_k       Processes written per tick (0 = all).
+ * @param use_uring   Batch the /proc reads through io_uring when possible.
+ * @param slices      Re-read 1/N of the processes per tick (0 or 1 = all).
+ * @param watch       Only follow these processes (ignored unless watch_enabled()).
+ *
+ * @return Process exit code.
+ */
+static int run_batch(uint64_t interval_ms, cpu_acct_t acct, bool children, batch_format_t fmt,
+                     uint64_t iterations, bool sort, sort_mode_t sort_mode, size_t top_k,
+                     bool use_uring, uint32_t slices, watch_t *watch) {
+  struct sigaction sa;
+  memset(&sa, 0, sizeof(sa));
+  sa.sa_handler = on_stop_signal;
+  sigaction(SIGINT, &sa, NULL);
+  sigaction(SIGTERM, &sa, NULL);
+  // A closed pipe ends the run through EPIPE instead of killing us
+  signal(SIGPIPE, SIG_IGN);
+
+  str_table_t *strtab = create_str_table();
+  proc_list_t *prev_procs_list = create_procs_list(0, strtab);
+  proc_list_t *curr_procs_list = create_procs_list(0, strtab);
+  int meminfo_fd = meminfo_open();
+
+  batch_writer_t writer;
+  int exit_code = 1;
+  if (!strtab || !prev_procs_list || !curr_procs_list || meminfo_fd == -1 ||
+      batch_writer_open(&writer, STDOUT_FILENO, fmt) != MYTOP_OK)
+    goto out;
+
+  prev_procs_list->acct = acct;
+  curr_procs_list->acct = acct;
+  prev_procs_list->children = curr_procs_list->children = children;
+  // Records carry stat fields up to RSS (24), schedstat and the command
+  prev_procs_list->stat_fields = curr_procs_list->stat_fields = 24;
+  uring_t uring = { .fd = -1 };
+  if (watch_enabled(watch))
+    procs_attach_watch(watch, prev_procs_list, curr_procs_list);
+  else if (use_uring)
+    procs_attach_uring(&uring, prev_procs_list, curr_procs_list);
+
+  mem_info_t mem_info = {0};
+  cpu_stat_t prev_cpu_info = {0}, curr_cpu_info = {0};
+
+  parse_cpu_stat(&prev_cpu_info);
+  parse_procs(prev_procs_list);
+
+  exit_code = 0;
+  for (uint64_t tick = 0; !stop_requested && (iterations == 0 || tick < iterations); ++ tick) {
+    sleep_ms(interval_ms);
+    if (stop_requested)
+      break;
+
+    parse_cpu_stat(&curr_cpu_info);
+    parse_meminfo(meminfo_fd, &mem_info);
+
+    clear_procs_list(curr_procs_list);
+    parse_procs_sampled(curr_procs_list, prev_procs_list, slices, tick);
+
+    double cpu_usage = calculate_cpu_usage(&prev_cpu_info, &curr_cpu_info, NULL);
+    calculate_procs_cpu(prev_procs_list, curr_procs_list, NULL);
+    if (sort)
+      sort_procs_incremental(prev_procs_list, curr_procs_list, sort_mode);
+    trim_procs_list(curr_procs_list);
+
+    size_t limit = top_k ? top_k : curr_procs_list->count;
+    if (batch_write_tick(&writer, &mem_info, cpu_usage, curr_procs_list, limit) != MYTOP_OK) {
+      // The reader went away (e.g. "| head"): not an error for a pipeline
+      if (writer.error != EPIPE) {
+        LOG_ERROR("Batch", "Cannot write output: %s", strerror(writer.error));
+        exit_code = 1;
+      }
+      break;
+    }
+
+    prev_cpu_info = curr_cpu_info;
+
+    proc_list_t *temp = prev_procs_list;
+    prev_procs_list = curr_procs_list;
+    curr_procs_list = temp;
+  }
+
+  batch_writer_close(&writer);
+  uring_free(&uring);
+
+out:
+  if (meminfo_fd != -1) close(meminfo_fd);
+  free_procs_list(prev_procs_list);
+  free_procs_list(curr_procs_list);
+  watch_free(watch);
+  free_str_table(strtab);
+  return exit_code;
+}
+
+/**
+ * @brief Print command line usage.
+ */
+static void print_usage(const char *prog) {
+  printf("Usage: %s [options]\n", prog);
+  printf("  -d, --delay SECS        Refresh interval in seconds (default 1, min %.2f)\n",
+         MIN_INTERVAL_MS / 1000.0);
+  printf("      --jiffies           Use stat jiffies instead of schedstat for CPU%%\n");
+  printf("      --children          Add the CPU time of reaped children to their parent\n");
+  printf("      --no-uring          Read /proc with read() even where io_uring works\n");
+  printf("      --columns LIST      Process columns, e.g. pid,cpu,res,command or +shr,-pgrp\n");
+  printf("  -x, --smaps             Show PSS/USS/SWAP columns (smaps_rollup)\n");
+  printf("      --smaps-budget N    smaps_rollup reads per tick (default %d, max %d)\n",
+         SMAPS_BUDGET, SMAPS_MAX_BUDGET);
+  printf("  -f, --faults            Show fault, I/O delay and context switch rate columns\n");
+  printf("  -i, --io                Show disk and network throughput panels\n");
+  printf("  -D, --daemon            Run as the shared snapshot collector (mytopd)\n");
+  printf("      --shm NAME          Shared snapshot name (default %s.<uid>)\n", SHM_DEFAULT_NAME);
+  printf("      --shm-shared        Collector: let other users read the snapshot (no I/O columns)\n");
+  printf("      --no-shm            Always collect locally, ignore a running collector\n");
+  printf("      --psi-trigger MS    Refresh at once when a resource stalls MS ms within 2s\n");
+  printf("      --max-memory MB     Keep only the top processes that fit in MB (rest summarized)\n");
+  printf("  -p, --pid PID,...       Only follow these processes (no /proc walk)\n");
+  printf("      --pidfile FILE      Follow the process whose PID is in FILE\n");
+  printf("      --match NAME        Follow the processes whose name contains NAME\n");
+  printf("      --sample N          Re-read 1/N of the processes per tick plus the top %d\n",
+         SAMPLE_HOT_PROCS);
+  printf("  -b, --batch             Stream records to stdout instead of the screen\n");
+  printf("      --format FMT        Batch format: json (default), csv or tsv\n");
+  printf("  -n, --iterations N      Batch ticks to write before exiting (default: forever)\n");
+  printf("      --sort KEY          Batch sort key: cpu, mem or pid (default: unsorted)\n");
+  printf("      --top K             Batch processes per tick (default: all, sorts by cpu)\n");
+  printf("  -h, --help              Show this help\n");
+}
+
+int main(int argc, char *argv[]) {
+  uint64_t start_ns = monotonic_ns();
+
+  column_set_t columns = columns_default();
+  bool show_exits = false;
+  bool show_cores = false;
+  size_t smaps_budget = SMAPS_BUDGET;
+  char default_shm[64];
+  snprintf(default_shm, sizeof(default_shm), "%s.%u", SHM_DEFAULT_NAME, (unsigned)geteuid());
+  const char *shm_name = default_shm;
+  bool shm_shared = false;
+  bool use_shm = true;
+  uint64_t interval_ms = 1000;
+  bool interval_set = false;
+  bool force_jiffies = false;
+  bool children = false;
+  bool use_uring = true;
+  uint64_t psi_trigger_ms = 0;
+  uint64_t max_memory = 0;
+  uint32_t sample_slices = 0;
+  static watch_t watch;
+  bool show_io = false;
+  bool batch = false;
+  batch_format_t batch_fmt = FMT_JSON;
+  uint64_t batch_iterations = 0;
+  bool batch_sort = false;
+  sort_mode_t batch_sort_mode = SORT_CPU;
+  uint64_t batch_top = 0;
+
+  // Invoked as "mytopd": collector mode
+  const char *prog = strrchr(argv[0], '/');
+  prog = prog ? prog + 1 : argv[0];
+  bool collector = strcmp(prog, "mytopd") == 0;
+
+  enum { OPT_SMAPS_BUDGET = 256, OPT_SHM, OPT_SHM_SHARED, OPT_NO_SHM, OPT_JIFFIES, OPT_PSI_TRIGGER,
+         OPT_FORMAT, OPT_SORT, OPT_TOP, OPT_COLUMNS, OPT_NO_URING,
+         OPT_MAX_MEMORY, OPT_SAMPLE, OPT_PIDFILE, OPT_MATCH,
+         OPT_CHILDREN };
+  static const struct option long_opts[] = {
+    {"delay",        required_argument, NULL, 'd'},
+    {"jiffies",      no_argument,       NULL, OPT_JIFFIES},
+    {"children",     no_argument,       NULL, OPT_CHILDREN},
+    {"no-uring",     no_argument,       NULL, OPT_NO_URING},
+    {"columns",      required_argument, NULL, OPT_COLUMNS},
+    {"smaps",        no_argument,       NULL, 'x'},
+    {"smaps-budget", required_argument, NULL, OPT_SMAPS_BUDGET},
+    {"faults",       no_argument,       NULL, 'f'},
+    {"io",           no_argument,       NULL, 'i'},
+    {"daemon",       no_argument,       NULL, 'D'},
+    {"shm",          required_argument, NULL, OPT_SHM},
+    {"shm-shared",   no_argument,       NULL, OPT_SHM_SHARED},
+    {"no-shm",       no_argument,       NULL, OPT_NO_SHM},
+    {"psi-trigger",  required_argument, NULL, OPT_PSI_TRIGGER},
+    {"max-memory",   required_argument, NULL, OPT_MAX_MEMORY},
+    {"sample",       required_argument, NULL, OPT_SAMPLE},
+    {"pid",          required_argument, NULL, 'p'},
+    {"pidfile",      required_argument, NULL, OPT_PIDFILE},
+    {"match",        required_argument, NULL, OPT_MATCH},
+    {"batch",        no_argument,       NULL, 'b'},
+    {"format",       required_argument, NULL, OPT_FORMAT},
+    {"iterations",   required_argument, NULL, 'n'},
+    {"sort",         required_argument, NULL, OPT_SORT},
+    {"top",          required_argument, NULL, OPT_TOP},
+    {"help",         no_argument,       NULL, 'h'},
+    {NULL, 0, NULL, 0}
+  };
+
+  int opt;
+  while ((opt = getopt_long(argc, argv, "d:xfiDbn:p:h", long_opts, NULL)) != -1) {
+    switch (opt) {
+      case 'd':
+        if (!parse_interval(optarg, &interval_ms)) {
+          fprintf(stderr, "Invalid interval: %s\n", optarg);
+          return 1;
+        }
+        interval_set = true;
+        break;
+      case 'p':
+        if (watch_add_pids(&watch, optarg) != MYTOP_OK) {
+          fprintf(stderr, "Invalid PID list: %s (at most %d PIDs)\n", optarg, WATCH_MAX_PROCS);
+          return 1;
+        }
+        break;
+      case OPT_PIDFILE:
+        watch.pidfile = optarg;
+        break;
+      case OPT_MATCH:
+        if (optarg[0] == '\0' || strlen(optarg) >= sizeof(watch.match)) {
+          fprintf(stderr, "Invalid name pattern: %s\n", optarg);
+          return 1;
+        }
+        strcpy(watch.match, optarg);
+        break;
+      case OPT_JIFFIES:
+        force_jiffies = true;
+        break;
+      case OPT_CHILDREN:
+        children = true;
+        break;
+      case OPT_NO_URING:
+        use_uring = false;
+        break;
+      case 'D':
+        collector = true;
+        break;
+      case OPT_SHM:
+        shm_name = optarg;
+        break;
+      case OPT_SHM_SHARED:
+        shm_shared = true;
+        break;
+      case OPT_NO_SHM:
+        use_shm = false;
+        break;
+      case OPT_COLUMNS: {
+        const char *bad = NULL;
+        mytop_status_t st = columns_parse(optarg, &columns, &bad);
+        if (st != MYTOP_OK) {
+          if (st == MYTOP_ERR_PARSE)
+            fprintf(stderr, "Unknown column: %.*s\n", (int)strcspn(bad, ", "), bad);
+          else
+            fprintf(stderr, "No column selected: %s\n", optarg);
+          return 1;
+        }
+        break;
+      }
+      case 'x':
+        columns_parse("+" COLUMNS_SMAPS, &columns, NULL);
+        break;
+      case 'f':
+        columns_parse("+" COLUMNS_FAULTS, &columns, NULL);
+        break;
+      case 'i':
+        show_io = true;
+        break;
+      case OPT_SMAPS_BUDGET: {
+        uint64_t budget;
+        if (str_to_num(optarg, 10, NUM_U64, &budget) != MYTOP_OK ||
+            budget == 0 || budget > SMAPS_MAX_BUDGET) {
+          fprintf(stderr, "Invalid smaps budget: %s\n", optarg);
+          return 1;
+        }
+        smaps_budget = budget;
+        break;
+      }
+      case OPT_PSI_TRIGGER: {
+        uint64_t stall_ms;
+        if (str_to_num(optarg, 10, NUM_U64, &stall_ms) != MYTOP_OK ||
+            stall_ms == 0 || stall_ms * 1000 >= PSI_WINDOW_US) {
+          fprintf(stderr, "Invalid PSI trigger threshold: %s\n", optarg);
+          return 1;
+        }
+        psi_trigger_ms = stall_ms;
+        break;
+      }
+      case OPT_MAX_MEMORY: {
+        uint64_t mb;
+        if (str_to_num(optarg, 10, NUM_U64, &mb) != MYTOP_OK || mb == 0 || mb > UINT32_MAX) {
+          fprintf(stderr, "Invalid memory limit: %s\n", optarg);
+          return 1;
+        }
+        max_memory = mb << 20;
+        break;
+      }
+      case OPT_SAMPLE: {
+        uint64_t slices;
+        if (str_to_num(optarg, 10, NUM_U64, &slices) != MYTOP_OK ||
+            slices == 0 || slices > SAMPLE_MAX_SLICES) {
+          fprintf(stderr, "Invalid sample slices: %s (1-%d)\n", optarg, SAMPLE_MAX_SLICES);
+          return 1;
+        }
+        sample_slices = (uint32_t)slices;
+        break;
+      }
+      case 'b':
+        batch = true;
+        break;
+      case OPT_FORMAT:
+        if (strcmp(optarg, "json") == 0)      batch_fmt = FMT_JSON;
+        else if (strcmp(optarg, "csv") == 0)  batch_fmt = FMT_CSV;
+        else if (strcmp(optarg, "tsv") == 0)  batch_fmt = FMT_TSV;
+        else {
+          fprintf(stderr, "Invalid format: %s\n", optarg);
+          return 1;
+        }
+        break;
+      case 'n':
+        if (str_to_num(optarg, 10, NUM_U64, &batch_iterations) != MYTOP_OK ||
+            batch_iterations == 0) {
+          fprintf(stderr, "Invalid iteration count: %s\n", optarg);
+          return 1;
+        }
+        break;
+      case OPT_SORT:
+        batch_sort = true;
+        if (strcmp(optarg, "cpu") == 0)      batch_sort_mode = SORT_CPU;
+        else if (strcmp(optarg, "mem") == 0) batch_sort_mode = SORT_MEM;
+        else if (strcmp(optarg, "pid") == 0) batch_sort_mode = SORT_PID;
+        else {
+          fprintf(stderr, "Invalid sort key: %s\n", optarg);
+          return 1;
+        }
+        break;
+      case OPT_TOP:
+        if (str_to_num(optarg, 10, NUM_U64, &batch_top) != MYTOP_OK || batch_top == 0) {
+          fprintf(stderr, "Invalid process count: %s\n", optarg);
+          return 1;
+        }
+        break;
+      case 'h':
+        print_usage(argv[0]);
+        return 0;
+      default:
+        print_usage(argv[0]);
+        return 1;
+    }
+  }
+
+  // Nanosecond accounting when the kernel provides it
+  cpu_acct_t acct = ACCT_JIFFIES;
+  if (!force_jiffies) {
+    if (schedstat_available())
+      acct = ACCT_SCHEDSTAT;
+    else
+      LOG_INFO("Core", "schedstat unavailable, using jiffies for process CPU%%");
+  }
+
+  // A watch list is cheap enough to refresh at 10 Hz, and never reads a shared snapshot
+  if (watch_enabled(&watch)) {
+    if (collector) {
+      fprintf(stderr, "The collector publishes every process: -p, --pidfile and --match "
+                      "are for viewers\n");
+      return 1;
+    }
+    if (!interval_set)
+      interval_ms = WATCH_INTERVAL_MS;
+    use_shm = false;
+  }
+
+  if (collector)
+    return run_collector(shm_name, shm_shared, interval_ms, acct, children, use_uring);
+  if (batch) {
+    // The top K only make sense in some order, and sampling re-reads the top
+    if (batch_top > 0 || sample_slices > 1) batch_sort = true;
+    return run_batch(interval_ms, acct, children, batch_fmt, batch_iterations, batch_sort,
+                     batch_sort_mode, (size_t)batch_top, use_uring, sample_slices, &watch);
+  }
 
   LOG_INFO("Core", "MyTop starting up...");
 
   sort_mode_t sort_mode = SORT_CPU;
 
-  proc_list_t *prev_procs_list = create_procs_list(0);
-  if (!prev_procs_list) return 1;
-  proc_list_t *curr_procs_list = create_procs_list(0);
-  if (!curr_procs_list) {
-    free_procs_list(prev_procs_list);
+  // History, smaps cache and pidfds belong to the UI thread
+  proc_track_t *track = create_proc_track(0);
+  if (!track)
+    return 1;
+
+  // Hidden columns cost no reads, from the very first scan
+  int stat_fields;
+  uint32_t sources = needed_sources(columns, sort_mode, show_cores, &stat_fields);
+
+  // Scanning, deltas and sorting run on the collector thread
+  pipeline_t *pl = malloc(sizeof(pipeline_t));
+  if (!pl || pipeline_start(pl, interval_ms, acct, children, use_shm ? shm_name : NULL,
+                            psi_trigger_ms, sources, stat_fields, use_uring,
+                            max_memory, sample_slices, &watch) != MYTOP_OK) {
+    free(pl);
+    free_proc_track(track);
     return 1;
   }
 
   sys_info_t sys_info = {0};
-  mem_info_t mem_info = {0};
-  cpu_stat_t prev_cpu_info = {0}, curr_cpu_info = {0};
-  
-  // 1. Initial sampling
   parse_version(&sys_info);
-  parse_meminfo(&mem_info);
-  parse_cpu_stat(&prev_cpu_info);
-  parse_procs(prev_procs_list);
+
+  // A resize interrupts poll() so the frame is redrawn at once
+  struct sigaction sa;
+  memset(&sa, 0, sizeof(sa));
+  sa.sa_handler = on_resize_signal;
+  sigaction(SIGWINCH, &sa, NULL);
 
   // Activacate Raw Mode
   if (set_raw_mode(true) != 0) {
@@ -41,109 +781,214 @@ int main() {
   // Hide the cursor
   term_hide_cursor();
 
-  sleep(1);
-
-  uint64_t total_delta;
+  proc_view_t view = {0};
+  snapshot_t *snap = NULL;         // Snapshot on screen (NULL until the first one)
+  size_t visible = 0;              // Process rows in the window
+  prompt_kind_t prompt = PROMPT_NONE;
+  char prompt_buf[PROMPT_LEN] = "";
+  size_t prompt_len = 0;
+  uint64_t prompt_pid = 0, prompt_start = 0;  // Target fixed when the prompt opened
+  char status_msg[PROMPT_LEN + 64] = "";
+  uint64_t status_until_ns = 0;
+  uint64_t first_frame_ns = 0;
   int running = 1;
   while (running) {
-    // 2. Data acquisition
-    parse_cpu_stat(&curr_cpu_info);
-    parse_meminfo(&mem_info);
-
-    curr_procs_list->count = 0;
-    parse_procs(curr_procs_list);
+    // 1. Take the newest snapshot; the collector keeps scanning meanwhile
+    bool fresh = pipeline_acquire(pl);
+    if (fresh) {
+      snap = pipeline_front(pl);
+      track_update(track, snap->procs);
+      // Sorted before the last key change: order just the window now
+      if (snap->sort_mode != sort_mode) {
+        view_resort(&view, snap->procs, sort_mode, visible);
+        snap->sort_mode = sort_mode;
+      }
+    }
 
-    // 3. Compute CPU usage percentage and processes CPU usage percentage
-    double cpu_usage = calculate_cpu_usage(&prev_cpu_info, &curr_cpu_info, &total_delta);
-    calculate_procs_cpu(prev_procs_list, curr_procs_list, total_delta);
+    if (!snap)
+      goto wait_input;
 
-    // 4. Sort by CPU usage percentage
-    sort_procs_by_mode(curr_procs_list, sort_mode);
+    int header_lines = HEADER_LINES + snap->psi.available +
+                       lifecycle_panel_lines(&snap->lc, show_exits) +
+                       (show_io && snap->io_ok ? iostat_panel_lines(&snap->io) : 0);
+    visible = procs_visible_count(snap->procs, header_lines);
+    if (fresh) {
+      view_follow(&view, snap->procs, visible);
+      // Only the rows on screen pay for smaps_rollup, within the per-tick budget
+      if (sources & SRC_SMAPS)
+        track_refresh_smaps(track, snap->procs, view.offset, visible, smaps_budget);
+      if (sources & SRC_STATUS)
+        track_refresh_ctxsw(track, snap->procs, view.offset, visible);
+    }
 
-    // 5. Simple printing
+    // 2. Simple printing
     // Move cursor to top‑left corner and clear screen
     term_home();
     term_clear_screen();
     // Print system and memory related informations
-    print_system_snapshot(&sys_info, &mem_info);
-    printf("CPU Usage: %.2f%%\n", cpu_usage);
+    print_system_snapshot(&sys_info, &snap->mem);
+    printf("CPU Usage: %.2f%%\n", snap->cpu_usage);
+    print_lifecycle(&snap->lc, snap->procs->count, snap->procs->unread, &snap->procs->dropped,
+                    show_exits);
+    print_pressure(&snap->psi);
+    if (show_io && snap->io_ok)
+      print_iostat(&snap->io);
     printf("\n");
-    // Print processes informations
-    print_procs(curr_procs_list);
+    // Print processes informations, or their placement on the cores
+    if (show_cores) {
+      int rows;
+      get_term_size(&rows, NULL);
+      print_cores(snap->procs, snap->core_usage, snap->ncores, rows - header_lines - 2);
+    } else {
+      print_procs(snap->procs, track, columns, header_lines, &view);
+    }
+    // Prompt or outcome of the last action on the bottom line
+    if (prompt != PROMPT_NONE || monotonic_ns() < status_until_ns) {
+      int rows;
+      get_term_size(&rows, NULL);
+      term_move_cursor(rows, 1);
+      term_clear_line();
+      if (prompt == PROMPT_SIGNAL)
+        printf("Signal for PID %" PRIu64 " [TERM]: %s", prompt_pid, prompt_buf);
+      else if (prompt == PROMPT_MATCH)
+        printf("Signal processes matching ([SIGNAL] PATTERN): %s", prompt_buf);
+      else if (prompt == PROMPT_COLUMNS)
+        printf("Columns (NAME,... or +NAME -NAME): %s", prompt_buf);
+      else
+        printf("%s", status_msg);
+    }
     // Force a flush; otherwise, output may be buffered in Raw Mode
     term_refresh();
+    if (first_frame_ns == 0)
+      first_frame_ns = monotonic_ns();
+    // Pin the sampled processes once the frame is out
+    if (fresh)
+      track_open_pidfds(track, snap->procs);
 
-    // 6. Update
-    prev_cpu_info = curr_cpu_info;
-    
-    proc_list_t *temp = prev_procs_list;
-    prev_procs_list = curr_procs_list;
-    curr_procs_list = temp;
+    // 3. Wait for a key, a snapshot or a resize (the status line expires on its own)
+wait_input:;
+    int timeout_ms = -1;
+    uint64_t now = monotonic_ns();
+    if (status_until_ns > now)
+      timeout_ms = (int)((status_until_ns - now + 999999) / 1000000);
+
+    struct pollfd fds[2] = {
+      { .fd = STDIN_FILENO, .events = POLLIN },
+      { .fd = pipeline_notify_fd(pl), .events = POLLIN },
+    };
+
+    int ret = poll(fds, 2, timeout_ms);
+    if (ret <= 0)
+      continue;
 
-    // 7. Intelligent delay (wait for 1 second or until a key press interrupts)
-    struct timeval timeout;
-    timeout.tv_sec = 1;
-    timeout.tv_usec = 0;
-
-    fd_set fds;
-    FD_ZERO(&fds);
-    FD_SET(STDIN_FILENO, &fds);
-
-    int ret = select(STDIN_FILENO + 1, &fds, NULL, NULL, &timeout);
-
-    if (ret > 0) {
-      if (FD_ISSET(STDIN_FILENO, &fds)) {
-        char c;
-        if (read(STDIN_FILENO, &c, 1) == 1) {
-          if (c == 'q' || c == 'Q') {
-            running = 0;
-          } 
-          else if (c == 'm' || c == 'M') {
-            sort_mode = SORT_MEM;
+    if (fds[1].revents & POLLIN)
+      pipeline_drain_notify(pl);
+
+    if (fds[0].revents & (POLLIN | POLLHUP)) {
+      char keys[32];
+      ssize_t n = read(STDIN_FILENO, keys, sizeof(keys));
+      size_t pos = 0;
+      while (running && n > 0 && pos < (size_t)n) {
+        size_t used;
+        int c = decode_key(keys + pos, (size_t)n - pos, &used);
+        pos += used;
+
+        // Typing an answer: the refresh goes on, keys edit the line
+        if (prompt != PROMPT_NONE) {
+          int done = term_edit_line(prompt_buf, &prompt_len, sizeof(prompt_buf), c);
+          if (done == 1 && prompt == PROMPT_COLUMNS) {
+            if (run_columns_prompt(prompt_buf, &columns, status_msg, sizeof(status_msg))) {
+              sources = request_sources(pl, columns, sort_mode, show_cores);
+              // Fill the new columns at once
+              pipeline_refresh(pl);
+            } else {
+              status_until_ns = monotonic_ns() + STATUS_SHOW_MS * 1000000ull;
+            }
+          } else if (done == 1) {
+            run_signal_prompt(prompt, prompt_buf, track, snap ? snap->procs : NULL,
+                              prompt_pid, prompt_start, status_msg, sizeof(status_msg));
+            status_until_ns = monotonic_ns() + STATUS_SHOW_MS * 1000000ull;
+            // Show the outcome of the signal
+            pipeline_refresh(pl);
           }
-          else if (c == 'p' || c == 'P') {
-            sort_mode = SORT_PID;
+          if (done != 0) {
+            prompt = PROMPT_NONE;
+            prompt_len = 0;
+            prompt_buf[0] = '\0';
+            term_hide_cursor();
           }
-          else if (c == 'c' || c == 'C') {
-            sort_mode = SORT_CPU;
+          continue;
+        }
+
+        if (c == 'q' || c == 'Q') {
+          running = 0;
+        } 
+        else if (c == 'm' || c == 'M' || c == 'p' || c == 'P' || c == 'c' || c == 'C') {
+          sort_mode = (c == 'm' || c == 'M') ? SORT_MEM :
+                      (c == 'p' || c == 'P') ? SORT_PID :
+                                               SORT_CPU;
+          // Order just the window now, the collector sorts the next snapshot in full
+          pipeline_set_sort(pl, sort_mode);
+          sources = request_sources(pl, columns, sort_mode, show_cores);
+          if (snap) {
+            view_resort(&view, snap->procs, sort_mode, visible);
+            snap->sort_mode = sort_mode;
           }
-          else if (c == 'k' || c == 'K') {
-            // 1. Move cursor to the bottom‑most position (rows, 1)
-            int rows, cols;
-            get_term_size(&rows, &cols);
-            term_move_cursor(rows, 1);
-            // 2. Switch blocking mode
-            if (set_raw_mode(false) != 0) {
-              LOG_WARN("Term", "Failed to enable normal mode");
-            }
-            // 3. Clear line
-            term_clear_line();
-            // 4. Print promt
-            printf("PID to kill: ");
-            term_refresh();
-            // 5. Read input
-            char pid_buf[32];
+        }
+        else if (c == KEY_UP || c == KEY_DOWN || c == KEY_PGUP ||
+                 c == KEY_PGDN || c == KEY_HOME || c == KEY_END) {
+          long page = visible > 1 ? (long)visible - 1 : 1;
+          long delta = c == KEY_UP   ? -1 :
+                       c == KEY_DOWN ?  1 :
+                       c == KEY_PGUP ? -page :
+                       c == KEY_PGDN ?  page :
+                       c == KEY_HOME ? -LONG_MAX :
+                                        LONG_MAX;
+          if (snap)
+            view_move(&view, snap->procs, sort_mode, delta, visible);
+        }
+        else if (c == 'x' || c == 'X') {
+          toggle_columns(&columns, COLUMNS_SMAPS);
+          sources = request_sources(pl, columns, sort_mode, show_cores);
+        }
+        else if (c == 'i' || c == 'I') {
+          show_io = !show_io;
+        }
+        else if (c == 'f' || c == 'F') {
+          // Start from the current list so it can be edited in place
+          columns_format(columns, prompt_buf, sizeof(prompt_buf));
+          prompt_len = strlen(prompt_buf);
+          prompt = PROMPT_COLUMNS;
+          term_show_cursor();
+        }
+        else if (c == 'e' || c == 'E') {
+          show_exits = !show_exits;
+        }
+        else if (c == '1') {
+          show_cores = !show_cores;
+          sources = request_sources(pl, columns, sort_mode, show_cores);
+          pipeline_refresh(pl);
+        }
+        else if (c == 'k') {
+          const proc_info_t *p = snap ? find_shown(snap->procs, view.selected_pid) : NULL;
+          if (p) {
+            prompt = PROMPT_SIGNAL;
+            prompt_pid = p->pid;
+            prompt_start = p->starttime;
+            term_show_cursor();
+          } else {
+            snprintf(status_msg, sizeof(status_msg), "No process selected");
+            status_until_ns = monotonic_ns() + STATUS_SHOW_MS * 1000000ull;
+          }
+        }
+        else if (c == 'K') {
+          // Patterns match command lines, which are only read for COMMAND
+          if (snap && !(snap->procs->sources & SRC_CMDLINE)) {
+            snprintf(status_msg, sizeof(status_msg), "Show the COMMAND column to match processes");
+            status_until_ns = monotonic_ns() + STATUS_SHOW_MS * 1000000ull;
+          } else {
+            prompt = PROMPT_MATCH;
             term_show_cursor();
-            term_read_line(pid_buf, sizeof(pid_buf));
-            term_hide_cursor();
-            // 6. Kill
-            int64_t pid;
-            str_to_num(pid_buf, 10, NUM_I64,  &pid);
-            if (pid > 0) {
-              if (kill(pid, SIGTERM) == 0) {
-                printf("\nSignal sent to PID %d", (int)pid);
-              } else {
-                LOG_ERROR("Main", "Failed to send signal");
-              }
-            }
-            // 7. Pause for a moment to let the user see the results
-            term_refresh();
-            sleep(1);
-
-            // 8. Switch blocking mode
-            if (set_raw_mode(true) != 0) {
-              LOG_WARN("Term", "Failed to enable raw mode");
-            }
           }
         }
       }
@@ -156,9 +1001,13 @@ int main() {
   // Restore terminal mode
   set_raw_mode(false);
 
-  free_procs_list(prev_procs_list);
-  free_procs_list(curr_procs_list);
+  pipeline_stop(pl);
+  free(pl);
+  free_proc_track(track);
 
+  if (first_frame_ns != 0)
+    LOG_INFO("Core", "First frame drawn %.1f ms after start",
+             (double)(first_frame_ns - start_ns) / 1e6);
   LOG_INFO("Core", "MyTop exited gracefully.");
 
   return 0;
@@ -0,0 +1,515 @@
+#include "log.h"
+#include "mytop.h"
+#include "mytop_types.h"
+#include "utils.h"
+#include <errno.h>
+#include <signal.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/eventfd.h>
+#include <poll.h>
+#include <unistd.h>
+
+#define SNAP_INDEX 0x3u   // Slot number bits of pipeline_t.middle
+#define SNAP_FRESH 0x4u   // The middle slot has not been taken by the UI yet
+#define WARMUP_MS  100    // First measured sample after the estimated frame
+#define FIRST_SCAN_MS 20  // Reading time of the first frame's scan (the rest follows)
+
+/**
+ * Helper function
+ *
+ * @brief Bump an eventfd counter so its reader wakes up.
+ */
+static void event_signal(int fd) {
+  uint64_t one = 1;
+  // Only fails when the counter would overflow, which still wakes the reader
+  if (write(fd, &one, sizeof(one)) < 0)
+    return;
+}
+
+/**
+ * Helper function
+ *
+ * @brief Reset an eventfd counter.
+ */
+static void event_drain(int fd) {
+  uint64_t count;
+  if (read(fd, &count, sizeof(count)) < 0)
+    return;
+}
+
+/**
+ * Helper function
+ *
+ * @brief Fill the back slot from the collector's current state and
+ *        swap it into the middle with a single atomic exchange.
+ */
+static void publish(pipeline_t *pl, const proc_list_t *list, double cpu_usage,
+                    const mem_info_t *mem, sort_mode_t mode) {
+  snapshot_t *snap = &pl->slots[pl->back];
+
+  // The slot was either never published or given back by the UI
+  if (copy_procs_list(snap->procs, list) != MYTOP_OK)
+    LOG_WARN("Pipeline", "Cannot copy %zu processes into the snapshot", list->count);
+  trim_procs_list(snap->procs);
+  snap->mem = *mem;
+  snap->cpu_usage = cpu_usage;
+  snap->psi = pl->psi;
+  if (pl->io_ok)
+    snap->io = pl->io;
+  snap->io_ok = pl->io_ok;
+  snap->lc = pl->lc;
+  memcpy(snap->core_usage, pl->core_usage, sizeof(float) * pl->ncores);
+  snap->ncores = pl->ncores;
+  snap->sort_mode = mode;
+  snap->seq = pl->seq ++;
+
+  // Release: the slot content is visible before its index is
+  uint32_t old = atomic_exchange_explicit(&pl->middle, pl->back | SNAP_FRESH,
+                                          memory_order_acq_rel);
+  pl->back = old & SNAP_INDEX;
+
+  event_signal(pl->notify_fd);
+}
+
+/**
+ * Helper function
+ *
+ * @brief Load the per-process files the UI currently needs into a list.
+ */
+static void apply_sources(pipeline_t *pl, proc_list_t *list) {
+  uint64_t req = atomic_load_explicit(&pl->sources, memory_order_relaxed);
+  list->sources = (uint32_t)req;
+  list->stat_fields = (int)(req >> 32);
+}
+
+/**
+ * Helper function
+ *
+ * @brief Point both lists at the local backend: the watch list, or the
+ *        io_uring reads when they were asked for.
+ */
+static void attach_local(pipeline_t *pl) {
+  if (watch_enabled(pl->watch))
+    procs_attach_watch(pl->watch, pl->prev, pl->curr);
+  else if (pl->use_uring)
+    procs_attach_uring(&pl->uring, pl->prev, pl->curr);
+}
+
+/**
+ * Helper function
+ *
+ * @brief Sort a fresh scan and bound the memory it keeps.
+ *
+ * With a memory budget only the processes that fit are kept, best first
+ * by the active key; otherwise arrays left oversized by a past burst of
+ * processes are released once the count has stayed low.
+ */
+static void sort_and_bound(pipeline_t *pl, proc_list_t *prev, proc_list_t *curr,
+                           sort_mode_t mode) {
+  sort_procs_incremental(prev, curr, mode);
+
+  if (pl->max_memory == 0) {
+    trim_procs_list(curr);
+    return;
+  }
+
+  size_t keep = procs_keep_for_memory(pl->max_memory, curr->count);
+  if (cap_procs_list(curr, keep) != MYTOP_OK)
+    LOG_WARN("Pipeline", "Cannot keep the counters of %zu dropped processes", curr->count - keep);
+}
+
+/**
+ * Helper function
+ *
+ * @brief Take the baseline scan and publish it at once as a first frame.
+ *
+ * A single scan has no deltas, so process CPU% is estimated from
+ * lifetime averages and the system CPU usage from the counters since
+ * boot; the warm-up sample replaces both shortly after. On a large
+ * process table the first frame only shows the processes read within
+ * FIRST_SCAN_MS, and a second frame the full baseline.
+ */
+static void warm_start(pipeline_t *pl) {
+  mem_info_t mem = {0};
+  cpu_stat_t boot = {0};
+
+  parse_cpu_stat(&pl->prev_cpu);
+  parse_meminfo(pl->meminfo_fd, &mem);
+  double cpu_usage = calculate_cpu_usage(&boot, &pl->prev_cpu, NULL);
+  sort_mode_t mode = (sort_mode_t)atomic_load_explicit(&pl->sort_mode, memory_order_relaxed);
+
+  apply_sources(pl, pl->prev);
+  parse_procs_bounded(pl->prev, FIRST_SCAN_MS * 1000000ull);
+  estimate_procs_cpu(pl->prev);
+  sort_and_bound(pl, NULL, pl->prev, mode);
+  publish(pl, pl->prev, cpu_usage, &mem, mode);
+  if (pl->prev->unread == 0)
+    return;
+
+  // Only part of the processes were read: finish the baseline
+  clear_procs_list(pl->prev);
+  parse_procs(pl->prev);
+  estimate_procs_cpu(pl->prev);
+  sort_and_bound(pl, NULL, pl->prev, mode);
+  publish(pl, pl->prev, cpu_usage, &mem, mode);
+}
+
+/**
+ * Helper function
+ *
+ * @brief Take one sample (from /proc, or from a running collector).
+ *
+ * @return true if a new snapshot was published.
+ */
+static bool collect(pipeline_t *pl, uint64_t *next_ns) {
+  mem_info_t mem = {0};
+  double cpu_usage = 0.0;
+
+  if (pl->shm_attached) {
+    // The collector already computed CPU usage percentages
+    mytop_status_t st = shm_read(&pl->shm, &mem, &cpu_usage, pl->curr);
+    if (st == MYTOP_OK) {
+      // Forks are machine-wide, so the local /proc/stat has them too
+      cpu_stat_t curr_cpu;
+      parse_cpu_stat(&curr_cpu);
+      procs_lifecycle(pl->prev, pl->curr, &pl->lc);
+      pl->lc.forks = curr_cpu.processes - pl->prev_cpu.processes;
+      pl->ncores = calculate_core_usage(&pl->prev_cpu, &curr_cpu, pl->core_usage, MAX_CORES);
+      pl->prev_cpu = curr_cpu;
+    } else {
+      if (st == MYTOP_NO_FILE) {
+        LOG_WARN("Shm", "Collector is gone, falling back to local collection");
+        shm_close(&pl->shm);
+        pl->shm_attached = 0;
+        // Establish a local baseline for the next tick, read like a local start
+        attach_local(pl);
+        apply_sources(pl, pl->prev);
+        parse_cpu_stat(&pl->prev_cpu);
+        clear_procs_list(pl->prev);
+        parse_procs(pl->prev);
+      } else {
+        // Nothing new published yet: check again shortly
+        *next_ns = monotonic_ns() + SHM_POLL_MS * 1000000ull;
+      }
+      return false;
+    }
+  } else {
+    cpu_stat_t curr_cpu;
+
+    parse_cpu_stat(&curr_cpu);
+    parse_meminfo(pl->meminfo_fd, &mem);
+
+    // Read only what the columns on screen need
+    apply_sources(pl, pl->curr);
+
+    clear_procs_list(pl->curr);
+    parse_procs_sampled(pl->curr, pl->prev, pl->sample_slices, pl->scans ++);
+
+    cpu_usage = calculate_cpu_usage(&pl->prev_cpu, &curr_cpu, NULL);
+    calculate_procs_cpu(pl->prev, pl->curr, &pl->lc);
+    pl->lc.forks = curr_cpu.processes - pl->prev_cpu.processes;
+    pl->ncores = calculate_core_usage(&pl->prev_cpu, &curr_cpu, pl->core_usage, MAX_CORES);
+    pl->prev_cpu = curr_cpu;
+  }
+
+  psi_sample(&pl->psi);
+  if (pl->io_ok)
+    iostat_sample(&pl->io);
+
+  // Sort off the UI thread, repairing the previous order
+  sort_mode_t mode = (sort_mode_t)atomic_load_explicit(&pl->sort_mode, memory_order_relaxed);
+  sort_and_bound(pl, pl->prev, pl->curr, mode);
+
+  publish(pl, pl->curr, cpu_usage, &mem, mode);
+
+  proc_list_t *temp = pl->prev;
+  pl->prev = pl->curr;
+  pl->curr = temp;
+
+  return true;
+}
+
+/**
+ * Helper function
+ *
+ * @brief Collector thread: sample once per interval, or at once when
+ *        the UI asks for it or a PSI trigger fires.
+ *
+ * The first frame does not wait for an interval: a running collector is
+ * read right away, and a local scan is published as an estimate and
+ * measured again after WARMUP_MS.
+ */
+static void *collector_main(void *arg) {
+  pipeline_t *pl = arg;
+
+  uint64_t next_ns = monotonic_ns();
+  if (!pl->shm_attached) {
+    warm_start(pl);
+    uint64_t warmup_ms = pl->interval_ms < WARMUP_MS ? pl->interval_ms : WARMUP_MS;
+    next_ns = monotonic_ns() + warmup_ms * 1000000ull;
+  }
+  while (!atomic_load_explicit(&pl->stop, memory_order_acquire)) {
+    uint64_t now = monotonic_ns();
+    uint64_t wait_ns = next_ns > now ? next_ns - now : 0;
+    // Round up so the wait never ends just short of the deadline
+    int timeout_ms = (int)((wait_ns + 999999) / 1000000);
+
+    struct pollfd fds[1 + PSI_COUNT];
+    fds[0].fd = pl->wake_fd;
+    fds[0].events = POLLIN;
+    fds[0].revents = 0;
+    // PSI triggers report a stall as POLLPRI
+    size_t nfds = 1 + psi_fill_pollfds(&pl->psi, fds + 1, PSI_COUNT);
+
+    int ret = poll(fds, nfds, timeout_ms);
+    if (ret < 0 && errno != EINTR) {
+      LOG_ERROR("Pipeline", "poll failed");
+      break;
+    }
+    if (ret > 0) {
+      if (fds[0].revents & POLLIN)
+        event_drain(pl->wake_fd);
+      // A stall spike or a request from the UI: refresh right away
+      psi_handle_events(&pl->psi, fds + 1, nfds - 1);
+    } else if (ret < 0) {
+      continue;
+    }
+
+    if (atomic_load_explicit(&pl->stop, memory_order_acquire))
+      break;
+
+    next_ns = monotonic_ns() + pl->interval_ms * 1000000ull;
+    collect(pl, &next_ns);
+  }
+
+  return NULL;
+}
+
+/**
+ * @brief Open every data source and start the collector thread.
+ *
+ * The collector samples /proc (or reads a running mytopd through shared
+ * memory), computes the deltas and sorts, then publishes each complete
+ * snapshot through a triple buffer: it fills its private back slot and
+ * exchanges it with the middle slot in one atomic operation, while the
+ * UI exchanges its front slot for the middle one. Neither side ever
+ * waits for the other, so a slow scan cannot freeze the UI.
+ *
+ * Command strings stay in the collector's string table. The UI only
+ * reads strings referenced by its front slot, and those references are
+ * only dropped by the collector once the UI has given the slot back.
+ *
+ * @param pl             Pipeline state.
+ * @param interval_ms    Refresh interval.
+ * @param acct           Per-process CPU accounting backend.
+ * @param children       Charge reaped children's CPU time to their parents.
+ * @param shm_name       Shared snapshot to read from (NULL = always scan).
+ * @param psi_trigger_ms PSI stall threshold that forces a refresh (0 = none).
+ * @param sources        SRC_* files the first scans read (see pipeline_set_sources()).
+ * @param stat_fields    Highest /proc/[pid]/stat field they parse.
+ * @param use_uring      Batch the /proc reads through io_uring when the kernel allows.
+ * @param max_memory     Bytes the process lists may keep (0 = unbounded).
+ * @param sample_slices  Re-read 1/N of the processes per scan (0 or 1 = all).
+ * @param watch          Only follow these processes (NULL = all; released by pipeline_stop()).
+ */
+mytop_status_t pipeline_start(pipeline_t *pl, uint64_t interval_ms, cpu_acct_t acct, bool children,
+                              const char *shm_name, uint64_t psi_trigger_ms,
+                              uint32_t sources, int stat_fields, bool use_uring,
+                              uint64_t max_memory, uint32_t sample_slices, watch_t *watch) {
+  // Check input parameters
+  if (!pl || interval_ms == 0)
+    return MYTOP_ERR_PARAM;
+
+  memset(pl, 0, sizeof(*pl));
+  pl->uring.fd = -1;
+  pl->interval_ms = interval_ms;
+  pl->max_memory = max_memory;
+  pl->sample_slices = sample_slices;
+  pl->watch = watch;
+  pl->use_uring = use_uring;
+  pl->wake_fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+  pl->notify_fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+  pl->meminfo_fd = meminfo_open();
+  pl->strtab = create_str_table();
+  pl->prev = create_procs_list(0, pl->strtab);
+  pl->curr = create_procs_list(0, pl->strtab);
+  for (int i = 0; i < SNAPSHOT_SLOTS; ++ i)
+    pl->slots[i].procs = create_procs_list(0, pl->strtab);
+
+  // Pressure panel, read through persistent fds (local even when attached)
+  bool psi_ok = psi_open(&pl->psi) == MYTOP_OK;
+  // Disk and network panels, sampled every tick so toggling shows rates at once
+  pl->io_ok = iostat_open(&pl->io) == MYTOP_OK;
+
+  if (pl->wake_fd == -1 || pl->notify_fd == -1 || !pl->strtab || !pl->prev || !pl->curr ||
+      !pl->slots[0].procs || !pl->slots[1].procs || !pl->slots[2].procs) {
+    LOG_ERROR("Pipeline", "Cannot set up the collector");
+    pipeline_stop(pl);
+    return MYTOP_ERR_NOMEM;
+  }
+  if (pl->meminfo_fd == -1)
+    LOG_WARN("Core", "Cannot open /proc/meminfo");
+
+  pl->prev->acct = acct;
+  pl->curr->acct = acct;
+  pl->prev->children = pl->curr->children = children;
+
+  // Slot 0 is filled first, slot 2 stays on the UI side until the first swap
+  pl->back = 0;
+  atomic_init(&pl->middle, 1);
+  pl->front = 2;
+  atomic_init(&pl->sort_mode, SORT_CPU);
+  atomic_init(&pl->sources, (uint64_t)stat_fields << 32 | sources);
+  atomic_init(&pl->stop, 0);
+
+  // Render from a running collector when there is one
+  pl->shm_attached = shm_name && shm_viewer_open(&pl->shm, shm_name) == MYTOP_OK;
+  if (pl->shm_attached)
+    LOG_INFO("Shm", "Attached to collector snapshots at %s", shm_name);
+  else
+    attach_local(pl);
+
+  if (!psi_ok)
+    LOG_INFO("PSI", "/proc/pressure unavailable, pressure panel disabled");
+  else if (psi_trigger_ms > 0 &&
+           psi_arm_triggers(&pl->psi, psi_trigger_ms * 1000, PSI_WINDOW_US) != MYTOP_OK)
+    LOG_WARN("PSI", "No PSI trigger registered, stalls are only seen at refresh");
+
+  if (!pl->io_ok)
+    LOG_INFO("IO", "/proc/diskstats and /proc/net/dev unavailable");
+
+  // Initial sampling (the baseline scan runs on the collector thread)
+  psi_sample(&pl->psi);
+  if (pl->io_ok)
+    iostat_sample(&pl->io);
+  if (pl->shm_attached)
+    parse_cpu_stat(&pl->prev_cpu);
+
+  // Keep terminal signals (SIGWINCH, ...) on the UI thread
+  sigset_t all, old;
+  sigfillset(&all);
+  pthread_sigmask(SIG_SETMASK, &all, &old);
+  int err = pthread_create(&pl->thread, NULL, collector_main, pl);
+  pthread_sigmask(SIG_SETMASK, &old, NULL);
+  if (err != 0) {
+    LOG_ERROR("Pipeline", "Cannot start the collector thread: %s", strerror(err));
+    pipeline_stop(pl);
+    return MYTOP_ERR;
+  }
+  pl->running = 1;
+
+  return MYTOP_OK;
+}
+
+/**
+ * @brief Take the newest snapshot, if one was published since the last call.
+ *
+ * The front slot handed back becomes the collector's next spare, so the
+ * previous front must no longer be used once this returns true.
+ *
+ * @return true if the front slot now holds a newer snapshot.
+ */
+bool pipeline_acquire(pipeline_t *pl) {
+  if (!pl || !(atomic_load_explicit(&pl->middle, memory_order_relaxed) & SNAP_FRESH))
+    return false;
+
+  // Acquire: the slot content published by the collector is visible
+  uint32_t old = atomic_exchange_explicit(&pl->middle, pl->front, memory_order_acq_rel);
+  pl->front = old & SNAP_INDEX;
+
+  return true;
+}
+
+/**
+ * @brief The snapshot owned by the UI (valid after pipeline_acquire()
+ *        returned true once).
+ */
+snapshot_t *pipeline_front(pipeline_t *pl) {
+  return pl ? &pl->slots[pl->front] : NULL;
+}
+
+/**
+ * @brief Ask the collector to sort the next snapshots by mode.
+ */
+void pipeline_set_sort(pipeline_t *pl, sort_mode_t mode) {
+  if (pl)
+    atomic_store_explicit(&pl->sort_mode, mode, memory_order_relaxed);
+}
+
+/**
+ * @brief Tell the collector which per-process files the next scans need.
+ *
+ * @param pl          Pipeline state.
+ * @param sources     SRC_* bits (see columns_sources()).
+ * @param stat_fields Highest /proc/[pid]/stat field to parse.
+ */
+void pipeline_set_sources(pipeline_t *pl, uint32_t sources, int stat_fields) {
+  if (pl)
+    atomic_store_explicit(&pl->sources, (uint64_t)stat_fields << 32 | sources,
+                          memory_order_relaxed);
+}
+
+/**
+ * @brief Ask the collector to sample now instead of at the next tick.
+ */
+void pipeline_refresh(pipeline_t *pl) {
+  if (pl && pl->running)
+    event_signal(pl->wake_fd);
+}
+
+/**
+ * @brief Descriptor that becomes readable when a snapshot is ready.
+ */
+int pipeline_notify_fd(const pipeline_t *pl) {
+  return pl ? pl->notify_fd : -1;
+}
+
+/**
+ * @brief Reset the readiness of pipeline_notify_fd().
+ */
+void pipeline_drain_notify(pipeline_t *pl) {
+  if (pl)
+    event_drain(pl->notify_fd);
+}
+
+/**
+ * @brief Stop the collector thread and release every resource.
+ */
+void pipeline_stop(pipeline_t *pl) {
+  if (!pl)
+    return;
+
+  if (pl->running) {
+    atomic_store_explicit(&pl->stop, 1, memory_order_release);
+    event_signal(pl->wake_fd);
+    pthread_join(pl->thread, NULL);
+    pl->running = 0;
+  }
+
+  if (pl->shm_attached)
+    shm_close(&pl->shm);
+  pl->shm_attached = 0;
+  psi_close(&pl->psi);
+  iostat_close(&pl->io);
+  uring_free(&pl->uring);
+  // Its command lines are references into the table
+  watch_free(pl->watch);
+  pl->watch = NULL;
+  if (pl->meminfo_fd != -1) close(pl->meminfo_fd);
+  if (pl->wake_fd != -1) close(pl->wake_fd);
+  if (pl->notify_fd != -1) close(pl->notify_fd);
+  pl->meminfo_fd = pl->wake_fd = pl->notify_fd = -1;
+
+  for (int i = 0; i < SNAPSHOT_SLOTS; ++ i) {
+    free_procs_list(pl->slots[i].procs);
+    pl->slots[i].procs = NULL;
+  }
+  free_procs_list(pl->prev);
+  free_procs_list(pl->curr);
+  pl->prev = pl->curr = NULL;
+  free_str_table(pl->strtab);
+  pl->strtab = NULL;
+}
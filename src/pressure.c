@@ -0,0 +1,245 @@
+#include "log.h"
+#include "mytop.h"
+#include "mytop_types.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <poll.h>
+#include <unistd.h>
+
+static const char *const psi_paths[PSI_COUNT] = {
+  "/proc/pressure/cpu",
+  "/proc/pressure/memory",
+  "/proc/pressure/io",
+};
+
+static const char *const psi_names[PSI_COUNT] = {
+  "cpu",
+  "memory",
+  "io",
+};
+
+/**
+ * Helper function
+ *
+ * @brief Parse one PSI line after its "some"/"full" prefix:
+ *        " avg10=0.00 avg60=0.00 avg300=0.00 total=0"
+ *
+ * @return MYTOP_OK on success, MYTOP_ERR_PARSE on unexpected content.
+ */
+static mytop_status_t parse_psi_line(const char *p, psi_line_t *line) {
+  struct {
+    const char *key;
+    size_t key_len;
+    double *dst;
+  } avgs[] = {
+    {"avg10=",  6, &line->avg10},
+    {"avg60=",  6, &line->avg60},
+    {"avg300=", 7, &line->avg300},
+  };
+
+  for (size_t i = 0; i < sizeof(avgs) / sizeof(avgs[0]); ++ i) {
+    p = strstr(p, avgs[i].key);
+    if (!p)
+      return MYTOP_ERR_PARSE;
+    p += avgs[i].key_len;
+
+    char *end;
+    *avgs[i].dst = strtod(p, &end);
+    if (end == p)
+      return MYTOP_ERR_PARSE;
+    p = end;
+  }
+
+  p = strstr(p, "total=");
+  if (!p)
+    return MYTOP_ERR_PARSE;
+  p += 6;
+
+  char *end;
+  errno = 0;
+  line->total = strtoull(p, &end, 10);
+  if (end == p || errno == ERANGE)
+    return MYTOP_ERR_PARSE;
+
+  return MYTOP_OK;
+}
+
+/**
+ * @brief Open the PSI files once; they are re-read with pread() each tick.
+ *
+ * @return
+ *  - MYTOP_OK if at least one resource is available.
+ *  - MYTOP_NO_FILE if the kernel has no PSI support (CONFIG_PSI / psi=0).
+ */
+mytop_status_t psi_open(psi_info_t *psi) {
+  // Check input parameters
+  if (!psi)
+    return MYTOP_ERR_PARAM;
+
+  memset(psi, 0, sizeof(*psi));
+
+  for (int k = 0; k < PSI_COUNT; ++ k) {
+    psi->trigger_fd[k] = -1;
+    psi->fd[k] = open(psi_paths[k], O_RDONLY | O_CLOEXEC);
+    if (psi->fd[k] != -1)
+      psi->available ++;
+  }
+
+  return psi->available ? MYTOP_OK : MYTOP_NO_FILE;
+}
+
+/**
+ * @brief Sample all PSI resources and compute stall time deltas.
+ */
+mytop_status_t psi_sample(psi_info_t *psi) {
+  // Check input parameters
+  if (!psi)
+    return MYTOP_ERR_PARAM;
+
+  for (int k = 0; k < PSI_COUNT; ++ k) {
+    if (psi->fd[k] == -1)
+      continue;
+
+    char buf[256];
+    ssize_t n = pread(psi->fd[k], buf, sizeof(buf) - 1, 0);
+    if (n <= 0)
+      continue;
+    buf[n] = '\0';
+
+    psi_resource_t *res = &psi->res[k];
+    psi_line_t some = res->some, full = res->full;
+
+    // "some ..." is always the first line, "full ..." is optional
+    if (strncmp(buf, "some", 4) != 0 || parse_psi_line(buf + 4, &some) != MYTOP_OK)
+      continue;
+
+    char *full_line = strstr(buf, "\nfull");
+    res->has_full = full_line && parse_psi_line(full_line + 5, &full) == MYTOP_OK;
+
+    // The first sample has no reference to compute deltas from
+    res->some_delta = res->sampled ? some.total - res->some.total : 0;
+    res->full_delta = res->sampled && res->has_full ? full.total - res->full.total : 0;
+    res->some = some;
+    res->full = full;
+    res->sampled = 1;
+  }
+
+  return MYTOP_OK;
+}
+
+/**
+ * @brief Register PSI triggers so stalls wake the event loop.
+ *
+ * A trigger fires (POLLPRI) when "some" stall time exceeds stall_us within a window_us window.
+ *
+ * @param psi       PSI state.
+ * @param stall_us  Stall threshold (us).
+ * @param window_us Tracking window (us, 500ms - 10s; unprivileged
+ *                  users need a multiple of 2s).
+ *
+ * @return MYTOP_OK if at least one trigger was registered.
+ */
+mytop_status_t psi_arm_triggers(psi_info_t *psi, uint64_t stall_us, uint64_t window_us) {
+  // Check input parameters
+  if (!psi || stall_us == 0 || stall_us > window_us)
+    return MYTOP_ERR_PARAM;
+
+  char spec[64];
+  int len = snprintf(spec, sizeof(spec), "some %" PRIu64 " %" PRIu64, stall_us, window_us);
+
+  int armed = 0;
+  for (int k = 0; k < PSI_COUNT; ++ k) {
+    if (psi->fd[k] == -1)
+      continue;
+
+    int fd = open(psi_paths[k], O_RDWR | O_NONBLOCK | O_CLOEXEC);
+    if (fd == -1 || write(fd, spec, (size_t)len + 1) < 0) {
+      int err = errno;
+      LOG_WARN("PSI", "Cannot register %s trigger: %s", psi_names[k], strerror(err));
+      if (fd != -1) close(fd);
+      continue;
+    }
+
+    psi->trigger_fd[k] = fd;
+    armed ++;
+  }
+
+  return armed ? MYTOP_OK : MYTOP_ERR_IO;
+}
+
+/**
+ * @brief Add the trigger fds to a poll() set, waiting for POLLPRI.
+ *
+ * @return Number of entries filled (at most cap).
+ */
+size_t psi_fill_pollfds(const psi_info_t *psi, struct pollfd *fds, size_t cap) {
+  size_t n = 0;
+  if (!psi || !fds)
+    return n;
+
+  for (int k = 0; k < PSI_COUNT && n < cap; ++ k) {
+    if (psi->trigger_fd[k] == -1)
+      continue;
+    fds[n].fd = psi->trigger_fd[k];
+    fds[n].events = POLLPRI;
+    fds[n].revents = 0;
+    n ++;
+  }
+
+  return n;
+}
+
+/**
+ * @brief Count the triggers that fired in a polled set.
+ *
+ * @return true if any trigger fired.
+ */
+bool psi_handle_events(psi_info_t *psi, const struct pollfd *fds, size_t n) {
+  bool fired = false;
+  if (!psi || !fds)
+    return fired;
+
+  for (size_t i = 0; i < n; ++ i) {
+    if (!(fds[i].revents & (POLLPRI | POLLERR)))
+      continue;
+    for (int k = 0; k < PSI_COUNT; ++ k) {
+      if (psi->trigger_fd[k] == fds[i].fd) {
+        psi->events[k] ++;
+        fired = true;
+      }
+    }
+  }
+
+  return fired;
+}
+
+/**
+ * @brief Close all PSI file descriptors.
+ */
+void psi_close(psi_info_t *psi) {
+  if (!psi)
+    return;
+
+  for (int k = 0; k < PSI_COUNT; ++ k) {
+    if (psi->fd[k] != -1) close(psi->fd[k]);
+    if (psi->trigger_fd[k] != -1) close(psi->trigger_fd[k]);
+    psi->fd[k] = -1;
+    psi->trigger_fd[k] = -1;
+  }
+  psi->available = 0;
+}
+
+/**
+ * @brief Name of a PSI resource ("cpu", "memory", "io").
+ */
+const char *psi_resource_name(int res) {
+  if (res < 0 || res >= PSI_COUNT)
+    return "?";
+
+  return psi_names[res];
+}
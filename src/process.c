@@ -9,79 +9,106 @@
 #include <stddef.h>
 #include <stdlib.h>
 #include <dirent.h>
+#include <fcntl.h>
 #include <string.h>
 #include <sys/types.h>
 #include <inttypes.h>
+#include <malloc.h>
 #include <unistd.h>
 
 /**
  * Helper function
  *
- * @brief Reads the /proc/[pid]/cmdline file to 
- *        obtain the process's command line.
+ * @brief Turn the NUL-separated arguments of a cmdline read into one
+ *        line, dropping the trailing separators.
  *
- * @param path   File name.
- * @param out    Buffer to write the cmdline into upon successful read.
- * @param out_sz Size of the out buffer.
+ * @return The length of the line (0 for a kernel thread or zombie).
+ */
+static size_t tidy_cmdline(char *buf, size_t n) {
+  // Replace the middle '\0' with a space
+  for (size_t i = 0; i < n; i++) {
+    if (buf[i] == '\0') buf[i] = ' ';
+  }
+
+  // Remove trailing spaces (typically the last \0 is replaced with ' ')
+  while (n > 0 && buf[n - 1] == ' ') {
+    n--;
+  }
+  buf[n] = '\0';
+
+  return n;
+}
+
+/**
+ * Helper function
+ *
+ * @brief Reads the whole /proc/[pid]/cmdline file into the scratch
+ *        buffer of the list, growing it as needed (never truncates).
+ *
+ * @param dir_fd  Directory path is relative to (AT_FDCWD for an absolute path).
+ * @param path    File name.
+ * @param list    List owning the scratch buffer (list->cmd_buf).
+ * @param out_len Length of the command line on success. [out]
  *
  * @return 
  *  - MYTOP_OK on success.
  *  - MYTOP_NO_FILE if the file does not exist.
  *  - MYTOP_NO_DATA if the file content is empty.
  *  - MYTOP_ERR_PARAM on parameter error.
+ *  - MYTOP_ERR_NOMEM if the scratch buffer cannot grow.
  *  - MYTOP_ERR for other errors.
  */
-static mytop_status_t read_cmdline(const char *path, char *out, size_t out_sz) {
+static mytop_status_t read_cmdline(int dir_fd, const char *path, proc_list_t *list,
+                                   size_t *out_len) {
   // Check input parameters
-  if (!path || !out || out_sz == 0)
+  if (!path || !list || !out_len)
     return MYTOP_ERR_PARAM;
 
-  out[0] = '\0';
+  *out_len = 0;
 
-  FILE *fp = fopen(path, "r");
-  if (!fp) {
-    if (errno == ENOENT || errno == EACCES)
+  int fd = openat(dir_fd, path, O_RDONLY | O_CLOEXEC);
+  if (fd == -1) {
+    if (errno == ENOENT || errno == EACCES || errno == ESRCH)
       return MYTOP_NO_FILE;
      int err = errno;
-     LOG_ERROR("Process", "Cannot open /proc/stat file: %s", strerror(err));
+     LOG_ERROR("Process", "Cannot open %s file: %s", path, strerror(err));
      return MYTOP_ERR_IO;
   }
 
-  char buf[BUFFER_SIZE];
-  size_t n = fread(buf, 1, sizeof(buf) - 1, fp);
+  size_t n = 0;
+  for (;;) {
+    // Keep room for the terminator
+    if (list->cmd_buf_cap - n < 2) {
+      size_t new_cap = list->cmd_buf_cap ? list->cmd_buf_cap * 2 : BUFFER_SIZE;
+      char *new_buf = realloc(list->cmd_buf, new_cap);
+      if (!new_buf) {
+        close(fd);
+        return MYTOP_ERR_NOMEM;
+      }
+      list->cmd_buf = new_buf;
+      list->cmd_buf_cap = new_cap;
+    }
 
-  if (n == 0) {
+    ssize_t got = read(fd, list->cmd_buf + n, list->cmd_buf_cap - n - 1);
     // Error
-    if (ferror(fp)) {
-      fclose(fp);
-      return MYTOP_ERR;
+    if (got < 0) {
+      close(fd);
+      // The process exited while being read
+      return n == 0 ? MYTOP_NO_FILE : MYTOP_ERR;
     }
-    // Content is empty
-    fclose(fp);
-    return MYTOP_NO_DATA;
-  }
-
-  fclose(fp);
-
-  buf[n] = '\0';
-
-  // Replace the middle '\0' with a space
-  for (size_t i = 0; i < n; i++) {
-    if (buf[i] == '\0') buf[i] = ' ';
-  }
-
-  // Remove trailing spaces (typically the last \0 is replaced with ' ')
-  while (n > 0 && buf[n - 1] == ' ') {
-    buf[n - 1] = '\0';
-    n--;
+    if (got == 0)
+      break;
+    n += (size_t)got;
   }
+  close(fd);
 
-  // Copy to output
-  snprintf(out, out_sz, "%s", buf);
+  n = tidy_cmdline(list->cmd_buf, n);
 
-  if (out[0] == '\0')
+  // Content is empty (kernel thread or zombie)
+  if (n == 0)
     return MYTOP_NO_DATA;
 
+  *out_len = n;
   return MYTOP_OK;
 }
 
@@ -91,95 +118,69 @@ static mytop_status_t read_cmdline(const char *path, char *out, size_t out_sz) {
  * @brief Reads the /proc/[pid]/comm file to 
  *        obtain the process's comm info.
  *
- * @param path   File name.
- * @param out    Buffer to write the cmdline into upon successful read.
- * @param out_sz Size of the out buffer.
+ * @param dir_fd  Directory path is relative to (AT_FDCWD for an absolute path).
+ * @param path    File name.
+ * @param out     Buffer to write the comm into upon successful read.
+ * @param out_sz  Size of the out buffer.
+ * @param out_len Length of the comm on success. [out]
  *
  * @return 
  *  - MYTOP_OK on success.
- *  - MYTOP_NO_FILE if the file does not exist.
  *  - MYTOP_NO_DATA if the file content is empty.
  *  - MYTOP_ERR_PARAM on parameter error.
  *  - MYTOP_ERR for other errors.
  */
-static mytop_status_t read_comm(char *path, char *out, size_t out_sz) {
+static mytop_status_t read_comm(int dir_fd, const char *path, char *out, size_t out_sz,
+                                size_t *out_len) {
   // Check input parameters
-  if (!path || !out || out_sz == 0)
+  if (!path || !out || out_sz == 0 || !out_len)
     return MYTOP_ERR_PARAM;
   
   out[0] = '\0';
 
-  FILE *fp = fopen(path, "r");
-  if (!fp) {
+  int fd = openat(dir_fd, path, O_RDONLY | O_CLOEXEC);
+  if (fd == -1) {
     int err = errno;
-    LOG_ERROR("Process", "Cannot open /proc/stat file: %s", strerror(err));
+    LOG_ERROR("Process", "Cannot open %s file: %s", path, strerror(err));
     return MYTOP_ERR_IO;
   }
 
-  char buf[BUFFER_SIZE];
-  size_t n = fread(buf, 1, sizeof(buf) - 1, fp);
+  ssize_t got = read(fd, out, out_sz - 1);
+  close(fd);
 
-  if (n == 0) {
-    // Error
-    if (ferror(fp)) {
-      fclose(fp);
-      return MYTOP_ERR;
-    }
-    // Content is empty
-    fclose(fp);
+  // Error
+  if (got < 0)
+    return MYTOP_ERR;
+  // Content is empty
+  if (got == 0)
     return MYTOP_NO_DATA;
-  }
-
-  fclose(fp);
+  size_t n = (size_t)got;
 
   // Note that there is a \n at the end of comm
-  buf[n-1] = '\0';
-
-  // Copy to output
-  snprintf(out, out_sz, "%s", buf);
+  if (out[n - 1] == '\n') n --;
+  out[n] = '\0';
 
-  if (out[0] == '\0')
+  if (n == 0)
     return MYTOP_NO_DATA;
 
+  *out_len = n;
   return MYTOP_OK;
 }
 
 /**
  * Helper function
  *
- * Reads the /proc/[pid]/stat file to obtain process information 
- * such as status, pid, ppid, etc.
+ * Parses the content of a /proc/[pid]/stat file (tokenized in place).
  *
- * @param path  File name.
- * @param info  Structure to store the parsed process information.
+ * @param buf        NUL-terminated file content.
+ * @param info       Structure to store the parsed process information.
+ * @param max_field  Last field to parse; the fields after it are left zero.
  *
  * @return 
  *  - MYTOP_OK on success.
- *  - MYTOP_ERR_PARAM on parameter error.
- *  - MYTOP_ERR for other errors.
+ *  - MYTOP_ERR_PARSE on unexpected content.
  */
-static mytop_status_t read_stat(const char *path, proc_info_t *info) {
-  // Check input parameters
-  if (!path || !info)
-     return MYTOP_ERR_PARAM;
-
-  FILE *fp = fopen(path, "r");
-  if (!fp) {
-    int err = errno;
-    LOG_ERROR("Process", "Cannot open /proc/stat file: %s", strerror(err));
-    return MYTOP_ERR;
-  }
-
-  char buf[BUFFER_SIZE];
-  size_t n = fread(buf, 1, sizeof(buf) - 1, fp);
-  if (n == 0) {
-    fclose(fp);
-    return MYTOP_ERR;
-  }
-  fclose(fp);
-
-  buf[n] = '\0';
-  
+static mytop_status_t parse_stat_buf(char *buf, proc_info_t *info, int max_field) {
   // Find the last )
   char *end_paren = strrchr(buf, ')');
   // Invalid input or no matching minimum parentheses
@@ -190,13 +191,18 @@ static mytop_status_t read_stat(const char *path, proc_info_t *info) {
 
   // Skip the first two fields
   int field_index = 3;
+  // Not parsed (no column needs them) or absent on old kernels
+  info->vsize = 0;
+  info->rss = 0;
+  info->blkio_ticks = 0;
+  info->processor = -1;
 
   // Parse the remaining fields
   mytop_status_t ret;
   char *save = NULL;
   char *token = strtok_r(rest, " ", &save);
 
-  while (token && *token) {
+  while (token && *token && field_index <= max_field) {
     switch (field_index) {
       case 3: 
         info->state = token[0]; 
@@ -209,6 +215,14 @@ static mytop_status_t read_stat(const char *path, proc_info_t *info) {
         ret = str_to_num(token, 10, NUM_U64, &info->pgrp);
         if (ret != MYTOP_OK) return ret;
         break;
+      case 10:
+        ret = str_to_num(token, 10, NUM_U64, &info->minflt);
+        if (ret != MYTOP_OK) return ret;
+        break;
+      case 12:
+        ret = str_to_num(token, 10, NUM_U64, &info->majflt);
+        if (ret != MYTOP_OK) return ret;
+        break;
       case 14:
         ret = str_to_num(token, 10, NUM_U64, &info->utime);
         if (ret != MYTOP_OK) return ret;
@@ -217,6 +231,18 @@ static mytop_status_t read_stat(const char *path, proc_info_t *info) {
         ret = str_to_num(token, 10, NUM_U64, &info->stime);
         if (ret != MYTOP_OK) return ret;
         break;
+      case 16:
+        ret = str_to_num(token, 10, NUM_U64, &info->cutime);
+        if (ret != MYTOP_OK) return ret;
+        break;
+      case 17:
+        ret = str_to_num(token, 10, NUM_U64, &info->cstime);
+        if (ret != MYTOP_OK) return ret;
+        break;
+      case 22:
+        ret = str_to_num(token, 10, NUM_U64, &info->starttime);
+        if (ret != MYTOP_OK) return ret;
+        break;
       case 23:
         ret = str_to_num(token, 10, NUM_U64, &info->vsize);
         if (ret != MYTOP_OK) return ret;
@@ -225,6 +251,17 @@ static mytop_status_t read_stat(const char *path, proc_info_t *info) {
         ret = str_to_num(token, 10, NUM_U64, &info->rss);
         if (ret != MYTOP_OK) return ret;
         break;
+      case 39: {
+        uint64_t cpu;
+        ret = str_to_num(token, 10, NUM_U64, &cpu);
+        if (ret != MYTOP_OK) return ret;
+        info->processor = (int)cpu;
+        break;
+      }
+      case 42:
+        ret = str_to_num(token, 10, NUM_U64, &info->blkio_ticks);
+        if (ret != MYTOP_OK) return ret;
+        break;
       default: 
         break;
     }
@@ -240,22 +277,234 @@ static mytop_status_t read_stat(const char *path, proc_info_t *info) {
 /**
  * Helper function
  *
- * @brief Uses PID to check whether a process exists in the list.
+ * Reads the /proc/[pid]/stat file to obtain process information 
+ * such as status, pid, ppid, etc.
+ *
+ * @param path       File name.
+ * @param info       Structure to store the parsed process information.
+ * @param max_field  Last field to parse; the fields after it are left zero.
+ *
+ * @return 
+ *  - MYTOP_OK on success.
+ *  - MYTOP_NO_FILE if the process exited.
+ *  - MYTOP_ERR_PARAM on parameter error.
+ *  - MYTOP_ERR for other errors.
+ */
+static mytop_status_t read_stat(const char *path, proc_info_t *info, int max_field) {
+  // Check input parameters
+  if (!path || !info)
+     return MYTOP_ERR_PARAM;
+
+  FILE *fp = fopen(path, "r");
+  if (!fp) {
+    if (errno == ENOENT || errno == ESRCH)
+      return MYTOP_NO_FILE;
+    int err = errno;
+    LOG_ERROR("Process", "Cannot open /proc/stat file: %s", strerror(err));
+    return MYTOP_ERR;
+  }
+
+  char buf[BUFFER_SIZE];
+  size_t n = fread(buf, 1, sizeof(buf) - 1, fp);
+  if (n == 0) {
+    fclose(fp);
+    return MYTOP_NO_FILE;
+  }
+  fclose(fp);
+
+  buf[n] = '\0';
+  return parse_stat_buf(buf, info, max_field);
+}
+
+/**
+ * Helper function
+ *
+ * Parses the three counters of a /proc/[pid]/schedstat file.
+ *
+ * @return MYTOP_OK on success, MYTOP_ERR_PARSE on unexpected content.
+ */
+static mytop_status_t parse_schedstat_buf(const char *buf, proc_info_t *info) {
+  uint64_t *dst[] = { &info->run_ns, &info->wait_ns, &info->timeslices };
+  const char *p = buf;
+  for (size_t i = 0; i < sizeof(dst) / sizeof(dst[0]); ++ i) {
+    char *end;
+    errno = 0;
+    *dst[i] = strtoull(p, &end, 10);
+    if (end == p || errno == ERANGE)
+      return MYTOP_ERR_PARSE;
+    p = end;
+  }
+
+  return MYTOP_OK;
+}
+
+/**
+ * Helper function
+ *
+ * Reads the /proc/[pid]/schedstat file: three counters, the time spent
+ * on the CPU (ns), the time spent waiting on a run queue (ns) and the
+ * number of timeslices run.
+ *
+ * @param path  File name.
+ * @param info  Structure to store the parsed counters.
+ *
+ * @return 
+ *  - MYTOP_OK on success.
+ *  - MYTOP_NO_FILE if the file cannot be opened.
+ *  - MYTOP_ERR_PARSE on unexpected content.
+ */
+static mytop_status_t read_schedstat(const char *path, proc_info_t *info) {
+  // Check input parameters
+  if (!path || !info)
+    return MYTOP_ERR_PARAM;
+
+  FILE *fp = fopen(path, "r");
+  if (!fp)
+    return MYTOP_NO_FILE;
+
+  char buf[128];
+  size_t n = fread(buf, 1, sizeof(buf) - 1, fp);
+  fclose(fp);
+  if (n == 0)
+    return MYTOP_NO_DATA;
+  buf[n] = '\0';
+
+  return parse_schedstat_buf(buf, info);
+}
+
+/**
+ * @brief Check whether per-process schedstat accounting works here.
+ *
+ * /proc/[pid]/schedstat needs CONFIG_SCHED_INFO; on kernels where
+ * schedstats are compiled out the file is missing or reads all zeros.
+ */
+bool schedstat_available(void) {
+  proc_info_t self = {0};
+  if (read_schedstat("/proc/self/schedstat", &self) != MYTOP_OK)
+    return false;
+
+  // This process has certainly run already
+  return self.run_ns > 0;
+}
+
+/**
+ * Helper function
+ *
+ * Parses the shared pages out of a /proc/[pid]/statm file.
+ *
+ * @return MYTOP_OK on success, MYTOP_ERR_PARSE on unexpected content.
+ */
+static mytop_status_t parse_statm_buf(const char *buf, proc_info_t *info) {
+  // size resident shared text lib data dt
+  const char *p = buf;
+  for (int field = 1; field <= 3; ++ field) {
+    char *end;
+    errno = 0;
+    uint64_t value = strtoull(p, &end, 10);
+    if (end == p || errno == ERANGE)
+      return MYTOP_ERR_PARSE;
+    if (field == 3)
+      info->shared = value;
+    p = end;
+  }
+
+  return MYTOP_OK;
+}
+
+/**
+ * Helper function
+ *
+ * Reads the third value of /proc/[pid]/statm: resident pages that are
+ * shared with other processes (file-backed or shmem).
+ *
+ * @return 
+ *  - MYTOP_OK on success.
+ *  - MYTOP_NO_FILE if the file cannot be read.
+ *  - MYTOP_ERR_PARSE on unexpected content.
+ */
+static mytop_status_t read_statm(const char *path, proc_info_t *info) {
+  int fd = open(path, O_RDONLY | O_CLOEXEC);
+  if (fd == -1)
+    return MYTOP_NO_FILE;
+
+  char buf[128];
+  ssize_t n = read(fd, buf, sizeof(buf) - 1);
+  close(fd);
+  if (n <= 0)
+    return MYTOP_NO_FILE;
+  buf[n] = '\0';
+
+  return parse_statm_buf(buf, info);
+}
+
+/**
+ * Helper function
+ *
+ * @brief Parse the kB value following a "Key:" prefix of a smaps line.
+ *
+ * @return true if line starts with key, in which case *out is set.
+ */
+static bool match_kb_line(const char *line, const char *key, size_t key_len, uint64_t *out) {
+  if (strncmp(line, key, key_len) != 0)
+    return false;
+
+  uint64_t value = 0;
+  if (str_to_num(line + key_len, 10, NUM_U64, &value) != MYTOP_OK)
+    return false;
+
+  *out = value;
+  return true;
+}
+
+/**
+ * Helper function
  *
- * @param  list  Process list.
- * @param  pid   The pid of the process to be searched for.
+ * Parses the storage counters of a /proc/[pid]/io file (tokenized in place).
  *
- * @return If found, return the index, otherwise, return -1.
+ * @return MYTOP_OK on success, MYTOP_NO_DATA if the counters are missing.
  */
-static int find_process_by_pid(const proc_list_t *list, uint64_t pid) {
-  // Traverse the list to search
-  for (size_t idx = 0; idx < list->count; ++ idx) {
-    if (list->procs[idx].pid == pid) return idx;
+static mytop_status_t parse_proc_io_buf(char *buf, proc_info_t *info) {
+  bool got_r = false, got_w = false;
+  char *save = NULL;
+  for (char *line = strtok_r(buf, "\n", &save); line; line = strtok_r(NULL, "\n", &save)) {
+    if (!got_r && match_kb_line(line, "read_bytes:", 11, &info->read_bytes))
+      got_r = true;
+    else if (!got_w && match_kb_line(line, "write_bytes:", 12, &info->write_bytes))
+      got_w = true;
   }
 
-  return -1;
+  return got_r && got_w ? MYTOP_OK : MYTOP_NO_DATA;
+}
+
+/**
+ * Helper function
+ *
+ * Reads the storage counters of /proc/[pid]/io. The file is only
+ * readable for processes the caller may ptrace, so a denial is common
+ * and simply leaves has_io unset.
+ *
+ * @return 
+ *  - MYTOP_OK on success.
+ *  - MYTOP_NO_FILE if the file cannot be read.
+ *  - MYTOP_NO_DATA if the counters are missing.
+ */
+static mytop_status_t read_proc_io(const char *path, proc_info_t *info) {
+  int fd = open(path, O_RDONLY | O_CLOEXEC);
+  if (fd == -1)
+    return MYTOP_NO_FILE;
+
+  char buf[512];
+  ssize_t n = read(fd, buf, sizeof(buf) - 1);
+  close(fd);
+  if (n <= 0)
+    return MYTOP_NO_FILE;
+  buf[n] = '\0';
+
+  return parse_proc_io_buf(buf, info);
 }
 
+typedef int (*proc_cmp_fn)(const void *, const void *);
+
 /**
  * Helper function
  *
@@ -336,8 +585,15 @@ static int cmp_proc_pid_desc(const void *pa, const void *pb) {
 
 /**
  * @brief Create a new stored process information list.
+ *
+ * @param capacity_hint Initial capacity (0 selects DEFAULT_CAPACITY).
+ * @param strtab        String table interning the command lines; lists
+ *                      that are compared with each other share one table.
  */
-proc_list_t *create_procs_list(size_t capacity_hint) {
+proc_list_t *create_procs_list(size_t capacity_hint, str_table_t *strtab) {
+  if (!strtab)
+    return NULL;
+
   size_t capacity = capacity_hint == 0 ?
                     DEFAULT_CAPACITY   :
                     capacity_hint;
@@ -354,10 +610,110 @@ proc_list_t *create_procs_list(size_t capacity_hint) {
 
   list->capacity = capacity;
   list->count = 0;
+  list->acct = ACCT_JIFFIES;
+  list->children = 0;
+  list->sample_ns = 0;
+  // Everything the batch writer and the default columns use
+  list->sources = SRC_CMDLINE | SRC_SCHEDSTAT;
+  list->stat_fields = STAT_MAX_FIELD;
+  list->uring = NULL;
+  list->watch = NULL;
+  memset(&list->dropped, 0, sizeof(list->dropped));
+  list->carry = NULL;
+  list->ncarry = 0;
+  list->carry_cap = 0;
+  list->peak_count = 0;
+  list->low_ticks = 0;
+  list->strtab = strtab;
+  list->cmd_buf = NULL;
+  list->cmd_buf_cap = 0;
+  list->sort_buf = NULL;
+  list->sort_index = NULL;
+  list->sort_placed = NULL;
+  list->sort_cap = 0;
+  list->sort_index_mask = 0;
+  list->pid_order = NULL;
+  list->pid_tmp = NULL;
+  list->pid_cap = 0;
 
   return list;
 }
 
+/**
+ * @brief Empty the list, dropping its references to command strings.
+ */
+void clear_procs_list(proc_list_t *list) {
+  if (!list)
+    return;
+
+  for (size_t i = 0; i < list->count; ++ i)
+    strtab_release(list->strtab, list->procs[i].cmd);
+
+  list->count = 0;
+  list->ncarry = 0;
+  list->unread = 0;
+  memset(&list->dropped, 0, sizeof(list->dropped));
+}
+
+/**
+ * @brief Make sure the list can hold at least capacity records.
+ */
+mytop_status_t reserve_procs_list(proc_list_t *list, size_t capacity) {
+  if (!list)
+    return MYTOP_ERR_PARAM;
+
+  if (capacity <= list->capacity)
+    return MYTOP_OK;
+
+  size_t new_cap = list->capacity;
+  while (new_cap < capacity) new_cap *= 2;
+
+  proc_info_t *new_arr = realloc(list->procs, sizeof(proc_info_t) * new_cap);
+  if (!new_arr)
+    return MYTOP_ERR_NOMEM;
+
+  list->procs = new_arr;
+  list->capacity = new_cap;
+
+  return MYTOP_OK;
+}
+
+/**
+ * @brief Replace the content of dst with a copy of src.
+ *
+ * Both lists must share one string table; the copy takes its own
+ * references to the command strings.
+ *
+ * @return
+ *  - MYTOP_OK on success.
+ *  - MYTOP_ERR_PARAM if the lists use different string tables.
+ *  - MYTOP_ERR_NOMEM if dst cannot grow (dst is left empty).
+ */
+mytop_status_t copy_procs_list(proc_list_t *dst, const proc_list_t *src) {
+  // Check input parameters
+  if (!dst || !src || dst->strtab != src->strtab)
+    return MYTOP_ERR_PARAM;
+
+  clear_procs_list(dst);
+  if (reserve_procs_list(dst, src->count) != MYTOP_OK)
+    return MYTOP_ERR_NOMEM;
+
+  memcpy(dst->procs, src->procs, sizeof(proc_info_t) * src->count);
+  for (size_t i = 0; i < src->count; ++ i)
+    strtab_ref(dst->strtab, dst->procs[i].cmd);
+
+  dst->count = src->count;
+  dst->acct = src->acct;
+  dst->children = src->children;
+  dst->sample_ns = src->sample_ns;
+  dst->sources = src->sources;
+  dst->stat_fields = src->stat_fields;
+  dst->dropped = src->dropped;
+  dst->unread = src->unread;
+
+  return MYTOP_OK;
+}
+
 /**
  * @brief Free memory occupied by the process list.
  */
@@ -365,252 +721,2084 @@ void free_procs_list(proc_list_t *list) {
   if (!list)
     return;
 
+  clear_procs_list(list);
+
   // Free array
   free(list->procs);
+  free(list->cmd_buf);
+  free(list->sort_buf);
+  free(list->sort_index);
+  free(list->sort_placed);
+  free(list->pid_order);
+  free(list->pid_tmp);
+  free(list->carry);
 
   // Free list
   free(list);
 }
 
 /**
- * @brief Scan and parse all current processes
+ * Helper function
  *
- * 1. Traverse the /proc directory.
- * 2. Filter out numeric directories.
- * 3. Read /proc/[pid]/stat to parse detailed information.
- * 4. Store results in the list container (automatically expands as needed).
+ * @brief Give back the part of the arrays of a list above capacity.
  *
- * @param list Result storage container (must be initialized before calling, or pass an existing list to reuse memory)
- * @return mytop_status_t
+ * The sort, PID order and cmdline scratch buffers are freed when larger
+ * than needed; they are sized again on their next use.
  */
-mytop_status_t parse_procs(proc_list_t *list) {
+static void shrink_procs_list(proc_list_t *list, size_t capacity) {
+  if (capacity < list->count)
+    capacity = list->count;
+  if (capacity < DEFAULT_CAPACITY)
+    capacity = DEFAULT_CAPACITY;
+
+  bool shrunk = false;
+  if (capacity < list->capacity) {
+    proc_info_t *arr = realloc(list->procs, sizeof(proc_info_t) * capacity);
+    if (arr) {
+      list->procs = arr;
+      list->capacity = capacity;
+      shrunk = true;
+    }
+  }
+
+  if (list->sort_cap > list->capacity) {
+    free(list->sort_buf);
+    free(list->sort_index);
+    free(list->sort_placed);
+    list->sort_buf = NULL;
+    list->sort_index = NULL;
+    list->sort_placed = NULL;
+    list->sort_cap = 0;
+    list->sort_index_mask = 0;
+    shrunk = true;
+  }
+  if (list->pid_cap > list->capacity) {
+    free(list->pid_order);
+    free(list->pid_tmp);
+    list->pid_order = NULL;
+    list->pid_tmp = NULL;
+    list->pid_cap = 0;
+    shrunk = true;
+  }
+  if (list->cmd_buf_cap > BUFFER_SIZE) {
+    free(list->cmd_buf);
+    list->cmd_buf = NULL;
+    list->cmd_buf_cap = 0;
+    shrunk = true;
+  }
+  if (list->carry_cap > 2 * list->ncarry) {
+    proc_carry_t *carry = list->ncarry ? realloc(list->carry, sizeof(proc_carry_t) * list->ncarry) : NULL;
+    if (!list->ncarry || carry) {
+      if (!list->ncarry) free(list->carry);
+      list->carry = carry;
+      list->carry_cap = list->ncarry;
+      shrunk = true;
+    }
+  }
+
+  list->peak_count = 0;
+  list->low_ticks = 0;
+
+#ifdef __GLIBC__
+  // Freed blocks below the top of the heap are only returned on request
+  if (shrunk)
+    malloc_trim(0);
+#else
+  (void)shrunk;
+#endif
+}
+
+/**
+ * @brief Release the memory of a list that stays far below its capacity.
+ *
+ * Call once per scan. After SHRINK_TICKS scans in a row using under a
+ * quarter of the capacity, the arrays shrink to twice the largest count
+ * seen meanwhile, so a transient fork storm does not pin its peak
+ * memory for the rest of the run.
+ */
+void trim_procs_list(proc_list_t *list) {
+  if (!list)
+    return;
+
+  if (list->capacity <= DEFAULT_CAPACITY || list->count * 4 > list->capacity) {
+    list->peak_count = 0;
+    list->low_ticks = 0;
+    return;
+  }
+
+  if (list->count > list->peak_count)
+    list->peak_count = list->count;
+  if (++ list->low_ticks < SHRINK_TICKS)
+    return;
+
+  size_t capacity = DEFAULT_CAPACITY;
+  while (capacity < list->peak_count * 2) capacity <<= 1;
+
+  LOG_INFO("Process", "Shrinking process list from %zu to %zu records", list->capacity, capacity);
+  shrink_procs_list(list, capacity);
+}
+
+/**
+ * @brief Number of processes the lists may keep within a memory budget.
+ *
+ * A kept record lives in each of the SCAN_LISTS collector lists and
+ * their sort buffers, and in the SNAPSHOT_SLOTS snapshot slots (the UI
+ * reorders its slot in place and keeps no other copy). Each scan list
+ * also indexes it by PID (two uint32_t), in the sort hash (up to four
+ * int32_t: twice the capacity, rounded up to a power of two) and in
+ * the placed flags. Every process, kept or not, also costs a
+ * proc_carry_t.
+ *
+ * @param max_bytes Budget (0 = unbounded).
+ * @param nprocs    Processes on the host.
+ */
+size_t procs_keep_for_memory(uint64_t max_bytes, size_t nprocs) {
+  if (max_bytes == 0)
+    return SIZE_MAX;
+
+  // Each scan list and its sort buffer, then each snapshot slot
+  const size_t copies = SCAN_LISTS * 2 + SNAPSHOT_SLOTS;
+  // PID order and radix scratch, sort hash slots, placed flag
+  const size_t list_index = 2 * sizeof(uint32_t) + 4 * sizeof(int32_t) + sizeof(uint8_t);
+  size_t per_proc = copies * sizeof(proc_info_t) + SCAN_LISTS * list_index;
+
+  uint64_t carry = (uint64_t)nprocs * sizeof(proc_carry_t);
+  size_t keep = carry < max_bytes ? (size_t)((max_bytes - carry) / per_proc) : 0;
+  return keep < MIN_KEPT_PROCS ? MIN_KEPT_PROCS : keep;
+}
+
+/**
+ * Helper function
+ *
+ * @brief qsort comparison of carried processes by ascending PID.
+ */
+static int cmp_carry_pid(const void *pa, const void *pb) {
+  const proc_carry_t *a = pa, *b = pb;
+  return (a->pid > b->pid) - (a->pid < b->pid);
+}
+
+/**
+ * @brief Keep only the first processes of a sorted list.
+ *
+ * The others are folded into list->dropped and their strings released;
+ * only their CPU counters are kept (list->carry), so the next scan can
+ * still compute their CPU% and bring them back if they rise into the
+ * kept set. The arrays of the list shrink to the kept size at once.
+ *
+ * @param list Process list, sorted by the active key.
+ * @param keep Processes to keep.
+ *
+ * @return
+ *  - MYTOP_OK on success.
+ *  - MYTOP_ERR_NOMEM if the carried counters could not be stored (the
+ *    list is capped anyway; those processes count as new next scan).
+ */
+mytop_status_t cap_procs_list(proc_list_t *list, size_t keep) {
   // Check input parameters
   if (!list)
     return MYTOP_ERR_PARAM;
 
-  // 1. Traverse the /proc directories
-  // Open /proc directory
-  DIR *dir = opendir("/proc");
-  if (!dir) {
-    int err = errno;
-    LOG_ERROR("Process", "Cannot open /proc directory: %s", strerror(err));
-    return MYTOP_ERR_IO;
+  list->ncarry = 0;
+  memset(&list->dropped, 0, sizeof(list->dropped));
+  if (list->count <= keep)
+    return MYTOP_OK;
+
+  size_t ndrop = list->count - keep;
+  mytop_status_t ret = MYTOP_OK;
+  if (ndrop > list->carry_cap) {
+    proc_carry_t *carry = realloc(list->carry, sizeof(proc_carry_t) * ndrop);
+    if (carry) {
+      list->carry = carry;
+      list->carry_cap = ndrop;
+    } else {
+      ret = MYTOP_ERR_NOMEM;
+    }
   }
-  
-  // Loop to read directory entries
-  struct dirent *dt;
-  while ((dt = readdir(dir)) != NULL) {
-    // Filter out ./ and ../ directories
-    if (strcmp(dt->d_name, ".") == 0 ||
-        strcmp(dt->d_name, "..") == 0)
-      continue;
 
-    // Filter out directories that are not purely numeric in name
-    if (!is_numeric_name(dt->d_name))
-      continue;
+  for (size_t i = keep; i < list->count; ++ i) {
+    const proc_info_t *p = &list->procs[i];
+    if (ret == MYTOP_OK) {
+      list->carry[list->ncarry ++] = (proc_carry_t){
+        .pid = p->pid,
+        .starttime = p->starttime,
+        .cpu_ticks = p->utime + p->stime,
+        .run_ns = p->run_ns,
+        .wait_ns = p->wait_ns,
+        .has_schedstat = p->has_schedstat,
+        .sample_ns = p->sample_ns,
+      };
+    }
+    list->dropped.count ++;
+    list->dropped.cpu_percent += p->cpu_percent;
+    list->dropped.rss += p->rss;
+    strtab_release(list->strtab, p->cmd);
+  }
+  list->count = keep;
+
+  qsort(list->carry, list->ncarry, sizeof(proc_carry_t), cmp_carry_pid);
+  shrink_procs_list(list, keep);
+
+  return ret;
+}
+
+/**
+ * Helper function
+ *
+ * @brief Order the records of a list by ascending PID (list->pid_order).
+ *
+ * A fresh scan comes in /proc order, which is already ascending, and is
+ * accepted after one check. A list sorted by another key is ordered by
+ * an LSD radix sort, 11 PID bits per pass (two passes up to
+ * PID_MAX_LIMIT), so the whole step stays linear.
+ */
+static mytop_status_t order_by_pid(proc_list_t *list) {
+  size_t n = list->count;
+  if (n > list->pid_cap) {
+    uint32_t *order = realloc(list->pid_order, sizeof(uint32_t) * list->capacity);
+    if (!order)
+      return MYTOP_ERR_NOMEM;
+    list->pid_order = order;
+    uint32_t *tmp = realloc(list->pid_tmp, sizeof(uint32_t) * list->capacity);
+    if (!tmp)
+      return MYTOP_ERR_NOMEM;
+    list->pid_tmp = tmp;
+    list->pid_cap = list->capacity;
+  }
+
+  bool sorted = true;
+  uint64_t max_pid = 0;
+  for (size_t i = 0; i < n; ++ i) {
+    list->pid_order[i] = (uint32_t)i;
+    if (i > 0 && list->procs[i].pid < list->procs[i - 1].pid)
+      sorted = false;
+    if (list->procs[i].pid > max_pid) max_pid = list->procs[i].pid;
+  }
+  if (sorted)
+    return MYTOP_OK;
+
+  uint32_t *src = list->pid_order, *dst = list->pid_tmp;
+  for (unsigned shift = 0; shift < 64 && (max_pid >> shift) != 0; shift += 11) {
+    uint32_t count[2048] = {0};
+    for (size_t i = 0; i < n; ++ i)
+      count[(list->procs[src[i]].pid >> shift) & 2047] ++;
+
+    uint32_t sum = 0;
+    for (size_t d = 0; d < 2048; ++ d) {
+      uint32_t c = count[d];
+      count[d] = sum;
+      sum += c;
+    }
+
+    for (size_t i = 0; i < n; ++ i)
+      dst[count[(list->procs[src[i]].pid >> shift) & 2047] ++] = src[i];
+
+    uint32_t *t = src;
+    src = dst;
+    dst = t;
+  }
+
+  // An odd number of passes leaves the result in the scratch array
+  list->pid_order = src;
+  list->pid_tmp = dst;
+
+  return MYTOP_OK;
+}
+
+/**
+ * Helper function
+ *
+ * @brief Binary search of a list by PID (list->pid_order must be valid).
+ *
+ * @return The record, or NULL if the PID is not in the list.
+ */
+static proc_info_t *find_pid(const proc_list_t *list, uint64_t pid) {
+  size_t lo = 0, hi = list->count;
+  while (lo < hi) {
+    size_t mid = lo + (hi - lo) / 2;
+    if (list->procs[list->pid_order[mid]].pid < pid)
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+  if (lo == list->count || list->procs[list->pid_order[lo]].pid != pid)
+    return NULL;
+
+  return &list->procs[list->pid_order[lo]];
+}
+
+/**
+ * Helper function
+ *
+ * @brief Read one process with plain read() calls and append it to a list.
+ *
+ * @param list        List to append to.
+ * @param name        /proc entry of the process.
+ * @param ino         Its inode, as listed.
+ * @param stat_fields Highest stat field to parse.
+ *
+ * @return
+ *  - MYTOP_OK if the process was appended.
+ *  - MYTOP_NO_FILE if it has exited since it was listed (nothing appended).
+ *  - Other codes on failure.
+ */
+static mytop_status_t read_proc_entry(proc_list_t *list, const char *name, uint64_t ino,
+                                      int stat_fields) {
+  // Capacity full
+  if (list->count >= list->capacity) {
+    size_t new_cap = list->capacity * 2;
+    proc_info_t *new_arr = realloc(list->procs, sizeof(proc_info_t) * new_cap);
+    if (!new_arr)
+      return MYTOP_ERR_NOMEM;
+
+    list->procs = new_arr;
+    list->capacity = new_cap;
+  }
+  proc_info_t *info = &list->procs[list->count];
+
+  /* ------ 1. Read /proc/[pid]/cmdline file --------- */
+  // Concatenate paths
+  mytop_status_t ret;
+  char file[64];
+  int n;
 
-    /* ------ 1. Read /proc/[pid]/cmdline file --------- */
-    // Concatenate paths
-    mytop_status_t ret;
-    char file[64];
-    int n;
-   
+  const char *cmd = NULL;
+  char comm[64];
+  size_t cmd_len = 0;
+  if (list->sources & SRC_CMDLINE) {
     n = snprintf(file, sizeof(file), 
-                     "/proc/%s/%s", dt->d_name, "cmdline");
+                     "/proc/%s/%s", name, "cmdline");
     if (n < 0)
       return MYTOP_ERR;
 
-    // Try to read cmdline
-    ret = read_cmdline(file, list->procs[list->count].cmd, MAX_CMD_LEN);
+    // Try to read cmdline (full length, into list->cmd_buf)
+    ret = read_cmdline(AT_FDCWD, file, list, &cmd_len);
     
-    // Error
-    if (ret == MYTOP_ERR || ret == MYTOP_ERR_PARAM) {
+    // Error, or the process has exited
+    if (ret == MYTOP_ERR || ret == MYTOP_ERR_PARAM || ret == MYTOP_ERR_NOMEM ||
+        ret == MYTOP_NO_FILE) {
       return ret;
     }
-    // File not is exit
-    else if (ret == MYTOP_NO_FILE) {
-      continue;
-    }
     // Need to read /proc/[pid]/comm file
     else if (ret == MYTOP_NO_DATA) {
       memset(file, 0, sizeof(file));
       n = snprintf(file, sizeof(file), 
-                     "/proc/%s/%s", dt->d_name, "comm");
+                     "/proc/%s/%s", name, "comm");
       if (n < 0)
         return MYTOP_ERR;
 
-      ret = read_comm(file, list->procs[list->count].cmd, MAX_CMD_LEN);
-      if (ret != MYTOP_OK) 
+      ret = read_comm(AT_FDCWD, file, comm, sizeof(comm), &cmd_len);
+      if (ret != MYTOP_OK)
         return ret;
+      cmd = comm;
+    } else {
+      // The scratch buffer may have moved while growing
+      cmd = list->cmd_buf;
     }
+  }
 
-    // Store pid field
-    ret = str_to_num(dt->d_name, 10, NUM_U64, &list->procs[list->count].pid);
-    if (ret != MYTOP_OK)
-      return ret;
+  // Store pid field
+  ret = str_to_num(name, 10, NUM_U64, &info->pid);
+  if (ret != MYTOP_OK)
+    return ret;
+  info->ino = ino;
+  info->stale = 0;
 
-    /* ------ 2. Read /proc/[pid]/cmdline stat --------- */
-    // Concatenate paths
-    memset(file, 0, sizeof(file));
-    
+  /* ------ 2. Read /proc/[pid]/cmdline stat --------- */
+  // Concatenate paths
+  memset(file, 0, sizeof(file));
+  
+  n = snprintf(file, sizeof(file), 
+                  "/proc/%s/%s", name, "stat");
+  if (n < 0)
+    return MYTOP_ERR;
+
+  ret = read_stat(file, info, stat_fields);
+  if (ret != MYTOP_OK)
+    return ret;
+  info->sample_ns = monotonic_ns();
+
+  /* ------ 3. Read /proc/[pid]/schedstat --------- */
+  info->has_schedstat = 0;
+  if (list->acct == ACCT_SCHEDSTAT && (list->sources & SRC_SCHEDSTAT)) {
     n = snprintf(file, sizeof(file), 
-                    "/proc/%s/%s", dt->d_name, "stat");
+                    "/proc/%s/%s", name, "schedstat");
     if (n < 0)
       return MYTOP_ERR;
 
-    ret = read_stat(file, &list->procs[list->count]);
-    if (ret != MYTOP_OK) 
-      return ret;
-    
-    // Capacity full
-    if (list->count >= list->capacity) {
-      size_t new_cap = list->capacity * 2;
-      proc_info_t *new_arr = realloc(list->procs, sizeof(proc_info_t) * new_cap);
-      if (!new_arr) 
-        return MYTOP_ERR_NOMEM;
+    // A failure falls back to jiffies for this process only
+    info->has_schedstat = read_schedstat(file, info) == MYTOP_OK;
+  }
 
-      list->procs = new_arr;
-      list->capacity = new_cap;
-    }
-    list->count ++;
+  /* ------ 4. Read /proc/[pid]/statm and /proc/[pid]/io --------- */
+  info->shared = 0;
+  if (list->sources & SRC_STATM) {
+    n = snprintf(file, sizeof(file), "/proc/%s/%s", name, "statm");
+    if (n < 0)
+      return MYTOP_ERR;
+    read_statm(file, info);
   }
 
-  closedir(dir);
+  info->has_io = 0;
+  if (list->sources & SRC_IO) {
+    n = snprintf(file, sizeof(file), "/proc/%s/%s", name, "io");
+    if (n < 0)
+      return MYTOP_ERR;
+    info->has_io = read_proc_io(file, info) == MYTOP_OK;
+  }
+
+  // Identical command lines share one interned copy
+  info->cmd = 0;
+  if (cmd) {
+    info->cmd = strtab_intern(list->strtab, cmd, cmd_len);
+    if (info->cmd == 0)
+      return MYTOP_ERR_NOMEM;
+  }
+
+  list->count ++;
   return MYTOP_OK;
 }
 
+// One io_uring submission worth of processes
+typedef struct {
+  proc_list_t *list;
+  size_t base;                      // Record of the first process (list->count when queued)
+  size_t n;                         // Processes in the batch
+  int stat_fields;
+  char names[URING_BATCH][16];      // /proc entry of each process
+  uint64_t inos[URING_BATCH];       // Its inode
+  int cmd_res[URING_BATCH];         // Result of the cmdline read
+  char comm[URING_BATCH][64];       // comm from stat, for kernel threads
+  uint8_t stat_ok[URING_BATCH];     // stat was read and parsed
+  mytop_status_t err;               // First parse error of the batch
+} uring_batch_t;
+
 /**
- * @brief Calculate CPU usage for all processes.
+ * Helper function
+ *
+ * @brief Parse one file of a batch as soon as its read completes.
+ */
+static void on_uring_read(void *ctx, size_t slot, int res, char *buf) {
+  uring_batch_t *b = ctx;
+  size_t i = slot / URING_FILES;
+  proc_info_t *info = &b->list->procs[b->base + i];
+
+  switch ((uring_file_t)(slot % URING_FILES)) {
+    case URING_CMDLINE:
+      b->cmd_res[i] = res;
+      break;
+    case URING_STAT: {
+      // Exited since the directory was listed
+      if (res <= 0)
+        break;
+      // Keep the comm before the fields are tokenized
+      char *open_paren = strchr(buf, '(');
+      char *end_paren = strrchr(buf, ')');
+      if (open_paren && end_paren > open_paren) {
+        size_t len = (size_t)(end_paren - open_paren - 1);
+        if (len >= sizeof(b->comm[i]))
+          len = sizeof(b->comm[i]) - 1;
+        memcpy(b->comm[i], open_paren + 1, len);
+        b->comm[i][len] = '\0';
+      }
+      mytop_status_t ret = parse_stat_buf(buf, info, b->stat_fields);
+      if (ret == MYTOP_OK)
+        b->stat_ok[i] = 1;
+      else if (b->err == MYTOP_OK)
+        b->err = ret;
+      break;
+    }
+    case URING_SCHEDSTAT:
+      // A failure falls back to jiffies for this process only
+      info->has_schedstat = res > 0 && parse_schedstat_buf(buf, info) == MYTOP_OK;
+      break;
+    case URING_STATM:
+      if (res > 0)
+        parse_statm_buf(buf, info);
+      break;
+    case URING_IO:
+      info->has_io = res > 0 && parse_proc_io_buf(buf, info) == MYTOP_OK;
+      break;
+    default:
+      break;
+  }
+}
+
+/**
+ * Helper function
  *
- * Iterate over each process in curr and search for the corresponding PID in prev.
- * If found, compute the difference and assign it to curr->procs[i].cpu_percent.
+ * @brief Read every file of a batch of processes with one submission,
+ *        then keep the processes whose stat was read.
  *
- * @param prev Process list from the previous round.
- * @param curr Current process list.
- * @param total_delta System‑wide CPU time delta (obtained from Phase 2 calculation).
+ * Mirrors the per-process path of parse_procs(): a process whose stat
+ * or cmdline has gone is skipped, an empty cmdline falls back to the
+ * comm, and a cmdline longer than a buffer is read again in full.
  */
-void calculate_procs_cpu(const proc_list_t *prev, proc_list_t *curr, uint64_t total_delta) {
-  if (total_delta == 0) return;
+static mytop_status_t flush_uring_batch(uring_batch_t *b) {
+  proc_list_t *list = b->list;
+  uring_t *ring = list->uring;
+
+  if (b->n == 0)
+    return MYTOP_OK;
+
+  mytop_status_t ret = reserve_procs_list(list, list->count + b->n);
+  if (ret != MYTOP_OK)
+    return ret;
+  b->base = list->count;
+  b->err = MYTOP_OK;
+
+  // 1. Queue the reads of every process
+  static const char *const file_names[URING_FILES] = {
+    [URING_CMDLINE] = "cmdline", [URING_STAT] = "stat", [URING_SCHEDSTAT] = "schedstat",
+    [URING_STATM] = "statm", [URING_IO] = "io",
+  };
+  bool want[URING_FILES] = {
+    [URING_CMDLINE] = list->sources & SRC_CMDLINE,
+    [URING_STAT] = true,
+    [URING_SCHEDSTAT] = list->acct == ACCT_SCHEDSTAT && (list->sources & SRC_SCHEDSTAT),
+    [URING_STATM] = list->sources & SRC_STATM,
+    [URING_IO] = list->sources & SRC_IO,
+  };
+
+  for (size_t i = 0; i < b->n; ++ i) {
+    proc_info_t *info = &list->procs[b->base + i];
+    ret = str_to_num(b->names[i], 10, NUM_U64, &info->pid);
+    if (ret != MYTOP_OK)
+      return ret;
+    info->ino = b->inos[i];
+    info->stale = 0;
+    info->has_schedstat = 0;
+    info->shared = 0;
+    info->has_io = 0;
+    b->stat_ok[i] = 0;
+    b->cmd_res[i] = -ENOENT;
+    b->comm[i][0] = '\0';
+
+    for (int f = 0; f < URING_FILES; ++ f) {
+      if (!want[f])
+        continue;
+      char path[URING_PATH_LEN];
+      int n = snprintf(path, sizeof(path), "/proc/%s/%s", b->names[i], file_names[f]);
+      if (n < 0)
+        return MYTOP_ERR;
+      uring_queue_read(ring, i * URING_FILES + (size_t)f, path);
+    }
+  }
 
-  long num_cores = get_core_count();
+  // 2. One submission; the files are parsed as their reads complete
+  if (uring_submit(ring, on_uring_read, b) != MYTOP_OK) {
+    // Completions of this batch may still arrive: the ring cannot be
+    // reused, so both lists go back to read() (the other one drops its
+    // pointer at its next scan) and the batch is read again that way
+    int err = errno;
+    LOG_WARN("Process", "io_uring submission failed (%s), reading /proc with read()",
+             strerror(err));
+    uring_free(ring);
+    list->uring = NULL;
+    for (size_t i = 0; i < b->n; ++ i) {
+      ret = read_proc_entry(list, b->names[i], b->inos[i], b->stat_fields);
+      if (ret != MYTOP_OK && ret != MYTOP_NO_FILE)
+        return ret;
+    }
+    b->n = 0;
+    return MYTOP_OK;
+  }
+  if (b->err != MYTOP_OK)
+    return b->err;
+  // The whole batch was read by that submission
+  uint64_t read_ns = monotonic_ns();
+  for (size_t i = 0; i < b->n; ++ i)
+    list->procs[b->base + i].sample_ns = read_ns;
+
+  // 3. Keep the processes that were fully read, in directory order
+  for (size_t i = 0; i < b->n; ++ i) {
+    if (!b->stat_ok[i])
+      continue;
 
-  // Traverse every process in current list
-  for (size_t i = 0; i < curr->count; ++ i) {
-    // Found process in previous list
-    int index = find_process_by_pid(prev, curr->procs[i].pid);
-    // Case 1: Not found!
-    if (index == -1) {
-      curr->procs[i].cpu_percent = 0.0;
+    const char *cmd = NULL;
+    size_t cmd_len = 0;
+    if (want[URING_CMDLINE]) {
+      int res = b->cmd_res[i];
+      char *buf = ring->bufs + (i * URING_FILES + URING_CMDLINE) * URING_SLOT_SIZE;
+      // Exited, or not ours to read
+      if (res < 0)
+        continue;
+
+      if ((size_t)res >= URING_SLOT_SIZE - 1) {
+        // Longer than a buffer: read it whole
+        char path[URING_PATH_LEN];
+        int n = snprintf(path, sizeof(path), "/proc/%s/%s", b->names[i], "cmdline");
+        if (n < 0)
+          return MYTOP_ERR;
+        ret = read_cmdline(AT_FDCWD, path, list, &cmd_len);
+        if (ret == MYTOP_NO_FILE)
+          continue;
+        if (ret != MYTOP_OK && ret != MYTOP_NO_DATA)
+          return ret;
+        cmd = ret == MYTOP_OK ? list->cmd_buf : NULL;
+      } else {
+        cmd_len = tidy_cmdline(buf, (size_t)res);
+        cmd = cmd_len > 0 ? buf : NULL;
+      }
+
+      // Kernel thread or zombie
+      if (!cmd) {
+        cmd = b->comm[i];
+        cmd_len = strlen(cmd);
+      }
     }
-    // Case 2: Found!
-    else {
-      // Compute cpu_percent
-      uint64_t proc_delta = 
-             (curr->procs[i].stime + curr->procs[i].utime) -  
-             (prev->procs[index].stime + prev->procs[index].utime);
-       
-      curr->procs[i].cpu_percent = ((double)proc_delta / total_delta) * 100 * num_cores;
+
+    proc_info_t *info = &list->procs[list->count];
+    if (b->base + i != list->count)
+      *info = list->procs[b->base + i];
+
+    // Identical command lines share one interned copy
+    info->cmd = 0;
+    if (cmd) {
+      info->cmd = strtab_intern(list->strtab, cmd, cmd_len);
+      if (info->cmd == 0)
+        return MYTOP_ERR_NOMEM;
     }
+
+    list->count ++;
   }
+
+  b->n = 0;
+  return MYTOP_OK;
 }
 
+/**
+ * @brief Add the PIDs of a comma-separated list ("-p 1,42") to a watch list.
+ *
+ * @return
+ *  - MYTOP_OK on success.
+ *  - MYTOP_ERR_PARSE if an entry is not a PID.
+ *  - MYTOP_ERR_NOMEM if the list would exceed WATCH_MAX_PROCS.
+ */
+mytop_status_t watch_add_pids(watch_t *w, const char *arg) {
+  // Check input parameters
+  if (!w || !arg)
+    return MYTOP_ERR_PARAM;
+
+  char buf[BUFFER_SIZE];
+  if (snprintf(buf, sizeof(buf), "%s", arg) >= (int)sizeof(buf))
+    return MYTOP_ERR_PARSE;
+
+  char *save = NULL;
+  for (char *tok = strtok_r(buf, ",", &save); tok; tok = strtok_r(NULL, ",", &save)) {
+    uint64_t pid;
+    if (str_to_num(tok, 10, NUM_U64, &pid) != MYTOP_OK || pid == 0)
+      return MYTOP_ERR_PARSE;
+    if (w->npids == WATCH_MAX_PROCS)
+      return MYTOP_ERR_NOMEM;
+    w->pids[w->npids ++] = pid;
+  }
+
+  return w->npids > 0 ? MYTOP_OK : MYTOP_ERR_PARSE;
+}
 
 /**
- * @brief Sort the process list.
+ * @brief Whether a watch list selects anything (-p, --pidfile or --match).
  */
-void sort_procs_by_mode(proc_list_t *list, sort_mode_t mode) {
-  if (!list)
-    return;
+bool watch_enabled(const watch_t *w) {
+  return w && (w->npids > 0 || w->pidfile || w->match[0]);
+}
 
-  switch (mode) {
-    case SORT_CPU:
-      qsort(list->procs, list->count, sizeof(list->procs[0]), cmp_proc_cpu_desc);
-      break;
-    case SORT_MEM:
-      qsort(list->procs, list->count, sizeof(list->procs[0]), cmp_proc_rss_desc);
-      break;
-    case SORT_PID:
-      qsort(list->procs, list->count, sizeof(list->procs[0]), cmp_proc_pid_desc);
-      break;
-    default:
-      break;
+/**
+ * Helper function
+ *
+ * @brief Read a file of a watched process from offset 0, opening it
+ *        relative to the process directory on first use.
+ *
+ * @return Bytes read, or -1 if the file cannot be read.
+ */
+static ssize_t read_watched(int dir_fd, int *fd, const char *name, char *buf, size_t size) {
+  if (*fd == -1) {
+    *fd = openat(dir_fd, name, O_RDONLY | O_CLOEXEC);
+    if (*fd == -1)
+      return -1;
   }
+
+  ssize_t n = pread(*fd, buf, size - 1, 0);
+  if (n >= 0)
+    buf[n] = '\0';
+  return n;
 }
 
 /**
- * @brief Debug print: Output information of the top N processes.
+ * Helper function
+ *
+ * @brief Stop following the i-th watched process.
  */
-void print_procs(const proc_list_t *list) {
-  if (!list) 
-    return;
+static void watch_drop(watch_t *w, size_t i) {
+  watch_proc_t *wp = &w->procs[i];
+  int *fds[] = { &wp->stat_fd, &wp->schedstat_fd, &wp->statm_fd, &wp->io_fd, &wp->dir_fd };
+  for (size_t f = 0; f < sizeof(fds) / sizeof(fds[0]); ++ f) {
+    if (*fds[f] != -1)
+      close(*fds[f]);
+  }
+  strtab_release(w->strtab, wp->cmd);
 
-  int rows, cols;
-  // Get terminal width and length
-  get_term_size(&rows, &cols);
-  int reserved_lines = 5 + 1 + 1 + 2;
-  int max_procs_to_show = rows - reserved_lines;
-  if (max_procs_to_show < 0) max_procs_to_show = 0;
-
-  // Read system time unit and page size
-  const long hz = sysconf(_SC_CLK_TCK);
-  const long pagesize_l = sysconf(_SC_PAGESIZE);
-  // sysconf fails and returns -1
-  const uint64_t pagesize = (pagesize_l > 0) ? (uint64_t)pagesize_l : 4096u;
-  // Fixed column width definition
-  const int W_PID   = 6;
-  const int W_PPID  = 6;
-  const int W_PGRP  = 6;
-  const int W_VIRT  = 8;
-  const int W_RES   = 8;
-  const int W_CPU   = 8;
-  const int W_TIME  = 10;
-
-  int fixed_width =
-      W_PID + 1 +   /* PID + space */
-      1     + 1 +   /* S + space   */
-      W_PPID+ 1 +   /* ...         */
-      W_PGRP+ 1 +
-      W_CPU + 1 + 
-      W_VIRT+ 1 +
-      W_RES + 1 +
-      W_TIME+ 1;
-  
-  // Compute COMMAND field width
-  int cmd_width = cols - fixed_width - 1;
-  if (cmd_width < 10) cmd_width = 10;      
-  if (cmd_width > 80) cmd_width = 80;
-
-  // Print table header
-  printf("%*s %s %*s %*s %*s %*s %*s %*s %s\n",
-           W_PID,  "PID",
-           "S",
-           W_PPID, "PPID",
-           W_PGRP, "PGRP",
-           W_CPU,  "CPU",
-           W_VIRT, "VIRT",
-           W_RES,  "RES",
-           W_TIME, "TIME+",
-           "COMMAND");
-  
-  size_t limit = (size_t)max_procs_to_show;
-  if (limit > list->count) limit = list->count;
+  w->procs[i] = w->procs[-- w->count];
+}
 
-  for (size_t i = 0; i < limit; i++) {
-    const proc_info_t *p = &list->procs[i];
-    uint64_t virt_kb = mem_uint_convert(p->vsize, MEM_B, MEM_KIB);
-    uint64_t res_kb  = pages_to_kb(p->rss, pagesize);
-
-    char timebuf[16];
-    format_time_hms(timebuf, sizeof(timebuf), p->utime + p->stime, hz);
-    printf("%*" PRIu64 " %c %*" PRIu64 " %*" PRIu64 " %*.*f%% %*" PRIu64 " %*" PRIu64 " %*s %-.*s\n",
-             W_PID,  p->pid,
-             p->state,
-             W_PPID, p->ppid,
-             W_PGRP, p->pgrp,
-             W_CPU, 2, p->cpu_percent,
-             W_VIRT, virt_kb,
-             W_RES,  res_kb,
-             W_TIME, timebuf,
-             cmd_width, p->cmd);
+/**
+ * Helper function
+ *
+ * @brief Start following a process, unless it already is.
+ *
+ * The directory descriptor pins the process: files opened through it
+ * later fail once it exits instead of reaching a new owner of the PID.
+ *
+ * @return The followed process, or NULL if it cannot be opened.
+ */
+static watch_proc_t *watch_open(watch_t *w, proc_list_t *list, uint64_t pid) {
+  for (size_t i = 0; i < w->count; ++ i) {
+    if (w->procs[i].pid == pid)
+      return &w->procs[i];
+  }
+  if (w->count == WATCH_MAX_PROCS) {
+    LOG_WARN("Process", "Watch list full (%d processes), ignoring PID %" PRIu64,
+             WATCH_MAX_PROCS, pid);
+    return NULL;
   }
+
+  char path[URING_PATH_LEN];
+  snprintf(path, sizeof(path), "/proc/%" PRIu64, pid);
+  int dir_fd = open(path, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+  if (dir_fd == -1)
+    return NULL;
+
+  // The start time identifies the process the directory pins
+  char buf[BUFFER_SIZE];
+  proc_info_t info;
+  int stat_fd = -1;
+  if (read_watched(dir_fd, &stat_fd, "stat", buf, sizeof(buf)) <= 0 ||
+      parse_stat_buf(buf, &info, STAT_MIN_FIELD) != MYTOP_OK) {
+    if (stat_fd != -1)
+      close(stat_fd);
+    close(dir_fd);
+    return NULL;
+  }
+
+  // The command line is read once: a watched service rarely changes it
+  size_t cmd_len = 0;
+  const char *cmd = NULL;
+  char comm[64];
+  if (read_cmdline(dir_fd, "cmdline", list, &cmd_len) == MYTOP_OK)
+    cmd = list->cmd_buf;
+  else if (read_comm(dir_fd, "comm", comm, sizeof(comm), &cmd_len) == MYTOP_OK)
+    cmd = comm;
+
+  watch_proc_t *wp = &w->procs[w->count ++];
+  wp->pid = pid;
+  wp->starttime = info.starttime;
+  wp->dir_fd = dir_fd;
+  wp->stat_fd = stat_fd;
+  wp->schedstat_fd = -1;
+  wp->statm_fd = -1;
+  wp->io_fd = -1;
+  wp->cmd = cmd ? strtab_intern(w->strtab, cmd, cmd_len) : 0;
+
+  return wp;
+}
+
+/**
+ * Helper function
+ *
+ * @brief Look for processes to follow: the -p PIDs that were not there
+ *        yet, the PID in the pidfile, and every process whose comm
+ *        contains the --match pattern (the only case walking /proc).
+ *
+ * A -p PID names the process first found under it: once that one is
+ * gone and the PID belongs to a process started later, the PID is
+ * dropped instead of following the new process.
+ */
+static void watch_rescan(watch_t *w, proc_list_t *list) {
+  size_t i = 0;
+  while (i < w->npids) {
+    watch_proc_t *wp = watch_open(w, list, w->pids[i]);
+    if (wp && w->pid_seen[i] && wp->starttime != w->pid_starts[i]) {
+      LOG_INFO("Process", "PID %" PRIu64 " was reused by another process, no longer watched",
+               w->pids[i]);
+      watch_drop(w, (size_t)(wp - w->procs));
+      -- w->npids;
+      w->pids[i] = w->pids[w->npids];
+      w->pid_starts[i] = w->pid_starts[w->npids];
+      w->pid_seen[i] = w->pid_seen[w->npids];
+      continue;
+    }
+    if (wp) {
+      w->pid_starts[i] = wp->starttime;
+      w->pid_seen[i] = 1;
+    }
+    i ++;
+  }
+
+  if (w->pidfile) {
+    char buf[32];
+    int fd = open(w->pidfile, O_RDONLY | O_CLOEXEC);
+    ssize_t n = fd == -1 ? -1 : read(fd, buf, sizeof(buf) - 1);
+    if (fd != -1)
+      close(fd);
+
+    uint64_t pid;
+    if (n > 0) {
+      buf[n] = '\0';
+      buf[strcspn(buf, " \n")] = '\0';
+    }
+    if (n > 0 && str_to_num(buf, 10, NUM_U64, &pid) == MYTOP_OK && pid > 0)
+      watch_open(w, list, pid);
+  }
+
+  if (w->match[0]) {
+    DIR *dir = opendir("/proc");
+    if (!dir) {
+      int err = errno;
+      LOG_ERROR("Process", "Cannot open /proc directory: %s", strerror(err));
+      return;
+    }
+
+    struct dirent *dt;
+    while ((dt = readdir(dir)) != NULL) {
+      uint64_t pid;
+      if (!is_numeric_name(dt->d_name) || str_to_num(dt->d_name, 10, NUM_U64, &pid) != MYTOP_OK)
+        continue;
+
+      char path[URING_PATH_LEN], comm[64];
+      size_t len;
+      snprintf(path, sizeof(path), "/proc/%" PRIu64 "/comm", pid);
+      int fd = open(path, O_RDONLY | O_CLOEXEC);
+      if (fd == -1)
+        continue;
+      ssize_t n = read(fd, comm, sizeof(comm) - 1);
+      close(fd);
+      if (n <= 0)
+        continue;
+      len = (size_t)n;
+      if (comm[len - 1] == '\n') len --;
+      comm[len] = '\0';
+
+      if (strstr(comm, w->match))
+        watch_open(w, list, pid);
+    }
+    closedir(dir);
+  }
+}
+
+/**
+ * Helper function
+ *
+ * @brief Scan only the watched processes, without walking /proc.
+ *
+ * Each file is read with one pread() on a descriptor kept open, so a
+ * tick costs a few system calls per watched process. Processes that
+ * exited are dropped; new matches are only looked for every
+ * WATCH_RESCAN_MS.
+ */
+static mytop_status_t scan_watch(proc_list_t *list, int stat_fields) {
+  watch_t *w = list->watch;
+  if (!w->strtab)
+    w->strtab = list->strtab;
+
+  if (list->sample_ns >= w->next_rescan_ns) {
+    watch_rescan(w, list);
+    w->next_rescan_ns = list->sample_ns + WATCH_RESCAN_MS * 1000000ull;
+  }
+
+  mytop_status_t ret = reserve_procs_list(list, list->count + w->count);
+  if (ret != MYTOP_OK)
+    return ret;
+
+  size_t i = 0;
+  while (i < w->count) {
+    watch_proc_t *wp = &w->procs[i];
+    proc_info_t *info = &list->procs[list->count];
+    char buf[BUFFER_SIZE];
+
+    // ESRCH once the process is gone: the descriptor never follows a reused PID
+    if (read_watched(wp->dir_fd, &wp->stat_fd, "stat", buf, sizeof(buf)) <= 0 ||
+        parse_stat_buf(buf, info, stat_fields) != MYTOP_OK) {
+      watch_drop(w, i);
+      continue;
+    }
+    info->pid = wp->pid;
+    info->sample_ns = monotonic_ns();
+    info->stale = 0;
+
+    info->has_schedstat = 0;
+    if (list->acct == ACCT_SCHEDSTAT && (list->sources & SRC_SCHEDSTAT) &&
+        read_watched(wp->dir_fd, &wp->schedstat_fd, "schedstat", buf, sizeof(buf)) > 0)
+      info->has_schedstat = parse_schedstat_buf(buf, info) == MYTOP_OK;
+
+    info->shared = 0;
+    if ((list->sources & SRC_STATM) &&
+        read_watched(wp->dir_fd, &wp->statm_fd, "statm", buf, sizeof(buf)) > 0)
+      parse_statm_buf(buf, info);
+
+    info->has_io = 0;
+    if ((list->sources & SRC_IO) &&
+        read_watched(wp->dir_fd, &wp->io_fd, "io", buf, sizeof(buf)) > 0)
+      info->has_io = parse_proc_io_buf(buf, info) == MYTOP_OK;
+
+    info->cmd = wp->cmd;
+    strtab_ref(list->strtab, info->cmd);
+
+    list->count ++;
+    i ++;
+  }
+
+  return MYTOP_OK;
+}
+
+/**
+ * @brief Let the scans of two lists read only the processes of a watch
+ *        list instead of walking /proc.
+ */
+void procs_attach_watch(watch_t *w, proc_list_t *a, proc_list_t *b) {
+  if (!watch_enabled(w))
+    return;
+
+  a->watch = b->watch = w;
+  w->next_rescan_ns = 0;
+}
+
+/**
+ * @brief Close every descriptor of a watch list and drop its references.
+ */
+void watch_free(watch_t *w) {
+  if (!w)
+    return;
+
+  while (w->count > 0)
+    watch_drop(w, w->count - 1);
+}
+
+// Which processes a sampled scan reads again
+typedef struct {
+  proc_list_t *prev;      // Previous scan (pid_order valid), sorted by the active key
+  uint32_t slices;        // 1/slices of the PIDs are read per scan
+  uint32_t slice;         // PIDs equal to slice modulo slices are read this scan
+} sample_plan_t;
+
+/**
+ * Helper function
+ *
+ * @brief Copy the previous record of a process left out of this sampled
+ *        scan, marked stale.
+ *
+ * New processes, those in this scan's slice and the SAMPLE_HOT_PROCS
+ * first ones of the previous order are read again instead. So is a PID
+ * whose /proc directory has another inode than when it was read: the
+ * PID was reused by a new process (or the dentry was dropped from the
+ * cache, which only costs a read; the start time read then decides).
+ *
+ * @param ino Inode of the /proc entry, as listed by readdir().
+ *
+ * @return
+ *  - MYTOP_OK if the record was kept.
+ *  - MYTOP_NO_DATA if the process must be read.
+ *  - MYTOP_ERR_NOMEM if the list could not grow.
+ */
+static mytop_status_t keep_unsampled(proc_list_t *list, const sample_plan_t *plan,
+                                     const char *name, uint64_t ino) {
+  uint64_t pid;
+  if (str_to_num(name, 10, NUM_U64, &pid) != MYTOP_OK || pid % plan->slices == plan->slice)
+    return MYTOP_NO_DATA;
+
+  const proc_list_t *prev = plan->prev;
+  const proc_info_t *old = find_pid(prev, pid);
+  if (!old)
+    return MYTOP_NO_DATA;
+
+  size_t idx = (size_t)(old - prev->procs);
+  if (idx < SAMPLE_HOT_PROCS)
+    return MYTOP_NO_DATA;
+
+  // Every /proc/[pid] lookup of a new process allocates a new inode, so
+  // this tells a reused PID apart without reading its stat
+  if (ino == 0 || old->ino != ino)
+    return MYTOP_NO_DATA;
+
+  if (reserve_procs_list(list, list->count + 1) != MYTOP_OK)
+    return MYTOP_ERR_NOMEM;
+
+  proc_info_t *info = &list->procs[list->count ++];
+  *info = prev->procs[idx];
+  info->stale = 1;
+  strtab_ref(list->strtab, info->cmd);
+
+  return MYTOP_OK;
+}
+
+/**
+ * Helper function
+ *
+ * @brief Scan /proc into a list, reading every process (plan = NULL) or
+ *        only those a sampled scan selects.
+ *
+ * Past deadline_ns (0 = none) the remaining processes are only counted
+ * in list->unread.
+ */
+static mytop_status_t scan_procs(proc_list_t *list, const sample_plan_t *plan,
+                                 uint64_t deadline_ns) {
+  list->sample_ns = monotonic_ns();
+  list->unread = 0;
+  int stat_fields = list->stat_fields < STAT_MIN_FIELD ? STAT_MIN_FIELD : list->stat_fields;
+
+  if (list->watch)
+    return scan_watch(list, stat_fields);
+
+  // The other list's scan gave the shared ring up (see flush_uring_batch())
+  if (list->uring && list->uring->fd == -1)
+    list->uring = NULL;
+
+  // 1. Traverse the /proc directories
+  // Open /proc directory
+  DIR *dir = opendir("/proc");
+  if (!dir) {
+    int err = errno;
+    LOG_ERROR("Process", "Cannot open /proc directory: %s", strerror(err));
+    return MYTOP_ERR_IO;
+  }
+
+  uring_batch_t batch;
+  batch.list = list;
+  batch.n = 0;
+  batch.stat_fields = stat_fields;
+  
+  // Loop to read directory entries
+  struct dirent *dt;
+  while ((dt = readdir(dir)) != NULL) {
+    // Filter out ./ and ../ directories
+    if (strcmp(dt->d_name, ".") == 0 ||
+        strcmp(dt->d_name, "..") == 0)
+      continue;
+
+    // Filter out directories that are not purely numeric in name
+    if (!is_numeric_name(dt->d_name))
+      continue;
+
+    // Bounded scan: once out of time, listing the rest is all that is left
+    if (deadline_ns && (list->unread || monotonic_ns() >= deadline_ns)) {
+      list->unread ++;
+      continue;
+    }
+
+    // Sampled scan: outside the slice, the last record stands in
+    if (plan) {
+      mytop_status_t ret = keep_unsampled(list, plan, dt->d_name, dt->d_ino);
+      if (ret == MYTOP_OK)
+        continue;
+      if (ret != MYTOP_NO_DATA) {
+        closedir(dir);
+        return ret;
+      }
+    }
+
+    // Batched reads: queue the process, submit once the batch is full
+    if (list->uring) {
+      size_t len = strlen(dt->d_name);
+      if (len >= sizeof(batch.names[0]))
+        continue;
+      memcpy(batch.names[batch.n], dt->d_name, len + 1);
+      batch.inos[batch.n] = dt->d_ino;
+      if (++ batch.n == URING_BATCH) {
+        mytop_status_t ret = flush_uring_batch(&batch);
+        if (ret != MYTOP_OK) {
+          closedir(dir);
+          return ret;
+        }
+      }
+      continue;
+    }
+
+    mytop_status_t ret = read_proc_entry(list, dt->d_name, dt->d_ino, stat_fields);
+    // Exited since the directory was listed
+    if (ret != MYTOP_OK && ret != MYTOP_NO_FILE) {
+      closedir(dir);
+      return ret;
+    }
+  }
+
+  closedir(dir);
+  return flush_uring_batch(&batch);
+}
+
+/**
+ * @brief Scan and parse all current processes
+ *
+ * 1. Traverse the /proc directory.
+ * 2. Filter out numeric directories.
+ * 3. Read /proc/[pid]/stat to parse detailed information.
+ * 4. Store results in the list container (automatically expands as needed).
+ *
+ * Only the files in list->sources are opened, and stat is only parsed
+ * up to list->stat_fields, so hidden columns cost nothing.
+ *
+ * With list->uring set, the files of URING_BATCH processes at a time
+ * are read through one io_uring submission instead of one
+ * open/read/close sequence each. With list->watch set, only the watched
+ * processes are read and /proc is not walked.
+ *
+ * @param list Result storage container (must be initialized before calling, or pass an existing list to reuse memory)
+ * @return mytop_status_t
+ */
+mytop_status_t parse_procs(proc_list_t *list) {
+  // Check input parameters
+  if (!list)
+    return MYTOP_ERR_PARAM;
+
+  return scan_procs(list, NULL, 0);
+}
+
+/**
+ * @brief Scan the processes, reading only a rotating slice of them.
+ *
+ * Every PID is still listed, so births and deaths are exact, but only
+ * the processes whose PID falls in this scan's slice (PID modulo slices
+ * = scan modulo slices), new processes and the SAMPLE_HOT_PROCS first
+ * ones of prev are read. The others keep their record from prev, marked
+ * stale: each process is read at least once every slices scans. A scan
+ * costs the /proc listing plus the reads of its slice and of the hot
+ * set; PID reuse is told from the inode listed, without reading stat.
+ * CPU% of a re-read process is computed over its own interval (see
+ * calculate_procs_cpu()).
+ *
+ * @param list   Result list (cleared).
+ * @param prev   Previous scan, sorted by the active key.
+ * @param slices Number of slices (<= 1 reads every process).
+ * @param scan   Scan counter selecting the slice.
+ */
+mytop_status_t parse_procs_sampled(proc_list_t *list, proc_list_t *prev, uint32_t slices,
+                                   uint64_t scan) {
+  // Check input parameters
+  if (!list || !prev)
+    return MYTOP_ERR_PARAM;
+
+  if (slices <= 1 || prev->count == 0)
+    return scan_procs(list, NULL, 0);
+
+  // A PID miss only costs a full read, so ordering may fail safely
+  if (order_by_pid(prev) != MYTOP_OK)
+    return scan_procs(list, NULL, 0);
+
+  sample_plan_t plan = { .prev = prev, .slices = slices, .slice = (uint32_t)(scan % slices) };
+  return scan_procs(list, &plan, 0);
+}
+
+/**
+ * @brief Scan the processes for at most budget_ns.
+ *
+ * The processes listed once the budget is spent are not read, only
+ * counted in list->unread, so a first frame can be drawn from part of
+ * a large process table while the full scan still runs. Watched
+ * processes are always all read.
+ *
+ * @param list      Result list (cleared).
+ * @param budget_ns Time allowed for reading (0 = unbounded).
+ */
+mytop_status_t parse_procs_bounded(proc_list_t *list, uint64_t budget_ns) {
+  // Check input parameters
+  if (!list)
+    return MYTOP_ERR_PARAM;
+
+  return scan_procs(list, NULL, budget_ns ? monotonic_ns() + budget_ns : 0);
+}
+
+/**
+ * @brief Let the scans of two lists read /proc through io_uring.
+ *
+ * Without io_uring (old kernel, disabled by sysctl or blocked by
+ * seccomp) the lists keep reading every file with plain read() calls.
+ *
+ * @return true if the lists now scan through the ring.
+ */
+bool procs_attach_uring(uring_t *ring, proc_list_t *a, proc_list_t *b) {
+  if (uring_init(ring, URING_BATCH * URING_FILES) != MYTOP_OK) {
+    int err = errno;
+    LOG_INFO("Process", "io_uring unavailable (%s), reading /proc with read()", strerror(err));
+    return false;
+  }
+
+  a->uring = b->uring = ring;
+  LOG_INFO("Process", "Reading /proc through io_uring, %d processes per submission%s",
+           URING_BATCH, ring->fixed_bufs ? "" : " (unregistered buffers)");
+  return true;
+}
+
+/**
+ * @brief Read proportional memory accounting of one process.
+ *
+ * /proc/[pid]/smaps_rollup walks the page tables of the whole address
+ * space, so it is far more expensive than stat: call it only for rows
+ * that are actually displayed.
+ *
+ * @param pid   Process ID.
+ * @param smaps Stores the parsing result.
+ *
+ * @return
+ *  - MYTOP_OK on success.
+ *  - MYTOP_NO_FILE if the process exited or access is denied.
+ *  - MYTOP_NO_DATA if the process has no address space (kernel thread).
+ *  - MYTOP_ERR_PARAM on parameter error.
+ */
+mytop_status_t parse_smaps_rollup(uint64_t pid, smaps_info_t *smaps) {
+  // Check input parameters
+  if (!smaps)
+    return MYTOP_ERR_PARAM;
+
+  char file[64];
+  snprintf(file, sizeof(file), "/proc/%" PRIu64 "/smaps_rollup", pid);
+
+  FILE *fp = fopen(file, "r");
+  if (!fp)
+    return MYTOP_NO_FILE;
+
+  char buf[BUFFER_SIZE * 2];
+  size_t n = fread(buf, 1, sizeof(buf) - 1, fp);
+  fclose(fp);
+  if (n == 0)
+    return MYTOP_NO_DATA;
+  buf[n] = '\0';
+
+  uint64_t pss = 0, swap = 0;
+  uint64_t priv_clean = 0, priv_dirty = 0, priv_huge = 0;
+
+  // The first line is the "[rollup]" VMA header, the rest are "Key: value kB"
+  char *save = NULL;
+  for (char *line = strtok_r(buf, "\n", &save); line; line = strtok_r(NULL, "\n", &save)) {
+    if (match_kb_line(line, "Pss:", 4, &pss)) continue;
+    if (match_kb_line(line, "Swap:", 5, &swap)) continue;
+    if (match_kb_line(line, "Private_Clean:", 14, &priv_clean)) continue;
+    if (match_kb_line(line, "Private_Dirty:", 14, &priv_dirty)) continue;
+    if (match_kb_line(line, "Private_Hugetlb:", 16, &priv_huge)) continue;
+  }
+
+  smaps->pss = pss;
+  smaps->uss = priv_clean + priv_dirty + priv_huge;
+  smaps->swap = swap;
+
+  return MYTOP_OK;
+}
+
+/**
+ * @brief Read the context switch counters of one process.
+ *
+ * They are only in /proc/[pid]/status, a much longer file than stat,
+ * so call it only for rows that are actually displayed.
+ *
+ * @param pid   Process ID.
+ * @param vcsw  voluntary_ctxt_switches (blocked, e.g. on a lock or I/O). [out]
+ * @param nvcsw nonvoluntary_ctxt_switches (preempted). [out]
+ *
+ * @return
+ *  - MYTOP_OK on success.
+ *  - MYTOP_NO_FILE if the process exited.
+ *  - MYTOP_NO_DATA if the counters are missing.
+ */
+mytop_status_t parse_proc_ctxsw(uint64_t pid, uint64_t *vcsw, uint64_t *nvcsw) {
+  // Check input parameters
+  if (!vcsw || !nvcsw)
+    return MYTOP_ERR_PARAM;
+
+  char file[64];
+  snprintf(file, sizeof(file), "/proc/%" PRIu64 "/status", pid);
+
+  int fd = open(file, O_RDONLY | O_CLOEXEC);
+  if (fd == -1)
+    return MYTOP_NO_FILE;
+
+  char buf[BUFFER_SIZE * 4];
+  ssize_t n = read(fd, buf, sizeof(buf) - 1);
+  close(fd);
+  if (n <= 0)
+    return MYTOP_NO_FILE;
+  buf[n] = '\0';
+
+  // Both counters are the last lines of the file
+  bool got_v = false, got_nv = false;
+  char *save = NULL;
+  for (char *line = strtok_r(buf, "\n", &save); line; line = strtok_r(NULL, "\n", &save)) {
+    if (!got_v && match_kb_line(line, "voluntary_ctxt_switches:", 24, vcsw))
+      got_v = true;
+    else if (!got_nv && match_kb_line(line, "nonvoluntary_ctxt_switches:", 27, nvcsw))
+      got_nv = true;
+  }
+
+  return got_v && got_nv ? MYTOP_OK : MYTOP_NO_DATA;
+}
+
+/**
+ * @brief Read only the start time (field 22) of /proc/[pid]/stat.
+ *
+ * Used to confirm that a PID still names the process seen in a scan.
+ *
+ * @return
+ *  - MYTOP_OK on success.
+ *  - MYTOP_NO_FILE if the process exited.
+ *  - MYTOP_ERR_PARSE on unexpected content.
+ */
+mytop_status_t read_proc_starttime(uint64_t pid, uint64_t *starttime) {
+  // Check input parameters
+  if (!starttime)
+    return MYTOP_ERR_PARAM;
+
+  char file[64];
+  snprintf(file, sizeof(file), "/proc/%" PRIu64 "/stat", pid);
+
+  int fd = open(file, O_RDONLY | O_CLOEXEC);
+  if (fd == -1)
+    return MYTOP_NO_FILE;
+
+  char buf[BUFFER_SIZE];
+  ssize_t n = read(fd, buf, sizeof(buf) - 1);
+  close(fd);
+  if (n <= 0)
+    return MYTOP_NO_FILE;
+  buf[n] = '\0';
+
+  // Fields counted from the state (3) after the last ')' of comm
+  const char *p = strrchr(buf, ')');
+  if (!p)
+    return MYTOP_ERR_PARSE;
+  p ++;
+  for (int field = 3; field <= 22; ++ field) {
+    p = skip_spaces(p);
+    if (field == 22)
+      break;
+    while (*p && *p != ' ') p ++;
+  }
+
+  char *end;
+  errno = 0;
+  *starttime = strtoull(p, &end, 10);
+  if (end == p || errno == ERANGE)
+    return MYTOP_ERR_PARSE;
+
+  return MYTOP_OK;
+}
+
+// Constants of one calculate_procs_cpu() pass
+typedef struct {
+  uint64_t elapsed_ns;    // Wall time between the scans (records without a timestamp)
+  long hz;
+  int stat_fields;        // Highest stat field parsed by both scans
+  int children;           // Add the reaped children's time (cutime + cstime)
+} delta_ctx_t;
+
+/**
+ * Helper function
+ *
+ * @brief Compute the rates of a process from its previous sample
+ *        (old = NULL for a process that was not in the previous scan).
+ */
+static void proc_deltas(const proc_info_t *old, proc_info_t *p, const delta_ctx_t *ctx) {
+  p->cpu_percent = 0.0;
+  p->delay_percent = 0.0;
+  p->minflt_rate = 0.0;
+  p->majflt_rate = 0.0;
+  p->iodelay_percent = 0.0;
+  p->read_rate = 0.0;
+  p->write_rate = 0.0;
+  p->migrate_rate = 0.0;
+  p->migrations = 0;
+  p->child_percent = 0.0;
+  p->child_ticks = 0;
+  if (!old)
+    return;
+
+  // A change of last CPU is at least one migration since the previous scan
+  bool migrated = ctx->stat_fields >= 39 && old->processor >= 0 && p->processor != old->processor;
+  p->migrations = old->migrations + migrated;
+
+  // Each record is timestamped when its stat is read: a process read late
+  // in a slow scan, or stale (sampled scan), is measured over its own interval
+  uint64_t elapsed_ns = ctx->elapsed_ns;
+  if (old->sample_ns && p->sample_ns > old->sample_ns)
+    elapsed_ns = p->sample_ns - old->sample_ns;
+
+  double elapsed_s = elapsed_ns / 1e9;
+  if (elapsed_s > 0) {
+    p->minflt_rate = (p->minflt - old->minflt) / elapsed_s;
+    p->majflt_rate = (p->majflt - old->majflt) / elapsed_s;
+    if (migrated)
+      p->migrate_rate = 1 / elapsed_s;
+    if (ctx->stat_fields >= 42 && ctx->hz > 0)
+      p->iodelay_percent = (double)(p->blkio_ticks - old->blkio_ticks) / ctx->hz / elapsed_s * 100;
+    // A column just shown has no previous sample yet
+    if (p->has_io && old->has_io) {
+      p->read_rate = (p->read_bytes - old->read_bytes) / elapsed_s;
+      p->write_rate = (p->write_bytes - old->write_bytes) / elapsed_s;
+    }
+  }
+
+  // Nanosecond accounting
+  if (p->has_schedstat && old->has_schedstat && elapsed_ns > 0) {
+    uint64_t run_delta = p->run_ns - old->run_ns;
+    uint64_t wait_delta = p->wait_ns - old->wait_ns;
+
+    p->cpu_percent = ((double)run_delta / elapsed_ns) * 100;
+    p->delay_percent = ((double)wait_delta / elapsed_ns) * 100;
+  }
+  // Jiffies accounting, over the same wall time (100% = one core)
+  else if (ctx->hz > 0 && elapsed_s > 0) {
+    uint64_t proc_delta = (p->stime + p->utime) - (old->stime + old->utime);
+    p->cpu_percent = (double)proc_delta / ctx->hz / elapsed_s * 100;
+  }
+
+  // Children waited for in the interval, charged in jiffies (no ns counter exists)
+  uint64_t child_now = p->cutime + p->cstime, child_then = old->cutime + old->cstime;
+  if (ctx->children && child_now > child_then && ctx->hz > 0 && elapsed_s > 0) {
+    p->child_ticks = child_now - child_then;
+    p->child_percent = (double)p->child_ticks / ctx->hz / elapsed_s * 100;
+    p->cpu_percent += p->child_percent;
+  }
+}
+
+/**
+ * Helper function
+ *
+ * @brief Remember a departed process in the recent exits ring.
+ */
+static void record_exit(lifecycle_t *lc, const proc_list_t *list, const proc_info_t *p) {
+  proc_exit_t *x = &lc->exits[lc->exit_head];
+  x->pid = p->pid;
+  x->cpu_ticks = p->utime + p->stime;
+  x->run_ns = p->has_schedstat ? p->run_ns : 0;
+  snprintf(x->cmd, sizeof(x->cmd), "%s", strtab_get(list->strtab, p->cmd));
+
+  lc->exit_head = (lc->exit_head + 1) % EXIT_RING_LEN;
+  if (lc->exit_count < EXIT_RING_LEN) lc->exit_count ++;
+  lc->total_exits ++;
+}
+
+/**
+ * Helper function
+ *
+ * @brief Stand in a full record for a process of the previous scan that
+ *        was only kept as counters (see cap_procs_list()).
+ *
+ * The other counters are taken from the current sample, so only CPU%
+ * is computed for it.
+ */
+static const proc_info_t *carry_stub(const proc_carry_t *c, const proc_info_t *p,
+                                     proc_info_t *stub) {
+  if (p && p->pid == c->pid)
+    *stub = *p;
+  else
+    memset(stub, 0, sizeof(*stub));
+
+  stub->pid = c->pid;
+  stub->starttime = c->starttime;
+  stub->utime = c->cpu_ticks;
+  stub->stime = 0;
+  stub->run_ns = c->run_ns;
+  stub->wait_ns = c->wait_ns;
+  stub->has_schedstat = c->has_schedstat;
+  stub->sample_ns = c->sample_ns;
+  stub->migrations = 0;
+  stub->cmd = 0;
+
+  return stub;
+}
+
+/**
+ * Helper function
+ *
+ * @brief Merge-join two scans by PID.
+ *
+ * Walks both PID orders once: a PID only in curr is a birth, one only
+ * in prev is a death, and a PID in both with another start time is
+ * both (reused). Matched processes get their rates when ctx is set.
+ * Processes prev only kept as counters (prev->carry, by PID) take part
+ * as well; their exits are counted but not listed, as their names are
+ * gone.
+ *
+ * @return false if the scans could not be ordered by PID.
+ */
+static bool merge_procs(proc_list_t *prev, proc_list_t *curr, lifecycle_t *lc,
+                        const delta_ctx_t *ctx) {
+  if (order_by_pid(prev) != MYTOP_OK || order_by_pid(curr) != MYTOP_OK) {
+    LOG_WARN("Process", "Cannot order %zu processes by PID", curr->count);
+    return false;
+  }
+
+  if (lc) {
+    lc->births = 0;
+    lc->deaths = 0;
+  }
+
+  proc_info_t stub;
+  size_t i = 0, j = 0, k = 0;
+  while (i < prev->count || k < prev->ncarry || j < curr->count) {
+    const proc_info_t *old = i < prev->count ? &prev->procs[prev->pid_order[i]] : NULL;
+    proc_info_t *p = j < curr->count ? &curr->procs[curr->pid_order[j]] : NULL;
+
+    // A carried PID is never also in prev->procs
+    bool carried = k < prev->ncarry && (!old || prev->carry[k].pid < old->pid);
+    if (carried)
+      old = carry_stub(&prev->carry[k], p, &stub);
+
+    // Only in prev: exited
+    if (!p || (old && old->pid < p->pid)) {
+      if (lc) {
+        lc->deaths ++;
+        if (!carried) record_exit(lc, prev, old);
+      }
+      if (carried) k ++; else i ++;
+      continue;
+    }
+    // Only in curr: started
+    if (!old || p->pid < old->pid) {
+      if (lc) lc->births ++;
+      if (ctx) proc_deltas(NULL, p, ctx);
+      j ++;
+      continue;
+    }
+
+    // Same PID, but a new process took it over
+    bool same = old->starttime == p->starttime;
+    if (!same && lc) {
+      lc->deaths ++;
+      lc->births ++;
+      if (!carried) record_exit(lc, prev, old);
+    }
+    // A stale record keeps the rates of its last read
+    if (ctx && !p->stale) proc_deltas(same ? old : NULL, p, ctx);
+    if (carried) k ++; else i ++;
+    j ++;
+  }
+
+  return true;
+}
+
+/**
+ * Helper function
+ *
+ * @brief Take back from the children share of each parent the time its
+ *        departed children already showed on their own rows.
+ *
+ * A child waited for in the interval adds its whole lifetime to the
+ * cutime/cstime of its parent, but only the part no scan saw (all of a
+ * short-lived child, the last moments of the others) is new. A child
+ * that left with its parent in the same interval reaches the nearest
+ * ancestor still running through that parent. An ancestor younger than
+ * the child is a new owner of the PID and stops the walk.
+ */
+static void uncount_seen_children(const proc_list_t *prev, proc_list_t *curr) {
+  size_t j = 0;
+  for (size_t i = 0; i < prev->count; ++ i) {
+    const proc_info_t *old = &prev->procs[prev->pid_order[i]];
+    while (j < curr->count && curr->procs[curr->pid_order[j]].pid < old->pid)
+      j ++;
+    const proc_info_t *p = j < curr->count ? &curr->procs[curr->pid_order[j]] : NULL;
+    if (p && p->pid == old->pid && p->starttime == old->starttime)
+      continue;
+
+    // Up to the first ancestor still running
+    proc_info_t *parent = NULL;
+    const proc_info_t *child = old;
+    for (int depth = 0; depth < 64 && child->ppid != 0; ++ depth) {
+      parent = find_pid(curr, child->ppid);
+      if (parent || !(child = find_pid(prev, child->ppid)))
+        break;
+    }
+    if (!parent || parent->stale || parent->child_ticks == 0 || parent->starttime > old->starttime)
+      continue;
+
+    uint64_t seen = old->utime + old->stime + old->cutime + old->cstime;
+    uint64_t take = seen < parent->child_ticks ? seen : parent->child_ticks;
+    double share = parent->child_percent * take / parent->child_ticks;
+    parent->cpu_percent -= share;
+    parent->child_percent -= share;
+    parent->child_ticks -= take;
+  }
+}
+
+/**
+ * @brief Calculate CPU usage for all processes.
+ *
+ * Both scans are merge-joined by PID in linear time (see merge_procs()).
+ *
+ * When both samples carry schedstat counters, CPU and run delay
+ * percentages are computed from nanoseconds over the wall time between
+ * the two scans, which stays accurate at sub-second intervals. Otherwise
+ * the jiffy counters are used (quantized to 1/USER_HZ per interval).
+ *
+ * Either way the wall time is that of the process itself, between the
+ * CLOCK_MONOTONIC timestamps of its two stat reads (jiffies are divided
+ * by that time × CLK_TCK). A process read at the end of a slow scan is
+ * therefore not measured against the /proc/stat delta taken at its
+ * start, and the online core count plays no part.
+ *
+ * Fault rates, the block I/O delay share, storage throughput and
+ * migrations (changes of the last CPU, stat field 39) come from values
+ * already read by the scan, in the same pass.
+ *
+ * With curr->children set, each process is also charged the CPU time
+ * of the children it waited for in the interval (stat fields 16/17),
+ * less what those children had already shown themselves, so a shell
+ * forking short-lived commands shows their cost.
+ *
+ * @param prev Process list from the previous round.
+ * @param curr Current process list.
+ * @param lc   Births, deaths and recent exits of the interval (may be NULL).
+ */
+void calculate_procs_cpu(proc_list_t *prev, proc_list_t *curr, lifecycle_t *lc) {
+  if (!prev || !curr)
+    return;
+
+  delta_ctx_t ctx = {
+    .elapsed_ns = curr->sample_ns > prev->sample_ns ? curr->sample_ns - prev->sample_ns : 0,
+    .hz = sysconf(_SC_CLK_TCK),
+    .stat_fields = prev->stat_fields < curr->stat_fields ? prev->stat_fields : curr->stat_fields,
+    .children = curr->children,
+  };
+
+  if (merge_procs(prev, curr, lc, &ctx) && ctx.children)
+    uncount_seen_children(prev, curr);
+}
+
+/**
+ * @brief Estimate CPU usage from a single scan, as lifetime averages.
+ *
+ * CPU% is the CPU time of each process over its age (now minus
+ * starttime), in nanoseconds when schedstat is available. It stands in
+ * for the first frame until a second scan gives real deltas; the other
+ * rates are left at zero.
+ */
+void estimate_procs_cpu(proc_list_t *list) {
+  if (!list)
+    return;
+
+  delta_ctx_t ctx = { .hz = sysconf(_SC_CLK_TCK) };
+  if (ctx.hz <= 0)
+    return;
+
+  uint64_t now_ns = boottime_ns();
+  for (size_t i = 0; i < list->count; ++ i) {
+    proc_info_t *p = &list->procs[i];
+    proc_deltas(NULL, p, &ctx);
+
+    uint64_t start_ns = p->starttime * (1000000000ull / (uint64_t)ctx.hz);
+    if (now_ns <= start_ns)
+      continue;
+    uint64_t age_ns = now_ns - start_ns;
+
+    if (p->has_schedstat)
+      p->cpu_percent = (double)p->run_ns / age_ns * 100;
+    else
+      p->cpu_percent = (double)(p->utime + p->stime) * (1e9 / ctx.hz) / age_ns * 100;
+  }
+}
+
+/**
+ * @brief Count births and deaths between two scans without computing
+ *        rates (the lists came from a collector that already did).
+ */
+void procs_lifecycle(proc_list_t *prev, proc_list_t *curr, lifecycle_t *lc) {
+  if (!prev || !curr || !lc)
+    return;
+
+  merge_procs(prev, curr, lc, NULL);
+}
+
+/**
+ * Helper function
+ *
+ * @brief Select the comparison function of a sort mode.
+ *
+ * @return The comparator, or NULL for an unknown mode.
+ */
+static proc_cmp_fn cmp_for_mode(sort_mode_t mode) {
+  switch (mode) {
+    case SORT_CPU: return cmp_proc_cpu_desc;
+    case SORT_MEM: return cmp_proc_rss_desc;
+    case SORT_PID: return cmp_proc_pid_desc;
+    default:       return NULL;
+  }
+}
+
+/**
+ * Helper function
+ *
+ * @brief Repair an almost sorted array in O(n + d log d).
+ *
+ * 1. Split: scan left to right keeping a sorted prefix; when an element
+ *    is smaller than the last kept one, move both of them out to buf.
+ *    At least one of the pair is misplaced, so at most twice the
+ *    minimum number of displaced elements (d) are moved out.
+ * 2. Sort the d displaced elements (few on almost-sorted input).
+ * 3. Merge them back from the end of the array, which needs no extra
+ *    space since the kept elements were compacted to the front.
+ *
+ * @param a   Array to sort (n elements).
+ * @param buf Scratch space for up to n elements.
+ * @param n   Number of elements.
+ * @param cmp Total order comparator.
+ */
+static void repair_sort(proc_info_t *a, proc_info_t *buf, size_t n, proc_cmp_fn cmp) {
+  size_t kept = 0, d = 0;
+
+  for (size_t i = 0; i < n; ++ i) {
+    if (kept == 0 || cmp(&a[kept - 1], &a[i]) <= 0) {
+      a[kept ++] = a[i];
+    } else {
+      buf[d ++] = a[-- kept];
+      buf[d ++] = a[i];
+    }
+  }
+
+  if (d == 0)
+    return;
+
+  // Too disordered to be worth repairing (e.g. the sort key changed)
+  if (d > n / 2) {
+    memcpy(&a[kept], buf, d * sizeof(proc_info_t));
+    qsort(a, n, sizeof(proc_info_t), cmp);
+    return;
+  }
+
+  qsort(buf, d, sizeof(proc_info_t), cmp);
+
+  // Backward merge of a[0, kept) and buf[0, d) into a[0, n)
+  size_t i = kept, j = d, k = n;
+  while (j > 0) {
+    if (i > 0 && cmp(&a[i - 1], &buf[j - 1]) > 0)
+      a[-- k] = a[-- i];
+    else
+      a[-- k] = buf[-- j];
+  }
+}
+
+/**
+ * Helper function
+ *
+ * @brief Grow the incremental sort buffers to the list capacity.
+ */
+static mytop_status_t ensure_sort_buffers(proc_list_t *list) {
+  if (list->sort_cap >= list->capacity)
+    return MYTOP_OK;
+
+  size_t cap = list->capacity;
+  size_t index_size = 1;
+  while (index_size < cap * 2) index_size <<= 1;
+
+  proc_info_t *buf = realloc(list->sort_buf, sizeof(proc_info_t) * cap);
+  if (!buf)
+    return MYTOP_ERR_NOMEM;
+  list->sort_buf = buf;
+
+  int32_t *index = realloc(list->sort_index, sizeof(int32_t) * index_size);
+  if (!index)
+    return MYTOP_ERR_NOMEM;
+  list->sort_index = index;
+
+  uint8_t *placed = realloc(list->sort_placed, cap);
+  if (!placed)
+    return MYTOP_ERR_NOMEM;
+  list->sort_placed = placed;
+
+  list->sort_cap = cap;
+  list->sort_index_mask = index_size - 1;
+
+  return MYTOP_OK;
+}
+
+/**
+ * @brief Sort the process list.
+ */
+void sort_procs_by_mode(proc_list_t *list, sort_mode_t mode) {
+  if (!list)
+    return;
+
+  proc_cmp_fn cmp = cmp_for_mode(mode);
+  if (cmp)
+    qsort(list->procs, list->count, sizeof(list->procs[0]), cmp);
+}
+
+/**
+ * @brief Sort the process list, starting from the previous frame's order.
+ *
+ * Between two ticks the order barely changes, so instead of a cold sort:
+ * 1. Lay out the records of curr in the order of prev (departed
+ *    processes simply drop out), appending new arrivals at the end.
+ * 2. Repair the result by pulling out the displaced records, sorting
+ *    only those and merging them back, which costs O(n + d log d) for
+ *    d displaced records (see repair_sort()).
+ *
+ * The comparators are total orders (ties broken by PID), so the result
+ * is identical to sort_procs_by_mode().
+ *
+ * @param prev Previous list, sorted in the previous frame (may be NULL).
+ * @param curr Current list to sort.
+ * @param mode Sort mode.
+ *
+ * @return mytop_status_t (curr is left cold-sorted if buffers cannot grow)
+ */
+mytop_status_t sort_procs_incremental(const proc_list_t *prev, proc_list_t *curr, sort_mode_t mode) {
+  // Check input parameters
+  if (!curr)
+    return MYTOP_ERR_PARAM;
+
+  proc_cmp_fn cmp = cmp_for_mode(mode);
+  if (!cmp)
+    return MYTOP_ERR_PARAM;
+
+  if (ensure_sort_buffers(curr) != MYTOP_OK) {
+    sort_procs_by_mode(curr, mode);
+    return MYTOP_ERR_NOMEM;
+  }
+
+  size_t n = curr->count;
+  if (n < 2)
+    return MYTOP_OK;
+
+  // 1. Carry the previous permutation forward
+  if (prev && prev->count > 0) {
+    size_t mask = curr->sort_index_mask;
+    memset(curr->sort_index, 0xff, sizeof(int32_t) * (mask + 1));
+    memset(curr->sort_placed, 0, n);
+
+    for (size_t i = 0; i < n; ++ i) {
+      size_t pos = (size_t)(curr->procs[i].pid * 11400714819323198485ull >> 32) & mask;
+      while (curr->sort_index[pos] != -1)
+        pos = (pos + 1) & mask;
+      curr->sort_index[pos] = (int32_t)i;
+    }
+
+    size_t k = 0;
+    for (size_t i = 0; i < prev->count; ++ i) {
+      uint64_t pid = prev->procs[i].pid;
+      size_t pos = (size_t)(pid * 11400714819323198485ull >> 32) & mask;
+      while (curr->sort_index[pos] != -1) {
+        int32_t j = curr->sort_index[pos];
+        if (curr->procs[j].pid == pid) {
+          if (!curr->sort_placed[j]) {
+            curr->sort_placed[j] = 1;
+            curr->sort_buf[k ++] = curr->procs[j];
+          }
+          break;
+        }
+        pos = (pos + 1) & mask;
+      }
+    }
+
+    // Arrivals keep their scan order (roughly ascending PID)
+    for (size_t j = 0; j < n; ++ j) {
+      if (!curr->sort_placed[j])
+        curr->sort_buf[k ++] = curr->procs[j];
+    }
+
+    proc_info_t *tmp = curr->procs;
+    curr->procs = curr->sort_buf;
+    curr->sort_buf = tmp;
+  }
+
+  // 2. Repair the carried-over order
+  repair_sort(curr->procs, curr->sort_buf, n, cmp);
+
+  return MYTOP_OK;
+}
+
+/**
+ * Helper function
+ *
+ * @brief Swap two process records.
+ */
+static inline void swap_procs(proc_info_t *a, proc_info_t *b) {
+  proc_info_t tmp = *a;
+  *a = *b;
+  *b = tmp;
+}
+
+/**
+ * Helper function
+ *
+ * @brief Quickselect: reorder a[0, n) so that a[k] holds the element of
+ *        rank k, with every smaller element before it and every larger
+ *        one after it, in expected O(n).
+ *
+ * @param cmp Total order comparator (no two records compare equal).
+ */
+static void nth_element(proc_info_t *a, size_t n, size_t k, proc_cmp_fn cmp) {
+  size_t lo = 0, hi = n;
+
+  while (hi - lo > 1) {
+    // Median of three, left in a[hi - 1] as the pivot
+    size_t mid = lo + (hi - lo) / 2;
+    if (cmp(&a[mid], &a[lo]) < 0)     swap_procs(&a[mid], &a[lo]);
+    if (cmp(&a[hi - 1], &a[lo]) < 0)  swap_procs(&a[hi - 1], &a[lo]);
+    if (cmp(&a[mid], &a[hi - 1]) < 0) swap_procs(&a[mid], &a[hi - 1]);
+
+    size_t store = lo;
+    for (size_t i = lo; i < hi - 1; ++ i) {
+      if (cmp(&a[i], &a[hi - 1]) < 0)
+        swap_procs(&a[i], &a[store ++]);
+    }
+    swap_procs(&a[store], &a[hi - 1]);
+
+    if (k == store)
+      return;
+    if (k < store)
+      hi = store;
+    else
+      lo = store + 1;
+  }
+}
+
+/**
+ * @brief Put the records of ranks [lo, hi) in place and in order,
+ *        leaving the rest of the list only partitioned around them.
+ *
+ * Costs O(n + w log w) for a window of w rows, instead of sorting the
+ * whole list when only one screen of it is shown.
+ *
+ * @param list Process list.
+ * @param mode Sort mode.
+ * @param lo   First rank of the window.
+ * @param hi   One past the last rank of the window (clamped to the count).
+ */
+mytop_status_t select_procs_window(proc_list_t *list, sort_mode_t mode, size_t lo, size_t hi) {
+  // Check input parameters
+  if (!list)
+    return MYTOP_ERR_PARAM;
+
+  proc_cmp_fn cmp = cmp_for_mode(mode);
+  if (!cmp)
+    return MYTOP_ERR_PARAM;
+
+  if (hi > list->count) hi = list->count;
+  if (lo >= hi)
+    return MYTOP_OK;
+
+  // 1. Everything before lo ranks lower, everything after it higher
+  nth_element(list->procs, list->count, lo, cmp);
+  // 2. Same for hi - 1 within the tail, which leaves ranks [lo, hi) in between
+  nth_element(list->procs + lo, list->count - lo, hi - 1 - lo, cmp);
+  // 3. Order the window itself
+  qsort(list->procs + lo, hi - lo, sizeof(proc_info_t), cmp);
+
+  return MYTOP_OK;
+}
+
+/**
+ * Helper function
+ *
+ * @brief Keep the cursor inside [0, count) and inside the window,
+ *        and keep the window filled at the end of the list.
+ */
+static void view_clamp(proc_view_t *view, size_t count, size_t visible) {
+  if (count == 0) {
+    view->cursor = view->offset = 0;
+    return;
+  }
+
+  if (view->cursor >= count) view->cursor = count - 1;
+  if (view->cursor < view->offset) view->offset = view->cursor;
+  if (visible > 0 && view->cursor >= view->offset + visible)
+    view->offset = view->cursor - visible + 1;
+  if (view->offset + visible > count)
+    view->offset = count > visible ? count - visible : 0;
+}
+
+/**
+ * @brief Re-locate the selected process after a full sort.
+ *
+ * The cursor follows its PID and stays on the same screen line when
+ * possible. If the process exited, the cursor keeps its row and
+ * selects whatever process is there now.
+ *
+ * @param view    Scroll state.
+ * @param list    Fully sorted process list.
+ * @param visible Rows in the window.
+ */
+void view_follow(proc_view_t *view, const proc_list_t *list, size_t visible) {
+  if (!view || !list)
+    return;
+
+  view->window_only = 0;
+
+  if (view->selected_pid != 0) {
+    for (size_t i = 0; i < list->count; ++ i) {
+      if (list->procs[i].pid == view->selected_pid) {
+        size_t line = view->cursor >= view->offset ? view->cursor - view->offset : 0;
+        view->cursor = i;
+        view->offset = i >= line ? i - line : 0;
+        break;
+      }
+    }
+  }
+
+  view_clamp(view, list->count, visible);
+  view->selected_pid = list->count ? list->procs[view->cursor].pid : 0;
+}
+
+/**
+ * @brief Move the cursor by delta rows (clamped to the list).
+ *
+ * On a fully sorted list this is O(1). After view_resort() only the
+ * window is ordered, so the new window is selected, which is still
+ * O(n) rather than a sort of the whole list.
+ *
+ * @param view    Scroll state.
+ * @param list    Process list on screen.
+ * @param mode    Sort mode of the list.
+ * @param delta   Rows to move (negative moves up).
+ * @param visible Rows in the window.
+ */
+void view_move(proc_view_t *view, proc_list_t *list, sort_mode_t mode, long delta, size_t visible) {
+  if (!view || !list || list->count == 0)
+    return;
+
+  if (delta < 0)
+    view->cursor = (size_t)(-delta) > view->cursor ? 0 : view->cursor - (size_t)(-delta);
+  else
+    view->cursor = (size_t)delta >= list->count - view->cursor ? list->count - 1 : view->cursor + (size_t)delta;
+
+  view_clamp(view, list->count, visible);
+  if (view->window_only)
+    select_procs_window(list, mode, view->offset, view->offset + visible);
+  view->selected_pid = list->procs[view->cursor].pid;
+}
+
+/**
+ * @brief Re-order the screen for a new sort mode between ticks.
+ *
+ * Only the window around the selected process is selected (see
+ * select_procs_window()); the next tick sorts the list in full.
+ *
+ * @param view    Scroll state.
+ * @param list    Process list on screen.
+ * @param mode    New sort mode.
+ * @param visible Rows in the window.
+ */
+void view_resort(proc_view_t *view, proc_list_t *list, sort_mode_t mode, size_t visible) {
+  if (!view || !list || list->count == 0)
+    return;
+
+  proc_cmp_fn cmp = cmp_for_mode(mode);
+  if (!cmp)
+    return;
+
+  // The rank of the selected process under the new order is its new row
+  const proc_info_t *sel = NULL;
+  for (size_t i = 0; i < list->count && !sel; ++ i) {
+    if (list->procs[i].pid == view->selected_pid)
+      sel = &list->procs[i];
+  }
+
+  if (sel) {
+    size_t rank = 0;
+    for (size_t i = 0; i < list->count; ++ i)
+      rank += cmp(&list->procs[i], sel) < 0;
+    size_t line = view->cursor >= view->offset ? view->cursor - view->offset : 0;
+    view->cursor = rank;
+    view->offset = rank >= line ? rank - line : 0;
+  }
+
+  view_clamp(view, list->count, visible);
+  select_procs_window(list, mode, view->offset, view->offset + visible);
+  view->window_only = 1;
+  view->selected_pid = list->procs[view->cursor].pid;
 }
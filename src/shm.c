@@ -0,0 +1,528 @@
+#include "log.h"
+#include "mytop.h"
+#include "mytop_types.h"
+#include "utils.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define SHM_MAGIC        0x504e53504f54594dull  // "MYTOPSNP"
+#define SHM_VERSION      5
+#define SHM_ALIGN        64
+#define SHM_INIT_STRINGS (64 * 1024)
+#define SHM_READ_RETRIES 64
+#define SHM_MODE_PRIVATE 0600  // Only the collector's user (and root) can read it
+#define SHM_MODE_SHARED  0644  // Any local user can read it
+
+// Segment header, followed by the record array and the string area
+typedef struct {
+  uint64_t magic;
+  uint32_t version;
+  uint32_t record_size;       // sizeof(shm_record_t), layout check
+  _Atomic uint64_t seq;       // Seqlock sequence, odd while being written
+  uint64_t size;              // Total segment size (bytes)
+  uint64_t capacity;          // Record slots
+  uint64_t str_offset;        // Start of the string area (from the segment base)
+  uint64_t str_capacity;      // Size of the string area (bytes)
+  uint64_t collector_pid;     // PID of the publishing collector
+  uint64_t heartbeat_ns;      // CLOCK_MONOTONIC time of the last publish
+  uint64_t interval_ms;       // Publishing interval
+  uint64_t tick;              // Snapshot number (0 = nothing published yet)
+
+  mem_info_t mem;             // Memory snapshot
+  double cpu_usage;           // Global CPU usage (0.0 - 100.0)
+  uint64_t count;             // Valid records
+} shm_header_t;
+
+// Process record; the cmd handle of info is only valid in the collector
+typedef struct {
+  proc_info_t info;
+  uint64_t cmd_off;           // Offset of the command in the string area
+  uint64_t cmd_len;           // Command length (without terminator)
+} shm_record_t;
+
+/**
+ * Helper function
+ *
+ * @brief Offset of the record array in the segment.
+ */
+static inline size_t records_offset(void) {
+  return (sizeof(shm_header_t) + SHM_ALIGN - 1) & ~(size_t)(SHM_ALIGN - 1);
+}
+
+/**
+ * Helper function
+ *
+ * @brief Check whether the collector behind a header is still alive.
+ *
+ * The collector is dead if its PID is gone or if it has not published
+ * for three intervals (plus one second of slack for slow scans).
+ */
+static bool collector_alive(const shm_header_t *h) {
+  pid_t pid = (pid_t)h->collector_pid;
+  if (pid <= 0 || (kill(pid, 0) == -1 && errno == ESRCH))
+    return false;
+
+  uint64_t now = monotonic_ns();
+  uint64_t budget_ns = (h->interval_ms * 3 + 1000) * 1000000ull;
+  if (h->heartbeat_ns != 0 && now > h->heartbeat_ns + budget_ns)
+    return false;
+
+  return true;
+}
+
+/**
+ * Helper function
+ *
+ * @brief Resize the segment (collector side) and remap it.
+ */
+static mytop_status_t resize_segment(shm_snapshot_t *shm, size_t size) {
+  if (ftruncate(shm->fd, (off_t)size) == -1) {
+    int err = errno;
+    LOG_ERROR("Shm", "Cannot resize %s to %zu bytes: %s", shm->name, size, strerror(err));
+    return MYTOP_ERR_IO;
+  }
+
+  void *base = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, shm->fd, 0);
+  if (base == MAP_FAILED)
+    return MYTOP_ERR_NOMEM;
+
+  munmap(shm->base, shm->map_size);
+  shm->base = base;
+  shm->map_size = size;
+
+  return MYTOP_OK;
+}
+
+/**
+ * Helper function
+ *
+ * @brief Remap the segment (viewer side) after the collector grew it.
+ */
+static mytop_status_t remap_segment(shm_snapshot_t *shm, size_t size) {
+  void *base = mmap(NULL, size, PROT_READ, MAP_SHARED, shm->fd, 0);
+  if (base == MAP_FAILED)
+    return MYTOP_ERR_IO;
+
+  munmap(shm->base, shm->map_size);
+  shm->base = base;
+  shm->map_size = size;
+
+  return MYTOP_OK;
+}
+
+/**
+ * Helper function
+ *
+ * @brief Grow the per-handle string offset tables of the collector.
+ */
+static mytop_status_t ensure_str_slots(shm_snapshot_t *shm, size_t slots) {
+  if (slots <= shm->str_slots)
+    return MYTOP_OK;
+
+  size_t new_slots = shm->str_slots ? shm->str_slots : STRTAB_CHUNK;
+  while (new_slots < slots) new_slots *= 2;
+
+  uint64_t *tick = realloc(shm->str_tick, sizeof(uint64_t) * new_slots);
+  if (!tick)
+    return MYTOP_ERR_NOMEM;
+  shm->str_tick = tick;
+  memset(shm->str_tick + shm->str_slots, 0, sizeof(uint64_t) * (new_slots - shm->str_slots));
+
+  uint64_t *off = realloc(shm->str_off, sizeof(uint64_t) * new_slots);
+  if (!off)
+    return MYTOP_ERR_NOMEM;
+  shm->str_off = off;
+
+  shm->str_slots = new_slots;
+
+  return MYTOP_OK;
+}
+
+/**
+ * Helper function
+ *
+ * @brief Whether a segment owner may feed this user's viewer: only the
+ *        user itself or root, since PIDs on screen become signal targets.
+ */
+static bool trusted_owner(uid_t uid) {
+  return uid == geteuid() || uid == 0;
+}
+
+/**
+ * Helper function
+ *
+ * @brief Remove a leftover segment, but only one this user created.
+ *
+ * @return MYTOP_OK if there is no segment left under name.
+ */
+static mytop_status_t unlink_own(const char *name) {
+  int fd = shm_open(name, O_RDONLY, 0);
+  if (fd == -1) {
+    if (errno == ENOENT)
+      return MYTOP_OK;
+    int err = errno;
+    LOG_ERROR("Shm", "Cannot inspect %s: %s", name, strerror(err));
+    return MYTOP_ERR;
+  }
+
+  struct stat st;
+  int ok = fstat(fd, &st) == 0;
+  close(fd);
+  if (!ok || st.st_uid != geteuid()) {
+    LOG_ERROR("Shm", "%s belongs to uid %u, not removing it", name, ok ? (unsigned)st.st_uid : 0u);
+    return MYTOP_ERR;
+  }
+
+  shm_unlink(name);
+  return MYTOP_OK;
+}
+
+/**
+ * @brief Create the snapshot segment as its collector.
+ *
+ * The segment is readable by its owner only, unless shared is set.
+ *
+ * @param shm         Segment handle to initialize.
+ * @param name        POSIX shm object name (e.g. "/mytop.1000").
+ * @param interval_ms Publishing interval, used by viewers to detect
+ *                    a dead collector.
+ * @param shared      Let other users' viewers read the segment.
+ *
+ * @return
+ *  - MYTOP_OK on success.
+ *  - MYTOP_ERR if another live collector, or another user, owns the segment.
+ *  - MYTOP_ERR_IO / MYTOP_ERR_NOMEM on failure.
+ */
+mytop_status_t shm_publisher_open(shm_snapshot_t *shm, const char *name, uint64_t interval_ms,
+                                  bool shared) {
+  // Check input parameters
+  if (!shm || !name)
+    return MYTOP_ERR_PARAM;
+
+  memset(shm, 0, sizeof(*shm));
+  shm->fd = -1;
+  snprintf(shm->name, sizeof(shm->name), "%s", name);
+
+  // Refuse to take over a segment whose collector is still running
+  shm_snapshot_t other;
+  if (shm_viewer_open(&other, name) == MYTOP_OK) {
+    shm_close(&other);
+    LOG_ERROR("Shm", "Another collector is already publishing to %s", name);
+    return MYTOP_ERR;
+  }
+
+  // Start from a fresh object: viewers still mapping a stale one keep
+  // it alive until they notice its dead collector and detach
+  if (unlink_own(name) != MYTOP_OK)
+    return MYTOP_ERR;
+  shm->fd = shm_open(name, O_CREAT | O_EXCL | O_RDWR, shared ? SHM_MODE_SHARED : SHM_MODE_PRIVATE);
+  if (shm->fd == -1) {
+    int err = errno;
+    LOG_ERROR("Shm", "Cannot create %s: %s", name, strerror(err));
+    return MYTOP_ERR_IO;
+  }
+  // From now on the object is ours, shm_close() removes it
+  shm->writer = 1;
+
+  size_t size = records_offset() + DEFAULT_CAPACITY * sizeof(shm_record_t) + SHM_INIT_STRINGS;
+  if (ftruncate(shm->fd, (off_t)size) == -1) {
+    shm_close(shm);
+    return MYTOP_ERR_IO;
+  }
+
+  shm->base = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, shm->fd, 0);
+  if (shm->base == MAP_FAILED) {
+    shm->base = NULL;
+    shm_close(shm);
+    return MYTOP_ERR_NOMEM;
+  }
+  shm->map_size = size;
+
+  shm_header_t *h = shm->base;
+  memset(h, 0, sizeof(*h));
+  h->version = SHM_VERSION;
+  h->record_size = sizeof(shm_record_t);
+  h->size = size;
+  h->collector_pid = (uint64_t)getpid();
+  h->interval_ms = interval_ms;
+  h->heartbeat_ns = monotonic_ns();
+
+  // Publish the magic last: viewers ignore the segment until then
+  atomic_thread_fence(memory_order_release);
+  h->magic = SHM_MAGIC;
+
+  return MYTOP_OK;
+}
+
+/**
+ * @brief Publish one snapshot under the seqlock.
+ *
+ * Distinct command strings are written once per snapshot. The segment
+ * only grows; viewers notice the new size in the header and remap.
+ *
+ * @param shm       Collector side segment.
+ * @param mem       Memory snapshot.
+ * @param cpu_usage Global CPU usage.
+ * @param list      Process list with CPU usage already calculated.
+ */
+mytop_status_t shm_publish(shm_snapshot_t *shm, const mem_info_t *mem,
+                           double cpu_usage, const proc_list_t *list) {
+  // Check input parameters
+  if (!shm || !shm->writer || !mem || !list)
+    return MYTOP_ERR_PARAM;
+
+  shm->publish_tick ++;
+
+  // 1. Lay out the string area, one copy per distinct handle
+  size_t str_bytes = 0;
+  for (size_t i = 0; i < list->count; ++ i) {
+    uint32_t handle = list->procs[i].cmd;
+    if (handle == 0)
+      continue;
+    if (ensure_str_slots(shm, handle) != MYTOP_OK)
+      return MYTOP_ERR_NOMEM;
+    if (shm->str_tick[handle - 1] == shm->publish_tick)
+      continue;
+    shm->str_tick[handle - 1] = shm->publish_tick;
+    shm->str_off[handle - 1] = str_bytes;
+    str_bytes += strtab_len(list->strtab, handle) + 1;
+  }
+
+  // 2. Grow the segment if needed (readers keep their old mapping valid)
+  size_t str_offset = records_offset() + list->count * sizeof(shm_record_t);
+  size_t needed = str_offset + str_bytes;
+  if (needed > shm->map_size) {
+    size_t size = shm->map_size;
+    while (size < needed) size *= 2;
+    mytop_status_t ret = resize_segment(shm, size);
+    if (ret != MYTOP_OK)
+      return ret;
+  }
+
+  shm_header_t *h = shm->base;
+  char *base = shm->base;
+  shm_record_t *records = (shm_record_t *)(base + records_offset());
+
+  // 3. Write section: the sequence is odd until everything is in place
+  uint64_t seq = atomic_load_explicit(&h->seq, memory_order_relaxed);
+  atomic_store_explicit(&h->seq, seq + 1, memory_order_relaxed);
+  atomic_thread_fence(memory_order_release);
+
+  h->size = shm->map_size;
+  h->capacity = (shm->map_size - records_offset()) / sizeof(shm_record_t);
+  h->str_offset = str_offset;
+  h->str_capacity = shm->map_size - str_offset;
+  h->mem = *mem;
+  h->cpu_usage = cpu_usage;
+  h->count = list->count;
+
+  for (size_t i = 0; i < list->count; ++ i) {
+    uint32_t handle = list->procs[i].cmd;
+    records[i].info = list->procs[i];
+    records[i].cmd_len = strtab_len(list->strtab, handle);
+    records[i].cmd_off = handle ? shm->str_off[handle - 1] : 0;
+
+    // First record using the string writes it
+    if (handle != 0 && shm->str_tick[handle - 1] == shm->publish_tick) {
+      memcpy(base + str_offset + records[i].cmd_off,
+             strtab_get(list->strtab, handle), records[i].cmd_len + 1);
+      shm->str_tick[handle - 1] = 0;
+    }
+  }
+
+  h->tick = shm->publish_tick;
+  h->heartbeat_ns = monotonic_ns();
+
+  atomic_store_explicit(&h->seq, seq + 2, memory_order_release);
+
+  return MYTOP_OK;
+}
+
+/**
+ * @brief Attach read-only to the snapshot segment of a running collector.
+ *
+ * @return
+ *  - MYTOP_OK if a live collector publishes to the segment.
+ *  - MYTOP_NO_FILE if there is no segment or its collector is dead.
+ *  - MYTOP_ERR if the segment belongs to another user (root excepted).
+ *  - MYTOP_ERR_PARSE if the segment layout is incompatible.
+ */
+mytop_status_t shm_viewer_open(shm_snapshot_t *shm, const char *name) {
+  // Check input parameters
+  if (!shm || !name)
+    return MYTOP_ERR_PARAM;
+
+  memset(shm, 0, sizeof(*shm));
+  shm->fd = -1;
+  snprintf(shm->name, sizeof(shm->name), "%s", name);
+
+  shm->fd = shm_open(name, O_RDONLY, 0);
+  if (shm->fd == -1)
+    return MYTOP_NO_FILE;
+
+  struct stat st;
+  if (fstat(shm->fd, &st) == -1 || (size_t)st.st_size < sizeof(shm_header_t)) {
+    shm_close(shm);
+    return MYTOP_NO_FILE;
+  }
+  if (!trusted_owner(st.st_uid)) {
+    LOG_WARN("Shm", "Ignoring %s: it belongs to uid %u", name, (unsigned)st.st_uid);
+    shm_close(shm);
+    return MYTOP_ERR;
+  }
+
+  shm->base = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_SHARED, shm->fd, 0);
+  if (shm->base == MAP_FAILED) {
+    shm->base = NULL;
+    shm_close(shm);
+    return MYTOP_ERR_IO;
+  }
+  shm->map_size = (size_t)st.st_size;
+
+  const shm_header_t *h = shm->base;
+  if (h->magic != SHM_MAGIC || h->version != SHM_VERSION ||
+      h->record_size != sizeof(shm_record_t)) {
+    shm_close(shm);
+    return MYTOP_ERR_PARSE;
+  }
+
+  if (!collector_alive(h)) {
+    shm_close(shm);
+    return MYTOP_NO_FILE;
+  }
+
+  return MYTOP_OK;
+}
+
+/**
+ * @brief Copy the latest snapshot out of the segment.
+ *
+ * The copy is retried until it was not overlapped by a write (seqlock).
+ * Command strings are interned into the string table of list.
+ *
+ * @param shm       Viewer side segment.
+ * @param mem       Memory snapshot. [out]
+ * @param cpu_usage Global CPU usage. [out]
+ * @param list      Process list, replaced by the snapshot. [out]
+ *
+ * @return
+ *  - MYTOP_OK when a new snapshot was copied.
+ *  - MYTOP_NO_DATA if nothing was published since the last call.
+ *  - MYTOP_NO_FILE if the collector died (fall back to local collection).
+ *  - MYTOP_ERR if no consistent copy could be taken.
+ */
+mytop_status_t shm_read(shm_snapshot_t *shm, mem_info_t *mem,
+                        double *cpu_usage, proc_list_t *list) {
+  // Check input parameters
+  if (!shm || !shm->base || !mem || !cpu_usage || !list)
+    return MYTOP_ERR_PARAM;
+
+  for (int attempt = 0; attempt < SHM_READ_RETRIES; ++ attempt) {
+    shm_header_t *h = shm->base;
+
+    uint64_t seq = atomic_load_explicit(&h->seq, memory_order_acquire);
+    if (seq & 1) {
+      sched_yield();
+      continue;
+    }
+
+    if (h->tick == shm->last_tick)
+      return collector_alive(h) ? MYTOP_NO_DATA : MYTOP_NO_FILE;
+
+    // The collector grew the segment
+    size_t size = h->size;
+    if (size > shm->map_size) {
+      if (remap_segment(shm, size) != MYTOP_OK)
+        return MYTOP_ERR_IO;
+      continue;
+    }
+
+    uint64_t tick = h->tick;
+    uint64_t count = h->count;
+    uint64_t str_offset = h->str_offset;
+    uint64_t str_capacity = h->str_capacity;
+    mem_info_t snap_mem = h->mem;
+    double snap_cpu = h->cpu_usage;
+
+    // Values may be torn by a concurrent write: bound everything
+    bool sane = str_offset >= records_offset() &&
+                str_offset <= shm->map_size &&
+                str_capacity <= shm->map_size - str_offset &&
+                count <= (str_offset - records_offset()) / sizeof(shm_record_t) &&
+                reserve_procs_list(list, count) == MYTOP_OK;
+
+    clear_procs_list(list);
+    const char *base = shm->base;
+    const shm_record_t *records = (const shm_record_t *)(base + records_offset());
+
+    for (uint64_t i = 0; sane && i < count; ++ i) {
+      proc_info_t info = records[i].info;
+      uint64_t off = records[i].cmd_off;
+      uint64_t len = records[i].cmd_len;
+      if (off > str_capacity || len >= str_capacity - off) {
+        sane = false;
+        break;
+      }
+
+      info.cmd = strtab_intern(list->strtab, base + str_offset + off, len);
+      if (info.cmd == 0) {
+        sane = false;
+        break;
+      }
+      list->procs[list->count ++] = info;
+    }
+
+    atomic_thread_fence(memory_order_acquire);
+    if (!sane || atomic_load_explicit(&h->seq, memory_order_relaxed) != seq) {
+      clear_procs_list(list);
+      continue;
+    }
+
+    *mem = snap_mem;
+    *cpu_usage = snap_cpu;
+    // The collector reads every file for whatever its viewers show
+    list->sources = SRC_SCAN;
+    list->stat_fields = STAT_MAX_FIELD;
+    shm->last_tick = tick;
+    return MYTOP_OK;
+  }
+
+  LOG_WARN("Shm", "No consistent snapshot after %d attempts", SHM_READ_RETRIES);
+  return MYTOP_ERR;
+}
+
+/**
+ * @brief Detach from the segment; the collector also removes it.
+ */
+void shm_close(shm_snapshot_t *shm) {
+  if (!shm)
+    return;
+
+  if (shm->base)
+    munmap(shm->base, shm->map_size);
+  if (shm->fd != -1)
+    close(shm->fd);
+  if (shm->writer)
+    shm_unlink(shm->name);
+
+  free(shm->str_tick);
+  free(shm->str_off);
+
+  shm->base = NULL;
+  shm->map_size = 0;
+  shm->fd = -1;
+  shm->str_tick = NULL;
+  shm->str_off = NULL;
+  shm->str_slots = 0;
+}
@@ -0,0 +1,269 @@
+#include "log.h"
+#include "mytop.h"
+#include "mytop_types.h"
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define STRTAB_INIT_INDEX 1024
+
+/**
+ * Helper function
+ *
+ * @brief FNV-1a hash of a byte string.
+ */
+static uint32_t hash_bytes(const char *s, size_t len) {
+  uint32_t h = 2166136261u;
+  for (size_t i = 0; i < len; ++ i) {
+    h ^= (unsigned char)s[i];
+    h *= 16777619u;
+  }
+  return h;
+}
+
+/**
+ * Helper function
+ *
+ * @brief Map a handle (slot + 1) to its entry.
+ */
+static inline str_entry_t *entry_of(const str_table_t *tab, uint32_t handle) {
+  uint32_t slot = handle - 1;
+  return &tab->chunks[slot / STRTAB_CHUNK][slot % STRTAB_CHUNK];
+}
+
+/**
+ * Helper function
+ *
+ * @brief Insert a handle into the index table (the handle must not be present).
+ */
+static void index_insert(uint32_t *index, size_t mask, uint32_t hash, uint32_t handle) {
+  size_t pos = hash & mask;
+  while (index[pos] != 0)
+    pos = (pos + 1) & mask;
+  index[pos] = handle;
+}
+
+/**
+ * Helper function
+ *
+ * @brief Double the index table once it is half full.
+ */
+static mytop_status_t grow_index(str_table_t *tab) {
+  size_t new_size = (tab->index_mask + 1) * 2;
+  uint32_t *index = calloc(new_size, sizeof(uint32_t));
+  if (!index)
+    return MYTOP_ERR_NOMEM;
+
+  for (size_t pos = 0; pos <= tab->index_mask; ++ pos) {
+    uint32_t handle = tab->index[pos];
+    if (handle != 0)
+      index_insert(index, new_size - 1, entry_of(tab, handle)->hash, handle);
+  }
+
+  free(tab->index);
+  tab->index = index;
+  tab->index_mask = new_size - 1;
+
+  return MYTOP_OK;
+}
+
+/**
+ * Helper function
+ *
+ * @brief Take a free slot, allocating a new chunk when needed.
+ *
+ * @return The new handle, or 0 if the table is full or out of memory.
+ */
+static uint32_t acquire_handle(str_table_t *tab) {
+  if (tab->free_head == 0) {
+    if (tab->nchunks == STRTAB_MAX_CHUNK)
+      return 0;
+
+    str_entry_t *chunk = calloc(STRTAB_CHUNK, sizeof(str_entry_t));
+    if (!chunk)
+      return 0;
+
+    // Chain the new slots into the free list, lowest first
+    uint32_t base = (uint32_t)(tab->nchunks * STRTAB_CHUNK);
+    for (uint32_t i = 0; i < STRTAB_CHUNK; ++ i)
+      chunk[i].next_free = (i + 1 < STRTAB_CHUNK) ? base + i + 2 : 0;
+
+    tab->chunks[tab->nchunks ++] = chunk;
+    tab->free_head = base + 1;
+  }
+
+  uint32_t handle = tab->free_head;
+  tab->free_head = entry_of(tab, handle)->next_free;
+
+  return handle;
+}
+
+/**
+ * @brief Create an empty string table.
+ */
+str_table_t *create_str_table(void) {
+  str_table_t *tab = calloc(1, sizeof(str_table_t));
+  if (!tab)
+    return NULL;
+
+  tab->index = calloc(STRTAB_INIT_INDEX, sizeof(uint32_t));
+  if (!tab->index) {
+    free(tab);
+    return NULL;
+  }
+  tab->index_mask = STRTAB_INIT_INDEX - 1;
+
+  return tab;
+}
+
+/**
+ * @brief Free the string table and every string it still holds.
+ */
+void free_str_table(str_table_t *tab) {
+  if (!tab)
+    return;
+
+  for (size_t c = 0; c < tab->nchunks; ++ c) {
+    for (size_t i = 0; i < STRTAB_CHUNK; ++ i)
+      free(tab->chunks[c][i].str);
+    free(tab->chunks[c]);
+  }
+
+  free(tab->index);
+  free(tab);
+}
+
+/**
+ * @brief Intern a string and take a reference to it.
+ *
+ * Identical strings share one copy; each call must be balanced by
+ * strtab_release() on the returned handle.
+ *
+ * @param tab String table.
+ * @param s   String bytes (need not be NUL-terminated).
+ * @param len Number of bytes in s.
+ *
+ * @return The handle of the string, or 0 on allocation failure.
+ */
+uint32_t strtab_intern(str_table_t *tab, const char *s, size_t len) {
+  // Check input parameters
+  if (!tab || !s || len >= UINT32_MAX)
+    return 0;
+
+  uint32_t hash = hash_bytes(s, len);
+
+  // 1. Already interned: bump the reference count
+  size_t pos = hash & tab->index_mask;
+  while (tab->index[pos] != 0) {
+    str_entry_t *e = entry_of(tab, tab->index[pos]);
+    if (e->hash == hash && e->len == len && memcmp(e->str, s, len) == 0) {
+      e->refs ++;
+      return tab->index[pos];
+    }
+    pos = (pos + 1) & tab->index_mask;
+  }
+
+  // 2. New string: keep the index at most half full
+  if ((tab->count + 1) * 2 > tab->index_mask + 1) {
+    if (grow_index(tab) != MYTOP_OK) {
+      LOG_ERROR("Strtab", "Cannot grow string index to %zu entries", (tab->index_mask + 1) * 2);
+      return 0;
+    }
+  }
+
+  char *copy = malloc(len + 1);
+  if (!copy)
+    return 0;
+  memcpy(copy, s, len);
+  copy[len] = '\0';
+
+  uint32_t handle = acquire_handle(tab);
+  if (handle == 0) {
+    free(copy);
+    return 0;
+  }
+
+  str_entry_t *e = entry_of(tab, handle);
+  e->str = copy;
+  e->len = (uint32_t)len;
+  e->hash = hash;
+  e->refs = 1;
+  e->next_free = 0;
+
+  index_insert(tab->index, tab->index_mask, hash, handle);
+  tab->count ++;
+  tab->bytes += len + 1;
+
+  return handle;
+}
+
+/**
+ * @brief Drop a reference, freeing the string with the last one.
+ */
+void strtab_release(str_table_t *tab, uint32_t handle) {
+  if (!tab || handle == 0)
+    return;
+
+  str_entry_t *e = entry_of(tab, handle);
+  if (-- e->refs > 0)
+    return;
+
+  // Locate the handle in the index
+  size_t mask = tab->index_mask;
+  size_t hole = e->hash & mask;
+  while (tab->index[hole] != handle)
+    hole = (hole + 1) & mask;
+
+  // Backward-shift deletion keeps probe chains intact without tombstones
+  size_t next = (hole + 1) & mask;
+  while (tab->index[next] != 0) {
+    size_t home = entry_of(tab, tab->index[next])->hash & mask;
+    if (((next - home) & mask) >= ((next - hole) & mask)) {
+      tab->index[hole] = tab->index[next];
+      hole = next;
+    }
+    next = (next + 1) & mask;
+  }
+  tab->index[hole] = 0;
+
+  tab->count --;
+  tab->bytes -= e->len + 1;
+
+  free(e->str);
+  e->str = NULL;
+  e->len = 0;
+  e->next_free = tab->free_head;
+  tab->free_head = handle;
+}
+
+/**
+ * @brief Take one more reference to an already interned string.
+ */
+void strtab_ref(str_table_t *tab, uint32_t handle) {
+  if (!tab || handle == 0)
+    return;
+
+  entry_of(tab, handle)->refs ++;
+}
+
+/**
+ * @brief Get the full string behind a handle.
+ *
+ * @return The NUL-terminated string ("" for handle 0).
+ */
+const char *strtab_get(const str_table_t *tab, uint32_t handle) {
+  if (!tab || handle == 0)
+    return "";
+
+  return entry_of(tab, handle)->str;
+}
+
+/**
+ * @brief Get the length of the string behind a handle.
+ */
+size_t strtab_len(const str_table_t *tab, uint32_t handle) {
+  if (!tab || handle == 0)
+    return 0;
+
+  return entry_of(tab, handle)->len;
+}
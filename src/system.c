@@ -1,6 +1,6 @@
 #include "mytop.h"
 #include "utils.h"
-#include <errno.h>
+#include <fcntl.h>
 #include <stddef.h>
 #include <stdint.h>
 #include <stdlib.h>
@@ -8,95 +8,115 @@
 #include <string.h>
 #include <sys/types.h>
 #include <sys/utsname.h>
+#include <unistd.h>
 
-enum {
-  F_MEMTOTAL     = 1u << 0,
-  F_MEMFREE      = 1u << 1,
-  F_MEMAVAILABLE = 1u << 2,
-  F_BUFFERS      = 1u << 3,
-  F_CACHED       = 1u << 4,
-};
-
-#define ALL_MEM_BITS (F_MEMTOTAL | F_MEMFREE | F_MEMAVAILABLE | F_BUFFERS | F_CACHED)
+#define FIELD(name, member) { name, sizeof(name) - 1, offsetof(mem_info_t, member) }
+#define MEMINFO_HASH_MUL 0x4305e98686292bb5ull
+#define MEMINFO_HASH_SIZE 256
 
 struct field {
-  char    *name;       // Field name
-  size_t   name_len;   // Field name length
-  size_t   offset;     // The offset of this field within mem_info_t
-  uint64_t bit;        // Bit flags (to avoid duplicate counting/repeated writes)
-} fields[] = {
-  {"MemTotal", sizeof("MemTotal") - 1, offsetof(mem_info_t, total), F_MEMTOTAL},
-  {"MemFree", sizeof("MemFree") - 1, offsetof(mem_info_t, free), F_MEMFREE},
-  {"MemAvailable", sizeof("MemAvailable") - 1, offsetof(mem_info_t, available), F_MEMAVAILABLE},
-  {"Buffers", sizeof("Buffers") - 1, offsetof(mem_info_t, buffers), F_BUFFERS},
-  {"Cached", sizeof("Cached") - 1, offsetof(mem_info_t, cached), F_CACHED},
+  const char *name;     // Field name
+  size_t      name_len; // Field name length
+  size_t      offset;   // The offset of this field within mem_info_t
+};
+
+// Perfect hash table of every /proc/meminfo field, indexed by meminfo_hash().
+// The multiplier was searched offline so that no two names collide; when
+// adding a field, pick a new multiplier and re-place every entry.
+static const struct field fields[MEMINFO_HASH_SIZE] = {
+  [  2] = FIELD("Shmem", shmem),
+  [ 10] = FIELD("Dirty", dirty),
+  [ 14] = FIELD("Committed_AS", committed_as),
+  [ 18] = FIELD("Bounce", bounce),
+  [ 25] = FIELD("WritebackTmp", writeback_tmp),
+  [ 34] = FIELD("Cached", cached),
+  [ 36] = FIELD("Active", active),
+  [ 40] = FIELD("HugePages_Rsvd", huge_pages_rsvd),
+  [ 50] = FIELD("KernelStack", kernel_stack),
+  [ 53] = FIELD("Zswapped", zswapped),
+  [ 57] = FIELD("HardwareCorrupted", hardware_corrupted),
+  [ 66] = FIELD("Zswap", zswap),
+  [ 71] = FIELD("Mlocked", mlocked),
+  [ 72] = FIELD("SUnreclaim", sunreclaim),
+  [ 73] = FIELD("Writeback", writeback),
+  [ 74] = FIELD("Inactive", inactive),
+  [ 77] = FIELD("MemFree", free),
+  [ 79] = FIELD("Hugetlb", hugetlb),
+  [ 80] = FIELD("MemAvailable", available),
+  [ 87] = FIELD("MemTotal", total),
+  [ 89] = FIELD("SecPageTables", sec_page_tables),
+  [102] = FIELD("SwapFree", swap_free),
+  [103] = FIELD("Active(file)", active_file),
+  [109] = FIELD("SwapCached", swap_cached),
+  [112] = FIELD("SwapTotal", swap_total),
+  [125] = FIELD("DirectMap4k", direct_map_4k),
+  [135] = FIELD("ShmemPmdMapped", shmem_pmd_mapped),
+  [137] = FIELD("AnonPages", anon_pages),
+  [140] = FIELD("Inactive(file)", inactive_file),
+  [147] = FIELD("NFS_Unstable", nfs_unstable),
+  [148] = FIELD("Slab", slab),
+  [153] = FIELD("FilePmdMapped", file_pmd_mapped),
+  [155] = FIELD("Buffers", buffers),
+  [156] = FIELD("Active(anon)", active_anon),
+  [162] = FIELD("VmallocChunk", vmalloc_chunk),
+  [163] = FIELD("AnonHugePages", anon_huge_pages),
+  [172] = FIELD("HugePages_Free", huge_pages_free),
+  [175] = FIELD("CmaFree", cma_free),
+  [182] = FIELD("HugePages_Total", huge_pages_total),
+  [185] = FIELD("CmaTotal", cma_total),
+  [189] = FIELD("VmallocUsed", vmalloc_used),
+  [192] = FIELD("Balloon", balloon),
+  [193] = FIELD("Mapped", mapped),
+  [194] = FIELD("Inactive(anon)", inactive_anon),
+  [199] = FIELD("Hugepagesize", huge_page_size),
+  [200] = FIELD("CommitLimit", commit_limit),
+  [201] = FIELD("HugePages_Surp", huge_pages_surp),
+  [202] = FIELD("KReclaimable", kreclaimable),
+  [203] = FIELD("DirectMap4M", direct_map_4m),
+  [204] = FIELD("VmallocTotal", vmalloc_total),
+  [224] = FIELD("ShmemHugePages", shmem_huge_pages),
+  [226] = FIELD("Unevictable", unevictable),
+  [227] = FIELD("SReclaimable", sreclaimable),
+  [235] = FIELD("DirectMap1G", direct_map_1g),
+  [242] = FIELD("FileHugePages", file_huge_pages),
+  [243] = FIELD("Unaccepted", unaccepted),
+  [247] = FIELD("Percpu", percpu),
+  [248] = FIELD("DirectMap2M", direct_map_2m),
+  [253] = FIELD("PageTables", page_tables),
 };
 
 /**
- * @brief Extract memory information from a line of /proc/meminfo.
- *
- * Parses a line from /proc/meminfo in the format "FieldName: 123456 kB"
- * and extracts the value if the field is in the target list.
+ * Helper function
  *
- * @param mem        Pointer to memory info structure to store results.
- * @param buffer     Null-terminated input line from /proc/meminfo.
- * @param fields     Array of field names to extract.
- * @param parsed_cnt Pointer to counter for successfully parsed fields.
+ * @brief Hash a meminfo field name into fields[].
  *
- * @return
- *   - MYTOP_OK          Field parsed successfully or not in target list.
- *   - MYTOP_ERR_PARSE   Failed to parse numeric value.
- *   - MYTOP_ERR         Numeric overflow or other error.
+ * The first, last and second to last characters plus the length
+ * identify every known name, so no loop over the name is needed.
  */
-static mytop_status_t extract_field_info(mem_info_t *mem, char *line, 
-                                         const struct field *fields, 
-                                         size_t fields_len, uint32_t *mask) {
-  // e.g.
-  // "MemTotal: 15716420 kB\n"
+static inline size_t meminfo_hash(const char *name, size_t len) {
+  uint64_t key = (uint64_t)(unsigned char)name[0] |
+                 (uint64_t)(unsigned char)name[len - 1] << 8 |
+                 (uint64_t)(unsigned char)name[len - 2] << 16 |
+                 (uint64_t)len << 24;
+  return (size_t)((key * MEMINFO_HASH_MUL) >> 56);
+}
 
-  // Check input parameters
-  if (!mem || !line || !fields || !mask)
-    return MYTOP_ERR_PARAM;
+/**
+ * Helper function
+ *
+ * @brief Resolve a meminfo field name with one hash and one memcmp.
+ *
+ * @return The field, or NULL for names this build does not know.
+ */
+static inline const struct field *lookup_field(const char *name, size_t len) {
+  if (len < 2)
+    return NULL;
 
-  char *p = line;
-  // Skip spaces
-  for (; *p != '\0' && *p == ' '; ++ p);
-  // Locate the field string
-  char *colon = strchr(line, ':');
-  if (!colon)
-    return MYTOP_OK;
-
-  char *key_start = p;
-  char *key_end = colon;
-  size_t key_len = key_end - key_start;
-
-  for (size_t i = 0; i < fields_len; ++ i) {
-    if (key_len == fields[i].name_len && memcmp(key_start, fields[i].name, key_len) == 0) {
-      // Parse value field
-      // Skip spaces
-      p = colon + 1;
-      for (; *p != '\0' && *p == ' '; ++ p);
-      // Value string translate to number
-      errno = 0;
-      char *end;
-      uint64_t value = strtoul(p, &end, 10);
-      if (p == end) 
-        return MYTOP_ERR_PARSE;
-      else if (errno == ERANGE)
-        return MYTOP_ERR;
-
-      if (!((*mask) & fields[i].bit)) {
-        (*mask) |= fields[i].bit;
-        
-        uint64_t *dst = (uint64_t *)((char *)mem + fields[i].offset);
-        *dst = value;
-
-        break;
-      }
-    }
-  }
+  const struct field *f = &fields[meminfo_hash(name, len)];
+  if (f->name_len != len || memcmp(f->name, name, len) != 0)
+    return NULL;
 
-  return MYTOP_OK;
+  return f;
 }
 
 /**
@@ -126,68 +146,77 @@ mytop_status_t parse_version(sys_info_t *sys) {
   return MYTOP_OK;
 }
 
+/**
+ * @brief Open /proc/meminfo once; parse_meminfo() re-reads it with pread().
+ *
+ * @return The file descriptor, or -1 on failure.
+ */
+int meminfo_open(void) {
+  return open("/proc/meminfo", O_RDONLY | O_CLOEXEC);
+}
+
 /**
  * @brief Parse memory information
  *
- * Reads the /proc/meminfo file, parses fields such as Total, Free, Buffers,
- * Cached, and automatically calculates the used and used_percent fields.
+ * Reads /proc/meminfo with a single pread() into a fixed buffer, stores
+ * every known "Name: value" field, and derives used/buff_cache/available
+ * with the same formulas as free(1).
  *
- * @param  mem Pointer to the mem_info_t structure for storing the result.
+ * @param fd  Descriptor returned by meminfo_open().
+ * @param mem Pointer to the mem_info_t structure for storing the result.
  *
  * @return mytop_status_t Returns a status code.
  */
-mytop_status_t parse_meminfo(mem_info_t *mem) {
+mytop_status_t parse_meminfo(int fd, mem_info_t *mem) {
   // Check input parameters
-  if (!mem)
+  if (fd < 0 || !mem)
     return MYTOP_ERR_PARAM;
 
-  FILE *fp = fopen("/proc/meminfo", "r");
-  if (!fp)
+  char buf[MEMINFO_BUF_SIZE];
+  ssize_t n = pread(fd, buf, sizeof(buf), 0);
+  if (n <= 0)
     return MYTOP_ERR_IO;
 
-  uint32_t mask = 0;
-  size_t fields_len = sizeof(fields) / sizeof(fields[0]);
-  char line[BUFFER_SIZE];
-  while (fgets(line, sizeof line, fp)) {
-    mytop_status_t ret = extract_field_info(mem, line, fields,fields_len,  &mask);
-    if (ret != MYTOP_OK) {
-      fclose(fp);
-      return ret;
-    }
+  memset(mem, 0, sizeof(*mem));
+  bool has_available = false;
 
-    if ((mask & ALL_MEM_BITS) == ALL_MEM_BITS) {
-      fclose(fp);
-      break;
+  const char *p = buf, *end = buf + n;
+  while (p < end) {
+    // e.g. "MemTotal:       15716420 kB\n"
+    const char *eol = memchr(p, '\n', (size_t)(end - p));
+    if (!eol) eol = end;
+
+    const char *colon = memchr(p, ':', (size_t)(eol - p));
+    const struct field *f = colon ? lookup_field(p, (size_t)(colon - p)) : NULL;
+    if (f) {
+      const char *q = colon + 1;
+      for (; q < eol && *q == ' '; ++ q);
+
+      uint64_t value = 0;
+      for (; q < eol && *q >= '0' && *q <= '9'; ++ q)
+        value = value * 10 + (uint64_t)(*q - '0');
+
+      *(uint64_t *)((char *)mem + f->offset) = value;
+      if (f->offset == offsetof(mem_info_t, available))
+        has_available = true;
     }
+
+    p = eol + 1;
   }
 
-  // For backward compatibility, choose the classic calculation formula
-  mem->used = mem->total - mem->free - mem->buffers - mem->cached;
+  if (mem->total == 0)
+    return MYTOP_ERR_PARSE;
+
+  // free(1): buff/cache includes reclaimable slab, used is what is not available
+  mem->buff_cache = mem->buffers + mem->cached + mem->sreclaimable;
+  if (!has_available) {
+    // Kernels before 3.14 have no MemAvailable
+    uint64_t reclaimable = mem->free + mem->buff_cache;
+    mem->available = reclaimable < mem->total ? reclaimable : mem->total;
+  }
+  mem->used = mem->total > mem->available ? mem->total - mem->available : 0;
+  mem->swap_used = mem->swap_total > mem->swap_free ? mem->swap_total - mem->swap_free : 0;
   mem->used_percent = ((double)mem->used / mem->total) * 100;
 
   return MYTOP_OK;
 }
-
-/**
- * @brief Print system snapshot to terminal.
- *
- * Formatted output of system version, machine architecture and memory usage.
- * Kernel : [version]
- * Machine: [Arch]
- * Memory : [Used] MB / [Total] MB ([Percent]%)
- *
- * @param sys Pointer to the populated system information structure.
- * @param mem Pointer to the populated memory information structure
- */
-void print_system_snapshot(const sys_info_t *sys, const mem_info_t *mem) {
-  // Check input parameters 
-  if (!sys || !mem)
-    return;
-
-  printf("Kernel : %s\n", sys->release);
-  printf("Machine: %s\n", sys->machine);
-  printf("Memory : %.2lf GB / %.2lf GB (%.2lf%%)\n",
-         mem_uint_convert(mem->used, MEM_KIB, MEM_GIB),
-         mem_uint_convert(mem->total, MEM_KIB, MEM_GIB),
-         mem->used_percent);
-}
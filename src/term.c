@@ -0,0 +1,181 @@
+#include "utils.h"
+#include <ctype.h>
+#include <errno.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <sys/ioctl.h>
+#include <poll.h>
+#include <termios.h>
+#include <unistd.h>
+
+/**
+ * @brief Get the current terminal column width and row.
+ */
+void get_term_size(int *rows, int *cols) {
+  struct winsize ws;
+  if (ioctl(STDOUT_FILENO, TIOCGWINSZ, &ws) == 0) {
+    if (rows) *rows = ws.ws_row;
+    if (cols) *cols = ws.ws_col;
+  } else {
+    // Default value
+    if (rows) *rows = 24;
+    if (cols) *cols = 80;
+  }
+}
+
+/**
+ * @brief Enable/disable raw mode (Raw Mode)
+ *  - enable=true: Disable enter confirmation and echo (immediate key response)
+ *  - enable=false: Restore normal mode
+ */
+static struct termios orig_termios;
+int set_raw_mode(bool enable) {
+  if (enable) {
+    // 1. Get current attributes
+    if (tcgetattr(STDIN_FILENO, &orig_termios) == -1) return -1;
+
+    struct termios raw = orig_termios;
+
+    // 2. Modify attributes
+    // ICANON: Turn off canonical mode (no need for Enter)
+    // ECHO: Turn off echo (do not display input characters) 
+    raw.c_lflag &= ~(ICANON | ECHO);
+
+    // VMIN=0, VTIME=0: Read returns immediately, does not block
+    raw.c_cc[VMIN] = 0;
+    raw.c_cc[VTIME] = 0;
+
+    // 3. Set new attributes
+    if (tcsetattr(STDIN_FILENO, TCSAFLUSH, &raw) == -1) return -1;
+  } else {
+    // Restore original attributes
+    if (tcsetattr(STDIN_FILENO, TCSAFLUSH, &orig_termios) == -1) return -1;
+  }
+
+  return 0;
+}
+
+// Check for key input (non-blocking)
+bool kbhit() {
+  struct pollfd pfd = { .fd = STDIN_FILENO, .events = POLLIN };
+
+  // Interrupted by a signal or no input available
+  return poll(&pfd, 1, 0) > 0 && (pfd.revents & POLLIN);
+}
+
+/**
+ * @brief Read one line of input in Raw Mode (blocking)
+ * @param buf Output buffer
+ * @param maxlen Maximum buffer length
+ * @return int Number of characters read
+ */
+int term_read_line(char *buf, size_t maxlen) {
+  size_t len = 0;
+  char c;
+
+  while (1) {
+    // Blocking read of 1 character
+    if (read(STDIN_FILENO, &c, 1) != 1) break;
+
+    // Enter key
+    if (c == '\n' || c == '\r') {
+      break;
+    }
+    // Backspace key
+    else if (c == 27 || c == '\b') {
+      if (len > 0) {
+        len --;
+        // Visual erasure: Move cursor back, print space to overwrite, 
+        // then move cursor back again
+        printf("\b \b"); 
+        fflush(stdout);
+      }
+    }
+    // Regular characters
+    else if (len < maxlen - 1) {
+      if (!iscntrl(c)) {
+        buf[len ++] = c;
+        printf("%c", c);
+        fflush(stdout);
+      }
+    }
+  }
+
+  buf[len] = '\0';
+  return len;
+}
+
+/**
+ * @brief Feed one key to a line being edited without blocking the caller.
+ *
+ * @param buf    Line buffer (kept NUL-terminated).
+ * @param len    Current length of the line. [in/out]
+ * @param maxlen Size of buf.
+ * @param c      Key read from the terminal.
+ *
+ * @return 1 when Enter finishes the line, -1 when Esc cancels it, 0 otherwise.
+ */
+int term_edit_line(char *buf, size_t *len, size_t maxlen, int c) {
+  if (c == '\n' || c == '\r')
+    return 1;
+  if (c == 27)
+    return -1;
+
+  if (c == 127 || c == '\b') {
+    if (*len > 0) (*len) --;
+  } else if (c > 0 && c < 256 && !iscntrl(c) && *len < maxlen - 1) {
+    buf[(*len) ++] = (char)c;
+  }
+  buf[*len] = '\0';
+
+  return 0;
+}
+
+/**
+ * @brief Clear screen.
+ */
+void term_clear_screen() {
+  printf("\033[2J");
+}
+
+/**
+ * @brief Clear line.
+ */
+void term_clear_line() {
+  printf("\033[K");
+}
+
+/**
+ * @brief Move cursor.
+ */
+void term_move_cursor(int row, int col) {
+  printf("\033[%d;%dH", row, col);
+}
+
+/**
+ * @brief Cursor home.
+ */
+void term_home() {
+  printf("\033[H");
+}
+
+/**
+ * @brief Hide cursor.
+ */
+void term_hide_cursor() {
+  printf("\033[?25l");
+}
+
+/**
+ * @brief Show cursor.
+ */
+void term_show_cursor() {
+  printf("\033[?25h");
+}
+
+/**
+ * @brief Flush the buffer.
+ */
+void term_refresh() {
+  fflush(stdout);
+}
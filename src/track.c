@@ -0,0 +1,639 @@
+#include "log.h"
+#include "mytop.h"
+#include "mytop_types.h"
+#include "utils.h"
+#include <errno.h>
+#include <signal.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+// Not wrapped by older C libraries (Linux 5.3 / 5.1)
+#ifndef SYS_pidfd_open
+#define SYS_pidfd_open 434
+#endif
+#ifndef SYS_pidfd_send_signal
+#define SYS_pidfd_send_signal 424
+#endif
+
+#define PIDFD_FD_RESERVE 64   // Descriptors left for /proc reads, PSI, the terminal
+#define PIDFD_OPEN_BUDGET 256 // pidfd_open() calls per frame, after it is drawn
+
+// Block elements used for sparklines, from lowest to highest (UTF-8)
+static const char *const spark_blocks[] = {
+  "▁", "▂", "▃", "▄",
+  "▅", "▆", "▇", "█"
+};
+
+#define SPARK_LEVELS (sizeof(spark_blocks) / sizeof(spark_blocks[0]))
+
+/**
+ * Helper function
+ *
+ * @brief Hash a PID into the index table (Fibonacci hashing).
+ */
+static inline size_t hash_pid(uint64_t pid, size_t mask) {
+  return (size_t)((pid * 11400714819323198485ull) >> 32) & mask;
+}
+
+/**
+ * Helper function
+ *
+ * @brief Find the index table position holding pid.
+ *
+ * @return The position in track->index, or -1 if pid is not tracked.
+ */
+static long find_index_pos(const proc_track_t *track, uint64_t pid) {
+  size_t pos = hash_pid(pid, track->index_mask);
+
+  // Linear probing, the table is never full (at least 2x max_entries)
+  while (track->index[pos] != -1) {
+    if (track->slab[track->index[pos]].pid == pid)
+      return (long)pos;
+    pos = (pos + 1) & track->index_mask;
+  }
+
+  return -1;
+}
+
+/**
+ * Helper function
+ *
+ * @brief Remove the entry at index position pos, shifting back
+ *        the following probe chain so no tombstones are needed.
+ */
+static void remove_index_pos(proc_track_t *track, size_t pos) {
+  size_t mask = track->index_mask;
+  size_t hole = pos;
+  size_t next = (pos + 1) & mask;
+
+  while (track->index[next] != -1) {
+    size_t home = hash_pid(track->slab[track->index[next]].pid, mask);
+    // Move the entry back if its home is not in (hole, next]
+    if (((next - home) & mask) >= ((next - hole) & mask)) {
+      track->index[hole] = track->index[next];
+      hole = next;
+    }
+    next = (next + 1) & mask;
+  }
+
+  track->index[hole] = -1;
+}
+
+/**
+ * Helper function
+ *
+ * @brief Open a pidfd on exactly the process that was scanned.
+ *
+ * The PID may have been reused between the scan and pidfd_open(), so
+ * the start time is read again after the pidfd exists: if it still
+ * matches, the pidfd refers to exactly the process that was scanned.
+ *
+ * @return The pidfd, or -1 with errno set (ESRCH if the process is gone
+ * or its PID was reused).
+ */
+static long pidfd_open_checked(uint64_t pid, uint64_t starttime) {
+  long fd = syscall(SYS_pidfd_open, (pid_t)pid, 0);
+  if (fd == -1)
+    return -1;
+
+  uint64_t now_start;
+  if (read_proc_starttime(pid, &now_start) != MYTOP_OK || now_start != starttime) {
+    close((int)fd);
+    errno = ESRCH;
+    return -1;
+  }
+
+  return fd;
+}
+
+/**
+ * Helper function
+ *
+ * @brief Open the pidfd kept for a process seen in the current scan.
+ *
+ * @return The pidfd, or -1 if none could be obtained.
+ */
+static int32_t open_pidfd(proc_track_t *track, uint64_t pid, uint64_t starttime) {
+  if (track->pidfd_count >= track->pidfd_max)
+    return -1;
+
+  long fd = pidfd_open_checked(pid, starttime);
+  if (fd == -1) {
+    // No kernel support (or filtered by seccomp): stop trying
+    if (errno == ENOSYS || errno == EPERM) {
+      LOG_INFO("Track", "pidfd_open unavailable, signals fall back to kill()");
+      track->pidfd_max = 0;
+    }
+    return -1;
+  }
+
+  track->pidfd_count ++;
+  return (int32_t)fd;
+}
+
+/**
+ * Helper function
+ *
+ * @brief Close the pidfd held by a slot, if any.
+ */
+static void close_pidfd(proc_track_t *track, track_entry_t *e) {
+  if (e->pidfd == -1)
+    return;
+
+  close(e->pidfd);
+  e->pidfd = -1;
+  track->pidfd_count --;
+}
+
+/**
+ * Helper function
+ *
+ * @brief Return a slab slot to the free list.
+ */
+static void release_slot(proc_track_t *track, int32_t slot) {
+  track_entry_t *e = &track->slab[slot];
+  close_pidfd(track, e);
+  e->in_use = 0;
+  e->next_free = track->free_head;
+  track->free_head = slot;
+  track->used --;
+}
+
+/**
+ * Helper function
+ *
+ * @brief Take a slot from the free list and bind it to a process.
+ *
+ * @return The slot number, or -1 if the pool is exhausted.
+ */
+static int32_t acquire_slot(proc_track_t *track, const proc_info_t *p) {
+  int32_t slot = track->free_head;
+  if (slot == -1)
+    return -1;
+
+  track_entry_t *e = &track->slab[slot];
+  track->free_head = e->next_free;
+  track->used ++;
+
+  e->pid = p->pid;
+  e->starttime = p->starttime;
+  e->head = 0;
+  e->len = 0;
+  e->smaps_tick = 0;
+  e->smaps_valid = 0;
+  e->csw_ns = 0;
+  e->csw_valid = 0;
+  e->in_use = 1;
+  e->next_free = -1;
+  e->pidfd = -1;
+
+  size_t pos = hash_pid(p->pid, track->index_mask);
+  while (track->index[pos] != -1)
+    pos = (pos + 1) & track->index_mask;
+  track->index[pos] = slot;
+
+  return slot;
+}
+
+/**
+ * @brief Create a per-process tracking table.
+ *
+ * All memory is allocated here: a slab of max_pids history slots and
+ * an index table of at least twice that size, so track_update() never
+ * allocates and memory stays bounded by max_pids * HISTORY_LEN.
+ *
+ * Each tracked process also holds a pidfd so signals reach exactly the
+ * process that was displayed. The soft RLIMIT_NOFILE is raised towards
+ * max_pids for that; past it, processes are tracked without a pidfd.
+ *
+ * @param max_pids Maximum number of processes tracked at once
+ *                 (0 selects MAX_TRACKED_PIDS).
+ */
+proc_track_t *create_proc_track(size_t max_pids) {
+  size_t max_entries = max_pids == 0 ?
+                       MAX_TRACKED_PIDS :
+                       max_pids;
+
+  size_t index_size = 1;
+  while (index_size < max_entries * 2) index_size <<= 1;
+
+  proc_track_t *track = malloc(sizeof(proc_track_t));
+  if (!track)
+    return NULL;
+
+  track->slab = calloc(max_entries, sizeof(track_entry_t));
+  track->index = malloc(sizeof(int32_t) * index_size);
+  if (!track->slab || !track->index) {
+    LOG_ERROR("Track", "Cannot allocate history for %zu processes", max_entries);
+    free(track->slab);
+    free(track->index);
+    free(track);
+    return NULL;
+  }
+
+  memset(track->index, 0xff, sizeof(int32_t) * index_size);
+  track->index_mask = index_size - 1;
+  track->max_entries = max_entries;
+  track->used = 0;
+  track->tick = 0;
+
+  // Chain every slot into the free list
+  for (size_t i = 0; i < max_entries; ++ i) {
+    track->slab[i].next_free = (i + 1 < max_entries) ? (int32_t)(i + 1) : -1;
+    track->slab[i].pidfd = -1;
+  }
+  track->free_head = 0;
+
+  // Room for one pidfd per slot, keeping a reserve for everything else.
+  // Every event loop waits with poll(), so descriptors may exceed FD_SETSIZE
+  struct rlimit rl;
+  track->pidfd_count = 0;
+  track->pidfd_max = 0;
+  if (getrlimit(RLIMIT_NOFILE, &rl) == 0) {
+    rlim_t want = (rlim_t)(max_entries + PIDFD_FD_RESERVE);
+    if (rl.rlim_cur != RLIM_INFINITY && rl.rlim_cur < want) {
+      rl.rlim_cur = (rl.rlim_max == RLIM_INFINITY || rl.rlim_max > want) ? want : rl.rlim_max;
+      setrlimit(RLIMIT_NOFILE, &rl);
+      getrlimit(RLIMIT_NOFILE, &rl);
+    }
+    if (rl.rlim_cur == RLIM_INFINITY || rl.rlim_cur >= want)
+      track->pidfd_max = max_entries;
+    else if (rl.rlim_cur > 2 * PIDFD_FD_RESERVE)
+      track->pidfd_max = (size_t)rl.rlim_cur - 2 * PIDFD_FD_RESERVE;
+  }
+
+  return track;
+}
+
+/**
+ * @brief Free memory occupied by the tracking table.
+ */
+void free_proc_track(proc_track_t *track) {
+  if (!track)
+    return;
+
+  for (size_t slot = 0; slot < track->max_entries; ++ slot) {
+    if (track->slab[slot].in_use)
+      close_pidfd(track, &track->slab[slot]);
+  }
+
+  free(track->slab);
+  free(track->index);
+  free(track);
+}
+
+/**
+ * @brief Append the current sample of every process to its history.
+ *
+ * 1. Look up (or bind) the slot of each process by PID.
+ * 2. Restart the history (and close the pidfd) if the PID was reused.
+ * 3. Recycle slots of processes that did not appear in this sample.
+ *
+ * No pidfd is opened here, see track_open_pidfds().
+ *
+ * Processes beyond the max_pids bound are simply not tracked.
+ *
+ * @param track Tracking table.
+ * @param list  Current process list (CPU usage already calculated).
+ */
+void track_update(proc_track_t *track, const proc_list_t *list) {
+  if (!track || !list)
+    return;
+
+  track->tick ++;
+
+  for (size_t i = 0; i < list->count; ++ i) {
+    const proc_info_t *p = &list->procs[i];
+
+    int32_t slot;
+    long pos = find_index_pos(track, p->pid);
+    if (pos != -1) {
+      slot = track->index[pos];
+      // PID reused: restart history
+      if (track->slab[slot].starttime != p->starttime) {
+        close_pidfd(track, &track->slab[slot]);
+        track->slab[slot].starttime = p->starttime;
+        track->slab[slot].head = 0;
+        track->slab[slot].len = 0;
+        track->slab[slot].smaps_tick = 0;
+        track->slab[slot].smaps_valid = 0;
+        track->slab[slot].csw_ns = 0;
+        track->slab[slot].csw_valid = 0;
+      }
+    } else {
+      slot = acquire_slot(track, p);
+      if (slot == -1)
+        continue;
+    }
+
+    track_entry_t *e = &track->slab[slot];
+    e->cpu[e->head] = (float)p->cpu_percent;
+    e->rss[e->head] = p->rss;
+    e->head = (e->head + 1) % HISTORY_LEN;
+    if (e->len < HISTORY_LEN) e->len ++;
+    e->seen_tick = track->tick;
+  }
+
+  // Recycle slots of exited processes
+  for (size_t slot = 0; slot < track->max_entries; ++ slot) {
+    track_entry_t *e = &track->slab[slot];
+    if (!e->in_use || e->seen_tick == track->tick)
+      continue;
+
+    long pos = find_index_pos(track, e->pid);
+    if (pos != -1)
+      remove_index_pos(track, (size_t)pos);
+    release_slot(track, (int32_t)slot);
+  }
+}
+
+/**
+ * @brief Pin the tracked processes of a sample with pidfds.
+ *
+ * Called once the frame is on screen, in the list's order so the rows
+ * shown are pinned first. At most PIDFD_OPEN_BUDGET pidfds are opened
+ * per call, so the first frame of a busy host never waits for them; the
+ * rest are opened after the following frames, and track_signal() opens
+ * a temporary pidfd for them meanwhile.
+ *
+ * @param track Tracking table (track_update() already saw list).
+ * @param list  Current process list.
+ */
+void track_open_pidfds(proc_track_t *track, const proc_list_t *list) {
+  if (!track || !list)
+    return;
+
+  size_t budget = PIDFD_OPEN_BUDGET;
+  for (size_t i = 0; i < list->count && budget > 0; ++ i) {
+    if (track->pidfd_count >= track->pidfd_max)
+      return;
+
+    const proc_info_t *p = &list->procs[i];
+    long pos = find_index_pos(track, p->pid);
+    if (pos == -1)
+      continue;
+
+    track_entry_t *e = &track->slab[track->index[pos]];
+    if (e->pidfd == -1) {
+      e->pidfd = open_pidfd(track, p->pid, p->starttime);
+      budget --;
+    }
+  }
+}
+
+/**
+ * @brief Find the history of a process in O(1).
+ *
+ * @return The entry, or NULL if the process is not tracked.
+ */
+const track_entry_t *track_lookup(const proc_track_t *track, uint64_t pid) {
+  if (!track)
+    return NULL;
+
+  long pos = find_index_pos(track, pid);
+  if (pos == -1)
+    return NULL;
+
+  return &track->slab[track->index[pos]];
+}
+
+/**
+ * @brief Send a signal to exactly the process seen in the last scan.
+ *
+ * Uses the pidfd of the tracked process, so a PID reused since the
+ * scan cannot be hit. A process whose pidfd is not open yet is pinned
+ * by a temporary one, checked against its start time. Only on kernels
+ * without pidfd_open() is the start time checked right before kill(),
+ * which narrows the race to that window.
+ *
+ * @param track     Tracking table.
+ * @param pid       PID of the target.
+ * @param starttime Start time of the target when it was scanned.
+ * @param sig       Signal number.
+ *
+ * @return
+ *  - MYTOP_OK if the signal was sent.
+ *  - MYTOP_NO_FILE if the process has exited (or its PID was reused).
+ *  - MYTOP_ERR if the kernel refused (e.g. EPERM), errno is kept.
+ */
+mytop_status_t track_signal(const proc_track_t *track, uint64_t pid,
+                            uint64_t starttime, int sig) {
+  // Check input parameters
+  if (!track || pid == 0)
+    return MYTOP_ERR_PARAM;
+
+  const track_entry_t *e = track_lookup(track, pid);
+  if (e && e->starttime == starttime && e->pidfd != -1) {
+    if (syscall(SYS_pidfd_send_signal, e->pidfd, sig, NULL, 0) == 0)
+      return MYTOP_OK;
+    return errno == ESRCH ? MYTOP_NO_FILE : MYTOP_ERR;
+  }
+
+  // No pidfd kept for it (yet): pin the process with a temporary one
+  long fd = pidfd_open_checked(pid, starttime);
+  if (fd != -1) {
+    long rc = syscall(SYS_pidfd_send_signal, (int)fd, sig, NULL, 0);
+    int err = errno;
+    close((int)fd);
+    if (rc == 0)
+      return MYTOP_OK;
+    errno = err;
+    return err == ESRCH ? MYTOP_NO_FILE : MYTOP_ERR;
+  }
+  if (errno != ENOSYS && errno != EPERM)
+    return errno == ESRCH ? MYTOP_NO_FILE : MYTOP_ERR;
+
+  // No pidfd support at all: check the start time right before kill()
+  uint64_t now_start;
+  if (read_proc_starttime(pid, &now_start) != MYTOP_OK || now_start != starttime)
+    return MYTOP_NO_FILE;
+  if (kill((pid_t)pid, sig) == 0)
+    return MYTOP_OK;
+  return errno == ESRCH ? MYTOP_NO_FILE : MYTOP_ERR;
+}
+
+/**
+ * @brief Signal every process whose command line contains pattern.
+ *
+ * All targets are signalled in one pass over the list, through their
+ * pidfds; mytop itself is never a target.
+ *
+ * @param track   Tracking table.
+ * @param list    Process list on screen.
+ * @param pattern Substring to look for in the command line.
+ * @param sig     Signal number.
+ * @param failed  Set to the number of targets that could not be signalled.
+ *
+ * @return Number of processes signalled.
+ */
+size_t track_signal_matching(const proc_track_t *track, const proc_list_t *list,
+                             const char *pattern, int sig, size_t *failed) {
+  size_t sent = 0;
+  *failed = 0;
+  if (!track || !list || !pattern || !*pattern)
+    return sent;
+
+  uint64_t self = (uint64_t)getpid();
+  for (size_t i = 0; i < list->count; ++ i) {
+    const proc_info_t *p = &list->procs[i];
+    if (p->pid == self || p->cmd == 0 ||
+        !strstr(strtab_get(list->strtab, p->cmd), pattern))
+      continue;
+
+    mytop_status_t st = track_signal(track, p->pid, p->starttime, sig);
+    if (st == MYTOP_OK)
+      sent ++;
+    else if (st != MYTOP_NO_FILE)
+      (*failed) ++;
+  }
+
+  return sent;
+}
+
+/**
+ * @brief Refresh the cached smaps_rollup values of the visible rows.
+ *
+ * Reading smaps_rollup walks page tables, so at most budget reads are
+ * issued per call. Among the visible rows of list, entries that were
+ * never read come first, then the ones with the oldest data, so every
+ * visible row is refreshed in turn.
+ *
+ * @param track   Tracking table holding the cache.
+ * @param list    Sorted process list.
+ * @param first   Index of the first displayed row.
+ * @param visible Number of rows displayed from first on.
+ * @param budget  Maximum number of smaps_rollup reads (clamped to SMAPS_MAX_BUDGET).
+ */
+void track_refresh_smaps(proc_track_t *track, const proc_list_t *list,
+                         size_t first, size_t visible, size_t budget) {
+  if (!track || !list || first >= list->count)
+    return;
+
+  if (visible > list->count - first) visible = list->count - first;
+  if (budget > SMAPS_MAX_BUDGET) budget = SMAPS_MAX_BUDGET;
+
+  // Keep the budget oldest entries, ordered by ascending smaps_tick
+  track_entry_t *pick[SMAPS_MAX_BUDGET];
+  size_t picked = 0;
+
+  for (size_t i = 0; i < visible && budget > 0; ++ i) {
+    long pos = find_index_pos(track, list->procs[first + i].pid);
+    if (pos == -1)
+      continue;
+
+    track_entry_t *e = &track->slab[track->index[pos]];
+    // Already fresh in this tick
+    if (e->smaps_tick == track->tick)
+      continue;
+
+    if (picked == budget && e->smaps_tick >= pick[picked - 1]->smaps_tick)
+      continue;
+
+    size_t j = picked < budget ? picked ++ : picked - 1;
+    for (; j > 0 && pick[j - 1]->smaps_tick > e->smaps_tick; -- j)
+      pick[j] = pick[j - 1];
+    pick[j] = e;
+  }
+
+  for (size_t i = 0; i < picked; ++ i) {
+    track_entry_t *e = pick[i];
+    e->smaps_valid = parse_smaps_rollup(e->pid, &e->smaps) == MYTOP_OK;
+    e->smaps_tick = track->tick;
+  }
+}
+
+/**
+ * @brief Refresh the context switch rates of the visible rows.
+ *
+ * /proc/[pid]/status is only read for rows on screen; a rate needs two
+ * reads, so a row shows it from its second refresh on.
+ *
+ * @param track   Tracking table holding the counters.
+ * @param list    Sorted process list.
+ * @param first   Index of the first displayed row.
+ * @param visible Number of rows displayed from first on.
+ */
+void track_refresh_ctxsw(proc_track_t *track, const proc_list_t *list,
+                         size_t first, size_t visible) {
+  if (!track || !list || first >= list->count)
+    return;
+
+  if (visible > list->count - first) visible = list->count - first;
+
+  for (size_t i = 0; i < visible; ++ i) {
+    long pos = find_index_pos(track, list->procs[first + i].pid);
+    if (pos == -1)
+      continue;
+
+    track_entry_t *e = &track->slab[track->index[pos]];
+    uint64_t vcsw, nvcsw;
+    if (parse_proc_ctxsw(e->pid, &vcsw, &nvcsw) != MYTOP_OK)
+      continue;
+
+    uint64_t now = monotonic_ns();
+    if (e->csw_ns != 0 && now > e->csw_ns) {
+      double secs = (now - e->csw_ns) / 1e9;
+      e->vcsw_rate = (float)((vcsw - e->vcsw) / secs);
+      e->nvcsw_rate = (float)((nvcsw - e->nvcsw) / secs);
+      e->csw_valid = 1;
+    }
+    e->vcsw = vcsw;
+    e->nvcsw = nvcsw;
+    e->csw_ns = now;
+  }
+}
+
+/**
+ * @brief Render the CPU or RSS history of a process as a block sparkline.
+ *
+ * The oldest sample is on the left. CPU samples are scaled against
+ * 100% (one full core), RSS samples against the largest one shown, so
+ * growth stands out at any size. Missing samples are padded with
+ * spaces, so the result always occupies HISTORY_LEN terminal columns.
+ *
+ * @param e      History entry (NULL renders an empty column).
+ * @param series History to draw.
+ * @param out    Output buffer (UTF-8, up to 3 bytes per column).
+ * @param out_sz Size of the output buffer.
+ */
+void track_format_sparkline(const track_entry_t *e, spark_series_t series, char *out,
+                            size_t out_sz) {
+  // Check input parameters
+  if (!out || out_sz == 0)
+    return;
+
+  size_t len = e ? e->len : 0;
+  size_t n = 0;
+
+  uint64_t peak = 0;
+  for (size_t i = 0; series == SPARK_RSS && i < len; ++ i) {
+    if (e->rss[i] > peak) peak = e->rss[i];
+  }
+
+  for (size_t col = 0; col < HISTORY_LEN; ++ col) {
+    const char *glyph = " ";
+
+    // Right-align the samples so the newest is always in the last column
+    if (col >= HISTORY_LEN - len) {
+      size_t age = HISTORY_LEN - 1 - col;
+      size_t idx = (e->head + HISTORY_LEN - 1 - age) % HISTORY_LEN;
+      float v = series == SPARK_RSS ? (peak ? (float)e->rss[idx] / (float)peak : 0.0f)
+                                    : e->cpu[idx] / 100.0f;
+      if (v < 0.0f) v = 0.0f;
+      if (v > 1.0f) v = 1.0f;
+      glyph = spark_blocks[(size_t)(v * (SPARK_LEVELS - 1) + 0.5f)];
+    }
+
+    size_t glen = strlen(glyph);
+    if (n + glen >= out_sz)
+      break;
+    memcpy(out + n, glyph, glen);
+    n += glen;
+  }
+
+  out[n] = '\0';
+}
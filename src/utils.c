@@ -6,13 +6,13 @@
 #include <ctype.h>
 #include <errno.h>
 #include <stdint.h>
+#include <signal.h>
 #include <stdlib.h>
-#include <sys/select.h>
-#include <termios.h>
+#include <string.h>
+#include <strings.h>
 #include <unistd.h>
 #include <inttypes.h>
-#include <termio.h>
-#include <sys/ioctl.h>
+#include <time.h>
 
 /**
  * @brief Skip spaces.
@@ -135,19 +135,51 @@ mytop_status_t str_to_num(const char *s, int base, numtype_t type, void *out) {
   }
 }
 
+static const struct {
+  int sig;
+  const char *name;
+} signal_names[] = {
+  {SIGHUP,  "HUP"},  {SIGINT,  "INT"},  {SIGQUIT, "QUIT"}, {SIGKILL, "KILL"},
+  {SIGUSR1, "USR1"}, {SIGUSR2, "USR2"}, {SIGTERM, "TERM"}, {SIGCONT, "CONT"},
+  {SIGSTOP, "STOP"}, {SIGTSTP, "TSTP"}, {SIGWINCH, "WINCH"},
+};
+
+#define SIGNAL_NAMES (sizeof(signal_names) / sizeof(signal_names[0]))
+
 /**
- * @brief Get the current terminal column width and row.
+ * @brief Parse a signal given by name ("TERM", "sigkill") or number ("9").
+ *
+ * @return The signal number, or -1 if s names no valid signal.
  */
-void get_term_size(int *rows, int *cols) {
-  struct winsize ws;
-  if (ioctl(STDOUT_FILENO, TIOCGWINSZ, &ws) == 0) {
-    if (rows) *rows = ws.ws_row;
-    if (cols) *cols = ws.ws_col;
-  } else {
-    // Default value
-    if (rows) *rows = 24;
-    if (cols) *cols = 80;
+int parse_signal(const char *s) {
+  if (!s)
+    return -1;
+
+  s = skip_spaces(s);
+  uint64_t num;
+  if (str_to_num(s, 10, NUM_U64, &num) == MYTOP_OK)
+    return (num > 0 && num <= (uint64_t)SIGRTMAX) ? (int)num : -1;
+
+  if (strncasecmp(s, "SIG", 3) == 0)
+    s += 3;
+  for (size_t i = 0; i < SIGNAL_NAMES; ++ i) {
+    if (strcasecmp(s, signal_names[i].name) == 0)
+      return signal_names[i].sig;
+  }
+
+  return -1;
+}
+
+/**
+ * @brief Name of a signal without the "SIG" prefix ("?" if unknown).
+ */
+const char *signal_name(int sig) {
+  for (size_t i = 0; i < SIGNAL_NAMES; ++ i) {
+    if (signal_names[i].sig == sig)
+      return signal_names[i].name;
   }
+
+  return "?";
 }
 
 /**
@@ -162,65 +194,6 @@ uint64_t pages_to_kb(uint64_t pages, uint64_t pagesize) {
   return (pages * pagesize) / 1024u;
 }
 
-/**
- * @brief Enable/disable raw mode (Raw Mode)
- *  - enable=true: Disable enter confirmation and echo (immediate key response)
- *  - enable=false: Restore normal mode
- */
-static struct termios orig_termios;
-int set_raw_mode(bool enable) {
-  if (enable) {
-    // 1. Get current attributes
-    if (tcgetattr(STDIN_FILENO, &orig_termios) == -1) return -1;
-
-    struct termios raw = orig_termios;
-
-    // 2. Modify attributes
-    // ICANON: Turn off canonical mode (no need for Enter)
-    // ECHO: Turn off echo (do not display input characters) 
-    raw.c_lflag &= ~(ICANON | ECHO);
-
-    // VMIN=0, VTIME=0: Read returns immediately, does not block
-    raw.c_cc[VMIN] = 0;
-    raw.c_cc[VTIME] = 0;
-
-    // 3. Set new attributes
-    if (tcsetattr(STDIN_FILENO, TCSAFLUSH, &raw) == -1) return -1;
-  } else {
-    // Restore original attributes
-    if (tcsetattr(STDIN_FILENO, TCSAFLUSH, &orig_termios) == -1) return -1;
-  }
-
-  return 0;
-}
-
-// Check for key input (non-blocking)
-bool kbhit() {
-  struct timeval tv = {0L, 0L};
-
-  fd_set fds;
-  FD_ZERO(&fds);
-  FD_SET(STDIN_FILENO, &fds);
-
-  // select() check if stdin is readable
-  int r = select(STDIN_FILENO + 1, &fds, NULL, NULL, &tv);
-  if (r > 0) {
-    return FD_ISSET(STDIN_FILENO, &fds);
-  }
-
-  if (r == 0) {
-    // No input available
-    return false;
-  }
-
-  if (errno == EINTR) {
-    // Interrupted by signal
-    return false;
-  }
-
-  return false;
-}
-
 /**
  * @brief Format CPU time (jiffies) into a human‑readable string.
  *
@@ -288,99 +261,30 @@ double mem_uint_convert(uint64_t value, mem_uint_t from, mem_uint_t to) {
 }
 
 /**
- * @brief Read one line of input in Raw Mode (blocking)
- * @param buf Output buffer
- * @param maxlen Maximum buffer length
- * @return int Number of characters read
- */
-int term_read_line(char *buf, size_t maxlen) {
-  size_t len = 0;
-  char c;
-
-  while (1) {
-    // Blocking read of 1 character
-    if (read(STDIN_FILENO, &c, 1) != 1) break;
-
-    // Enter key
-    if (c == '\n' || c == '\r') {
-      break;
-    }
-    // Backspace key
-    else if (c == 27 || c == '\b') {
-      if (len > 0) {
-        len --;
-        // Visual erasure: Move cursor back, print space to overwrite, 
-        // then move cursor back again
-        printf("\b \b"); 
-        fflush(stdout);
-      }
-    }
-    // Regular characters
-    else if (len < maxlen - 1) {
-      if (!iscntrl(c)) {
-        buf[len ++] = c;
-        printf("%c", c);
-        fflush(stdout);
-      }
-    }
-  }
-
-  buf[len] = '\0';
-  return len;
-}
-
-/**
- * @brief Get the count of core.
- */
-long get_core_count() {
-  return sysconf(_SC_NPROCESSORS_ONLN);
-}
-
-/**
- * @brief Clear screen.
- */
-void term_clear_screen() {
-  printf("\033[2J");
-}
-
-/**
- * @brief Clear line.
- */
-void term_clear_line() {
-  printf("\033[K");
-}
-
-/**
- * @brief Move cursor.
- */
-void term_move_cursor(int row, int col) {
-  printf("\033[%d;%dH", row, col);
-}
-
-/**
- * @brief Cursor home.
- */
-void term_home() {
-  printf("\033[H");
-}
-
-/**
- * @brief Hide cursor.
+ * @brief Current CLOCK_MONOTONIC time in nanoseconds.
+ *
+ * The clock is system-wide, so values can be compared across processes.
  */
-void term_hide_cursor() {
-  printf("\033[?25l");
+uint64_t monotonic_ns(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
 }
 
 /**
- * @brief Show cursor.
+ * @brief Time since boot in nanoseconds, suspend included (CLOCK_BOOTTIME).
+ *
+ * Same origin as the starttime field of /proc/[pid]/stat.
  */
-void term_show_cursor() {
-  printf("\033[?25h");
+uint64_t boottime_ns(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_BOOTTIME, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
 }
 
 /**
- * @brief Flush the buffer.
+ * @brief Get the count of core.
  */
-void term_refresh() {
-  fflush(stdout);
+long get_core_count() {
+  return sysconf(_SC_NPROCESSORS_ONLN);
 }
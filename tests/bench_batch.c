@@ -0,0 +1,166 @@
+/*
+** bench_batch.c -- Cost of batch ticks: formatting alone, then end to end
+**
+** Synthetic processes with realistic field widths and command lines
+** are written tick after tick to an in-memory file, which also gives
+** the output volume.
+**
+** Then idle processes are spawned until the host runs the requested
+** number, and "mytop -b --sort cpu" writes JSON ticks to an in-memory
+** file. The CPU time of a run of ticks+1 ticks minus that of a 1-tick
+** run is the cost of the ticks alone (scan, CPU deltas, sort, write),
+** which is scaled to the target of 50k processes at 1 Hz; once reading
+** every process and once with --sample.
+**
+** usage: bench_batch [processes] [ticks] [live processes] [mytop]
+*/
+
+#define _GNU_SOURCE
+#include "fixture.h"
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+
+#define TARGET_PROCS   50000
+#define TARGET_PERCENT 5.0    // Of one core, at one tick per second
+#define SAMPLE_SLICES  "16"
+
+static const char *const commands[] = {
+  "/usr/sbin/sshd -D",
+  "postgres: checkpointer",
+  "/usr/bin/python3 -m http.server 8080",
+  "[kworker/3:1-events]",
+  "java -Xmx4g -jar /opt/app/service.jar --config \"/etc/app/a b.yml\"",
+};
+
+/**
+ * Helper function
+ *
+ * @brief CPU seconds (user + system) of one batch run of mytop.
+ *
+ * @return The CPU time, or -1 if mytop failed.
+ */
+static double run_batch(const char *mytop, int ticks, bool sampled) {
+  char n[16];
+  snprintf(n, sizeof(n), "%d", ticks);
+  int out = memfd_create("bench_batch", 0);
+  if (out == -1)
+    return -1;
+
+  pid_t pid = fork();
+  if (pid == 0) {
+    int null = open("/dev/null", O_WRONLY);
+    dup2(out, STDOUT_FILENO);
+    dup2(null, STDERR_FILENO);
+    execl(mytop, mytop, "-b", "--format", "json", "--sort", "cpu", "-d", "0.05", "-n", n,
+          sampled ? "--sample" : (char *)NULL, SAMPLE_SLICES, (char *)NULL);
+    _exit(127);
+  }
+
+  int status;
+  struct rusage ru;
+  if (pid == -1 || wait4(pid, &status, 0, &ru) != pid || !WIFEXITED(status) ||
+      WEXITSTATUS(status) != 0) {
+    close(out);
+    return -1;
+  }
+  close(out);
+
+  return ru.ru_utime.tv_sec + ru.ru_utime.tv_usec / 1e6 +
+         ru.ru_stime.tv_sec + ru.ru_stime.tv_usec / 1e6;
+}
+
+/**
+ * Helper function
+ *
+ * @brief Time whole batch ticks on a host running live processes.
+ */
+static void bench_end_to_end(const char *mytop, size_t live, int ticks) {
+  pid_t *pids = calloc(live ? live : 1, sizeof(pid_t));
+  if (!pids)
+    exit(2);
+  size_t spawned = fixture_spawn_idle(pids, live);
+  size_t nprocs = fixture_count_procs();
+
+  printf("batch end to end: %zu processes (%zu spawned), %d ticks of %s -b\n",
+         nprocs, spawned, ticks, mytop);
+  for (int sampled = 0; sampled < 2; ++ sampled) {
+    double one = run_batch(mytop, 1, sampled);
+    double many = run_batch(mytop, ticks + 1, sampled);
+    CHECK(one >= 0 && many >= 0, "%s -b failed", mytop);
+    double tick_ms = (many - one) * 1e3 / ticks;
+    double target_ms = tick_ms * TARGET_PROCS / (double)nprocs;
+
+    printf("  %-12s %8.3f ms CPU/tick = %5.1f%% of a core at 1 Hz; at %d processes "
+           "%5.1f%% (target %.0f%%: %s)\n", sampled ? "--sample " SAMPLE_SLICES : "all read",
+           tick_ms, tick_ms / 10, TARGET_PROCS, target_ms / 10, TARGET_PERCENT,
+           target_ms / 10 < TARGET_PERCENT ? "met" : "not met");
+  }
+
+  fixture_reap_idle(pids, spawned);
+  free(pids);
+}
+
+int main(int argc, char *argv[]) {
+  size_t nprocs = argc > 1 ? strtoull(argv[1], NULL, 10) : 50000;
+  int ticks = argc > 2 ? atoi(argv[2]) : 20;
+  size_t live = argc > 3 ? strtoull(argv[3], NULL, 10) : 10000;
+  const char *mytop = argc > 4 ? argv[4] : "build/mytop";
+  if (nprocs == 0 || ticks < 1 || access(mytop, X_OK) != 0) {
+    fprintf(stderr, "usage: %s [processes] [ticks] [live processes] [mytop]\n", argv[0]);
+    return 2;
+  }
+
+  str_table_t *strtab = create_str_table();
+  proc_list_t *list = create_procs_list(0, strtab);
+  if (!strtab || !list)
+    return 2;
+
+  for (size_t i = 0; i < nprocs; ++ i) {
+    proc_info_t *p = fixture_add(list, 1000 + i * 7, commands[i % 5]);
+    p->ppid = 1 + i % 997;
+    p->pgrp = p->ppid;
+    p->state = i % 11 ? 'S' : 'R';
+    p->cpu_percent = (double)(i % 1000) / 37;
+    p->delay_percent = (double)(i % 100) / 13;
+    p->has_schedstat = 1;
+    p->vsize = (uint64_t)(i % 4096 + 1) << 20;
+    p->rss = i % 65536;
+    p->utime = i * 13;
+    p->stime = i * 3;
+  }
+
+  mem_info_t mem = { .total = 16384000, .used = 8123456, .available = 8260544,
+                     .buff_cache = 4000000, .swap_total = 2097148, .swap_used = 1024 };
+  const char *names[] = { "json", "csv", "tsv" };
+  const batch_format_t fmts[] = { FMT_JSON, FMT_CSV, FMT_TSV };
+
+  printf("batch: %zu processes, %d ticks\n", nprocs, ticks);
+  for (size_t f = 0; f < 3; ++ f) {
+    int fd = memfd_create("bench_batch", 0);
+    batch_writer_t w;
+    if (fd == -1 || batch_writer_open(&w, fd, fmts[f]) != MYTOP_OK)
+      return 2;
+
+    uint64_t start = monotonic_ns();
+    for (int t = 0; t < ticks; ++ t)
+      CHECK(batch_write_tick(&w, &mem, 42.5, list, list->count) == MYTOP_OK, "%s tick %d", names[f], t);
+    CHECK(batch_flush(&w) == MYTOP_OK, "%s flush", names[f]);
+    uint64_t elapsed = monotonic_ns() - start;
+
+    struct stat st;
+    fstat(fd, &st);
+    printf("  %-4s %8.3f ms/tick  %8.1f KiB/tick\n", names[f],
+           elapsed / 1e6 / ticks, st.st_size / 1024.0 / ticks);
+
+    batch_writer_close(&w);
+    close(fd);
+  }
+
+  free_procs_list(list);
+  free_str_table(strtab);
+
+  bench_end_to_end(mytop, live, ticks);
+  return fixture_result("bench_batch");
+}
@@ -0,0 +1,146 @@
+/*
+** bench_embed.c -- Cost of mytop_sample() for an agent sampling at 10 Hz
+**
+** Uses the public header only, as an embedding program would. Each
+** context runs on its own thread and samples every 100 ms into a
+** 64-record buffer, with io_uring and then with plain read(); the wall
+** and thread CPU time of every call are measured, the first call (which
+** grows the lists) aside. Messages go to a sink that counts them.
+**
+** usage: bench_embed [calls] [contexts]
+*/
+
+#include "libmytop.h"
+#include <inttypes.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define PERIOD_NS  100000000L  // 10 Hz
+#define MAX_CTX    8
+#define SNAP_PROCS 64
+
+typedef struct {
+  bool use_uring;
+  int calls;
+  int failures;
+  unsigned messages;        // Delivered to the sink
+  size_t nprocs;
+  double wall_us, max_us;   // Per call
+  double cpu_us;
+} job_t;
+
+/**
+ * Helper function
+ *
+ * @brief Read a clock in nanoseconds.
+ */
+static uint64_t clock_ns(clockid_t clock) {
+  struct timespec ts;
+  clock_gettime(clock, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+/**
+ * Helper function
+ *
+ * @brief Log sink: count the messages of a context.
+ */
+static void count_message(void *user, mytop_log_level_t level, const char *module,
+                          const char *file, int line, const char *msg) {
+  (void)level; (void)module; (void)file; (void)line; (void)msg;
+  ((job_t *)user)->messages ++;
+}
+
+/**
+ * Helper function
+ *
+ * @brief Thread body: one context sampling at 10 Hz.
+ */
+static void *run_job(void *arg) {
+  job_t *job = arg;
+  mytop_options_t opts;
+  mytop_options_init(&opts);
+  opts.use_uring = job->use_uring;
+  opts.log.fn = count_message;
+  opts.log.user = job;
+  opts.log.level = MYTOP_LOG_DEBUG;
+
+  mytop_ctx_t *ctx;
+  if (mytop_open(&ctx, &opts) != MYTOP_OK) {
+    job->failures ++;
+    return NULL;
+  }
+
+  mytop_proc_t *procs = calloc(SNAP_PROCS, sizeof(mytop_proc_t));
+  mytop_snapshot_t snap = { .procs = procs, .capacity = procs ? SNAP_PROCS : 0 };
+  uint64_t wall = 0, cpu = 0, max = 0;
+  for (int i = 0; i <= job->calls; ++ i) {
+    struct timespec period = { 0, PERIOD_NS };
+    nanosleep(&period, NULL);
+
+    uint64_t w0 = clock_ns(CLOCK_MONOTONIC), c0 = clock_ns(CLOCK_THREAD_CPUTIME_ID);
+    if (mytop_sample(ctx, &snap) != MYTOP_OK)
+      job->failures ++;
+    uint64_t w = clock_ns(CLOCK_MONOTONIC) - w0, c = clock_ns(CLOCK_THREAD_CPUTIME_ID) - c0;
+
+    if (i == 0)
+      continue;
+    wall += w;
+    cpu += c;
+    if (w > max) max = w;
+  }
+
+  job->nprocs = snap.nprocs;
+  job->wall_us = wall / 1e3 / job->calls;
+  job->max_us = max / 1e3;
+  job->cpu_us = cpu / 1e3 / job->calls;
+  if (snap.count == 0 || snap.mem.total_kb == 0)
+    job->failures ++;
+
+  mytop_close(ctx);
+  free(procs);
+  return NULL;
+}
+
+int main(int argc, char *argv[]) {
+  int calls = argc > 1 ? atoi(argv[1]) : 20;
+  int nctx = argc > 2 ? atoi(argv[2]) : 1;
+  if (calls < 1 || nctx < 1 || nctx > MAX_CTX) {
+    fprintf(stderr, "usage: %s [calls] [contexts 1-%d]\n", argv[0], MAX_CTX);
+    return 2;
+  }
+
+  int failures = 0;
+  printf("embed: %d calls at 10 Hz, %d context(s) per backend\n", calls, nctx);
+  for (int b = 0; b < 2; ++ b) {
+    pthread_t threads[MAX_CTX];
+    job_t jobs[MAX_CTX];
+    for (int i = 0; i < nctx; ++ i) {
+      memset(&jobs[i], 0, sizeof(jobs[i]));
+      jobs[i].use_uring = b == 0;
+      jobs[i].calls = calls;
+      if (pthread_create(&threads[i], NULL, run_job, &jobs[i]) != 0)
+        return 2;
+    }
+
+    for (int i = 0; i < nctx; ++ i) {
+      pthread_join(threads[i], NULL);
+      const job_t *j = &jobs[i];
+      printf("  %-8s ctx %d: %zu processes, %8.1f us/call wall (max %.1f), "
+             "%8.1f us/call CPU = %.2f%% of a core, %u messages\n",
+             j->use_uring ? "io_uring" : "read()", i, j->nprocs, j->wall_us, j->max_us,
+             j->cpu_us, j->cpu_us * 10 / 1e4, j->messages);
+      if (j->failures)
+        fprintf(stderr, "bench_embed: ctx %d: %d failed call(s)\n", i, j->failures);
+      failures += j->failures;
+    }
+  }
+
+  if (failures)
+    return 1;
+  printf("bench_embed: ok\n");
+  return 0;
+}
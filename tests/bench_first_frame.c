@@ -0,0 +1,160 @@
+/*
+** bench_first_frame.c -- Time from exec to the first frame on a crowded host
+**
+** Spawns idle processes until the host has the requested number, then
+** starts mytop on a pseudo-terminal several times. Each run is timed
+** from fork() to the first "CPU Usage" line on the terminal, and the
+** time mytop logs itself on exit (from main() to the first flushed
+** frame) is reported next to it.
+**
+** usage: bench_first_frame [processes] [runs] [mytop]
+*/
+
+#define _GNU_SOURCE
+#include "fixture.h"
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/ioctl.h>
+#include <termios.h>
+
+#define FRAME_MARK "CPU Usage"
+#define LOG_MARK   "First frame drawn "
+#define RUN_TIMEOUT_MS 10000
+
+/**
+ * Helper function
+ *
+ * @brief Run mytop once on a new pseudo-terminal.
+ *
+ * @param frame_ms  Fork to first frame on the terminal. [out]
+ * @param logged_ms First frame time logged by mytop (-1 if absent). [out]
+ *
+ * @return true if a frame was seen and mytop exited.
+ */
+static bool run_once(const char *mytop, double *frame_ms, double *logged_ms) {
+  int master = posix_openpt(O_RDWR | O_NOCTTY | O_CLOEXEC);
+  if (master == -1 || grantpt(master) != 0 || unlockpt(master) != 0)
+    return false;
+  struct winsize ws = { .ws_row = 40, .ws_col = 120 };
+  ioctl(master, TIOCSWINSZ, &ws);
+  const char *slave = ptsname(master);
+
+  int err_pipe[2];
+  if (!slave || pipe2(err_pipe, O_CLOEXEC) != 0) {
+    close(master);
+    return false;
+  }
+
+  uint64_t start = monotonic_ns();
+  pid_t pid = fork();
+  if (pid == 0) {
+    setsid();
+    int fd = open(slave, O_RDWR);
+    if (fd == -1)
+      _exit(127);
+    ioctl(fd, TIOCSCTTY, 0);
+    dup2(fd, STDIN_FILENO);
+    dup2(fd, STDOUT_FILENO);
+    dup2(err_pipe[1], STDERR_FILENO);
+    execl(mytop, mytop, (char *)NULL);
+    _exit(127);
+  }
+  close(err_pipe[1]);
+  if (pid == -1) {
+    close(err_pipe[0]);
+    close(master);
+    return false;
+  }
+
+  // 1. Wait for the first frame, keeping a tail to match across reads
+  char buf[8192 + sizeof(FRAME_MARK)];
+  size_t tail = 0;
+  *frame_ms = -1;
+  while (*frame_ms < 0) {
+    struct pollfd pfd = { .fd = master, .events = POLLIN };
+    if (poll(&pfd, 1, RUN_TIMEOUT_MS) <= 0)
+      break;
+    ssize_t n = read(master, buf + tail, sizeof(buf) - tail - 1);
+    if (n <= 0)
+      break;
+    buf[tail + n] = '\0';
+    if (strstr(buf, FRAME_MARK))
+      *frame_ms = (monotonic_ns() - start) / 1e6;
+    size_t len = tail + (size_t)n;
+    tail = len < sizeof(FRAME_MARK) ? len : sizeof(FRAME_MARK);
+    memmove(buf, buf + len - tail, tail);
+  }
+
+  // 2. Quit, draining the terminal so mytop never blocks on it
+  if (write(master, "q", 1) != 1)
+    kill(pid, SIGTERM);
+  for (;;) {
+    struct pollfd pfd = { .fd = master, .events = POLLIN };
+    if (poll(&pfd, 1, RUN_TIMEOUT_MS) <= 0 || read(master, buf, sizeof(buf)) <= 0)
+      break;
+  }
+
+  // 3. The logged time is on stderr
+  char log[16384];
+  size_t len = 0;
+  ssize_t n;
+  while (len < sizeof(log) - 1 && (n = read(err_pipe[0], log + len, sizeof(log) - 1 - len)) > 0)
+    len += (size_t)n;
+  log[len] = '\0';
+  const char *mark = strstr(log, LOG_MARK);
+  *logged_ms = mark ? strtod(mark + strlen(LOG_MARK), NULL) : -1;
+
+  int status;
+  kill(pid, SIGKILL);
+  waitpid(pid, &status, 0);
+  close(err_pipe[0]);
+  close(master);
+
+  return *frame_ms >= 0;
+}
+
+/**
+ * Helper function
+ *
+ * @brief Order doubles ascending (qsort callback).
+ */
+static int cmp_double(const void *pa, const void *pb) {
+  double a = *(const double *)pa, b = *(const double *)pb;
+  return (a > b) - (a < b);
+}
+
+int main(int argc, char *argv[]) {
+  size_t target = argc > 1 ? strtoull(argv[1], NULL, 10) : 10000;
+  int runs = argc > 2 ? atoi(argv[2]) : 5;
+  const char *mytop = argc > 3 ? argv[3] : "build/mytop";
+  if (runs < 1 || access(mytop, X_OK) != 0) {
+    fprintf(stderr, "usage: %s [processes] [runs] [mytop]\n", argv[0]);
+    return 2;
+  }
+
+  pid_t *pids = calloc(target ? target : 1, sizeof(pid_t));
+  double *frames = calloc((size_t)runs, sizeof(double));
+  if (!pids || !frames)
+    return 2;
+
+  size_t spawned = fixture_spawn_idle(pids, target);
+  printf("first frame: %zu processes (%zu spawned), %d runs of %s\n",
+         fixture_count_procs(), spawned, runs, mytop);
+
+  for (int r = 0; r < runs; ++ r) {
+    double logged;
+    bool ok = run_once(mytop, &frames[r], &logged);
+    CHECK(ok, "run %d: no frame within %d ms", r, RUN_TIMEOUT_MS);
+    CHECK(logged >= 0, "run %d: first frame time not logged", r);
+    printf("  run %d: exec to frame %8.1f ms, logged %8.1f ms\n", r, frames[r], logged);
+  }
+
+  qsort(frames, (size_t)runs, sizeof(double), cmp_double);
+  printf("  median: exec to frame %8.1f ms\n", frames[runs / 2]);
+
+  fixture_reap_idle(pids, spawned);
+
+  free(frames);
+  free(pids);
+  return fixture_result("bench_first_frame");
+}
@@ -0,0 +1,70 @@
+/*
+** bench_sampled.c -- Cost of a --sample N scan against a full scan
+**
+** Each tick scans, computes the CPU deltas and sorts by CPU%, as the
+** collector does, reading every process and then a rotating slice of
+** them (plain read(), the default sources). A sampled scan still lists
+** every PID, so its cost is that of the listing plus 1/N of the reads.
+**
+** usage: bench_sampled [slices] [ticks]
+*/
+
+#include "fixture.h"
+
+/**
+ * Helper function
+ *
+ * @brief Milliseconds per tick, reading 1/slices of the processes (1 = all).
+ */
+static double time_ticks(uint32_t slices, int ticks, size_t *nprocs, size_t *stale) {
+  str_table_t *strtab = create_str_table();
+  proc_list_t *prev = create_procs_list(0, strtab);
+  proc_list_t *curr = create_procs_list(0, strtab);
+  if (!strtab || !prev || !curr)
+    exit(2);
+
+  lifecycle_t lc = {0};
+  CHECK(parse_procs(prev) == MYTOP_OK, "baseline scan failed");
+  sort_procs_by_mode(prev, SORT_CPU);
+  *stale = 0;
+  uint64_t start = monotonic_ns();
+  for (int t = 0; t < ticks; ++ t) {
+    clear_procs_list(curr);
+    CHECK(parse_procs_sampled(curr, prev, slices, (uint64_t)t) == MYTOP_OK, "tick %d failed", t);
+    calculate_procs_cpu(prev, curr, &lc);
+    sort_procs_incremental(prev, curr, SORT_CPU);
+    for (size_t i = 0; i < curr->count; ++ i)
+      *stale += curr->procs[i].stale != 0;
+    proc_list_t *temp = prev;
+    prev = curr;
+    curr = temp;
+  }
+  double ms = (monotonic_ns() - start) / 1e6 / ticks;
+  *nprocs = prev->count;
+  *stale /= (size_t)ticks;
+
+  free_procs_list(prev);
+  free_procs_list(curr);
+  free_str_table(strtab);
+  return ms;
+}
+
+int main(int argc, char *argv[]) {
+  int slices = argc > 1 ? atoi(argv[1]) : 8;
+  int ticks = argc > 2 ? atoi(argv[2]) : 50;
+  if (slices < 2 || slices > SAMPLE_MAX_SLICES || ticks < 1) {
+    fprintf(stderr, "usage: %s [slices 2-%d] [ticks]\n", argv[0], SAMPLE_MAX_SLICES);
+    return 2;
+  }
+
+  size_t nfull, nsampled, stale_full, stale;
+  double full_ms = time_ticks(1, ticks, &nfull, &stale_full);
+  double sampled_ms = time_ticks((uint32_t)slices, ticks, &nsampled, &stale);
+  CHECK(stale_full == 0, "full scan kept %zu stale records", stale_full);
+
+  printf("sampled: %d ticks (scan, CPU deltas, sort)\n", ticks);
+  printf("  full scan:  %8.3f ms/tick, %zu processes\n", full_ms, nfull);
+  printf("  --sample %-2d %8.3f ms/tick, %zu processes, %zu kept stale per tick\n",
+         slices, sampled_ms, nsampled, stale);
+  return fixture_result("bench_sampled");
+}
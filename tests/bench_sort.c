@@ -0,0 +1,128 @@
+/*
+** bench_sort.c -- Incremental re-sort against a cold qsort on a replayed workload
+**
+** Each tick of the replay changes the CPU% of a share of the processes,
+** removes a few and starts new ones, like consecutive /proc scans. The
+** current list arrives in PID order (as a scan produces it) and is sorted
+** both from the previous frame's order and from scratch; the two orders
+** must be identical.
+**
+** usage: bench_sort [processes] [ticks]
+*/
+
+#include "fixture.h"
+
+#define CHURN_PERCENT  5    // Processes whose CPU% changes each tick
+#define DEPART_PERMIL  1    // Processes exiting each tick (per mille)
+#define ARRIVALS       50   // Processes started each tick
+
+/**
+ * Helper function
+ *
+ * @brief Small deterministic generator (xorshift64), so runs are comparable.
+ */
+static uint64_t next_rand(uint64_t *state) {
+  uint64_t x = *state;
+  x ^= x << 13;
+  x ^= x >> 7;
+  x ^= x << 17;
+  return *state = x;
+}
+
+/**
+ * Helper function
+ *
+ * @brief Build the next scan from the live workload, in PID order.
+ */
+static void replay_scan(proc_list_t *list, const proc_info_t *live, size_t n) {
+  clear_procs_list(list);
+  for (size_t i = 0; i < n; ++ i) {
+    proc_info_t *p = fixture_add(list, live[i].pid, "worker");
+    p->cpu_percent = live[i].cpu_percent;
+    p->rss = live[i].rss;
+  }
+}
+
+int main(int argc, char *argv[]) {
+  size_t nprocs = argc > 1 ? strtoull(argv[1], NULL, 10) : 50000;
+  int ticks = argc > 2 ? atoi(argv[2]) : 50;
+  if (nprocs < 1000 || ticks < 2) {
+    fprintf(stderr, "usage: %s [processes >= 1000] [ticks >= 2]\n", argv[0]);
+    return 2;
+  }
+
+  uint64_t seed = 0x9e3779b97f4a7c15ull;
+  size_t cap = nprocs + (size_t)ticks * ARRIVALS;
+  proc_info_t *live = calloc(cap, sizeof(proc_info_t));
+  str_table_t *strtab = create_str_table();
+  proc_list_t *prev = create_procs_list(0, strtab);
+  proc_list_t *curr = create_procs_list(0, strtab);
+  proc_list_t *cold = create_procs_list(0, strtab);
+  if (!live || !strtab || !prev || !curr || !cold)
+    return 2;
+
+  size_t n = nprocs;
+  uint64_t next_pid = 1;
+  for (size_t i = 0; i < n; ++ i) {
+    live[i].pid = next_pid ++;
+    live[i].cpu_percent = (double)(next_rand(&seed) % 1000) / 100;
+    live[i].rss = next_rand(&seed) % 100000;
+  }
+
+  replay_scan(prev, live, n);
+  sort_procs_by_mode(prev, SORT_CPU);
+
+  uint64_t incr_ns = 0, cold_ns = 0;
+  for (int t = 0; t < ticks; ++ t) {
+    // 1. Evolve the workload: CPU% changes, exits, then arrivals (higher PIDs)
+    for (size_t k = 0; k < n * CHURN_PERCENT / 100; ++ k) {
+      proc_info_t *p = &live[next_rand(&seed) % n];
+      p->cpu_percent = (double)(next_rand(&seed) % 1000) / 100;
+    }
+    size_t kept = 0;
+    for (size_t i = 0; i < n; ++ i) {
+      if (next_rand(&seed) % 1000 >= DEPART_PERMIL)
+        live[kept ++] = live[i];
+    }
+    n = kept;
+    for (size_t k = 0; k < ARRIVALS && n < cap; ++ k) {
+      live[n].pid = next_pid ++;
+      live[n].cpu_percent = (double)(next_rand(&seed) % 1000) / 100;
+      live[n].rss = next_rand(&seed) % 100000;
+      n ++;
+    }
+
+    // 2. Sort the same scan both ways
+    replay_scan(curr, live, n);
+    copy_procs_list(cold, curr);
+
+    uint64_t start = monotonic_ns();
+    sort_procs_incremental(prev, curr, SORT_CPU);
+    incr_ns += monotonic_ns() - start;
+
+    start = monotonic_ns();
+    sort_procs_by_mode(cold, SORT_CPU);
+    cold_ns += monotonic_ns() - start;
+
+    for (size_t i = 0; i < n; ++ i)
+      CHECK(curr->procs[i].pid == cold->procs[i].pid,
+            "tick %d rank %zu: incremental PID %" PRIu64 ", qsort PID %" PRIu64,
+            t, i, curr->procs[i].pid, cold->procs[i].pid);
+
+    proc_list_t *temp = prev;
+    prev = curr;
+    curr = temp;
+  }
+
+  printf("sort: %zu processes, %d ticks (%d%% churn, %d/1000 exits, %d arrivals per tick)\n",
+         nprocs, ticks, CHURN_PERCENT, DEPART_PERMIL, ARRIVALS);
+  printf("  incremental: %8.3f ms/tick\n", incr_ns / 1e6 / ticks);
+  printf("  cold qsort:  %8.3f ms/tick\n", cold_ns / 1e6 / ticks);
+
+  free_procs_list(prev);
+  free_procs_list(curr);
+  free_procs_list(cold);
+  free_str_table(strtab);
+  free(live);
+  return fixture_result("bench_sort");
+}
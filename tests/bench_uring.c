@@ -0,0 +1,156 @@
+/*
+** bench_uring.c -- Full /proc scans through io_uring against plain read()
+**
+** Each backend scans the live process table repeatedly. Wall and CPU
+** time per scan and io_uring_enter() calls are measured in this
+** process; the system calls per scan are counted in a traced child
+** running the same scans (ptrace slows it down, so it is not timed).
+**
+** usage: bench_uring [scans]
+*/
+
+#include "fixture.h"
+#include <errno.h>
+#include <signal.h>
+#include <sys/ptrace.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+/**
+ * Helper function
+ *
+ * @brief Process CPU time (user + system) in nanoseconds.
+ */
+static uint64_t cpu_ns(void) {
+  struct rusage ru;
+  getrusage(RUSAGE_SELF, &ru);
+
+  return (uint64_t)(ru.ru_utime.tv_sec + ru.ru_stime.tv_sec) * 1000000000ull +
+         (uint64_t)(ru.ru_utime.tv_usec + ru.ru_stime.tv_usec) * 1000ull;
+}
+
+/**
+ * Helper function
+ *
+ * @brief Set up a list for one backend.
+ *
+ * @return false if io_uring was requested and is unavailable.
+ */
+static bool open_backend(proc_list_t *list, uring_t *ring, bool use_uring) {
+  list->acct = schedstat_available() ? ACCT_SCHEDSTAT : ACCT_JIFFIES;
+  ring->fd = -1;
+
+  return !use_uring || procs_attach_uring(ring, list, list);
+}
+
+/**
+ * Helper function
+ *
+ * @brief Run the scans; returns the number of processes of the last one.
+ */
+static size_t run_scans(proc_list_t *list, int scans) {
+  for (int s = 0; s < scans; ++ s) {
+    clear_procs_list(list);
+    CHECK(parse_procs(list) == MYTOP_OK, "scan %d failed", s);
+  }
+
+  return list->count;
+}
+
+/**
+ * Helper function
+ *
+ * @brief Count the system calls of the scans in a traced child.
+ *
+ * @return Calls per scan, or -1 if the child cannot be traced.
+ */
+static double count_syscalls(bool use_uring, int scans) {
+  pid_t pid = fork();
+  if (pid == -1)
+    return -1;
+
+  if (pid == 0) {
+    // Set up untraced, then stop so only the scans are counted
+    str_table_t *strtab = create_str_table();
+    proc_list_t *list = create_procs_list(0, strtab);
+    uring_t ring;
+    if (!list || !open_backend(list, &ring, use_uring) ||
+        ptrace(PTRACE_TRACEME, 0, NULL, NULL) != 0)
+      _exit(1);
+    raise(SIGSTOP);
+    run_scans(list, scans);
+    _exit(0);
+  }
+
+  int status;
+  if (waitpid(pid, &status, 0) != pid || !WIFSTOPPED(status)) {
+    waitpid(pid, &status, 0);
+    return -1;
+  }
+  ptrace(PTRACE_SETOPTIONS, pid, NULL, (void *)(long)(PTRACE_O_TRACESYSGOOD | PTRACE_O_EXITKILL));
+
+  // Each call stops on entry and on exit (exit_group only on entry)
+  uint64_t stops = 0;
+  for (;;) {
+    if (ptrace(PTRACE_SYSCALL, pid, NULL, NULL) != 0)
+      break;
+    if (waitpid(pid, &status, 0) != pid || WIFEXITED(status) || WIFSIGNALED(status))
+      break;
+    if (WIFSTOPPED(status) && WSTOPSIG(status) == (SIGTRAP | 0x80))
+      stops ++;
+  }
+
+  if (!WIFEXITED(status) || WEXITSTATUS(status) != 0)
+    return -1;
+
+  return (double)(stops + 1) / 2 / scans;
+}
+
+int main(int argc, char *argv[]) {
+  int scans = argc > 1 ? atoi(argv[1]) : 20;
+  if (scans < 1) {
+    fprintf(stderr, "usage: %s [scans]\n", argv[0]);
+    return 2;
+  }
+
+  const char *names[] = { "read()", "io_uring" };
+  printf("uring: %d full scans per backend\n", scans);
+  for (int b = 0; b < 2; ++ b) {
+    bool use_uring = b == 1;
+    str_table_t *strtab = create_str_table();
+    proc_list_t *list = create_procs_list(0, strtab);
+    uring_t ring;
+    if (!strtab || !list)
+      return 2;
+
+    if (!open_backend(list, &ring, use_uring)) {
+      printf("  %-8s unavailable: %s\n", names[b], strerror(errno));
+    } else {
+      // One untimed scan grows the list and warms the dentry cache
+      run_scans(list, 1);
+      uint64_t enters = ring.enters;
+
+      uint64_t wall = monotonic_ns(), cpu = cpu_ns();
+      size_t nprocs = run_scans(list, scans);
+      wall = monotonic_ns() - wall;
+      cpu = cpu_ns() - cpu;
+      enters = ring.enters - enters;
+
+      double calls = count_syscalls(use_uring, scans);
+      printf("  %-8s %zu processes: %8.3f ms/scan wall, %8.3f ms/scan CPU, ",
+             names[b], nprocs, wall / 1e6 / scans, cpu / 1e6 / scans);
+      if (calls < 0)
+        printf("syscalls n/a (cannot trace)");
+      else
+        printf("%8.1f syscalls/scan", calls);
+      printf(", %.1f io_uring_enter/scan\n", (double)enters / scans);
+    }
+
+    uring_free(&ring);
+    free_procs_list(list);
+    free_str_table(strtab);
+  }
+
+  return fixture_result("bench_uring");
+}
@@ -0,0 +1,99 @@
+/*
+** bench_watch.c -- Cost of a watch-list tick against a full /proc scan
+**
+** Idle children stand in for the watched services. Each tick scans and
+** computes the CPU deltas, as the collector does, first for the watch
+** list and then for every process on the host.
+**
+** usage: bench_watch [watched] [ticks]
+*/
+
+#define _GNU_SOURCE
+#include "fixture.h"
+#include <signal.h>
+#include <sys/prctl.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+/**
+ * Helper function
+ *
+ * @brief Milliseconds per tick of scans into two alternating lists.
+ */
+static double time_ticks(watch_t *w, int ticks, size_t *nprocs) {
+  str_table_t *strtab = create_str_table();
+  proc_list_t *prev = create_procs_list(0, strtab);
+  proc_list_t *curr = create_procs_list(0, strtab);
+  if (!strtab || !prev || !curr)
+    exit(2);
+  prev->acct = curr->acct = schedstat_available() ? ACCT_SCHEDSTAT : ACCT_JIFFIES;
+  if (w)
+    procs_attach_watch(w, prev, curr);
+
+  lifecycle_t lc = {0};
+  CHECK(parse_procs(prev) == MYTOP_OK, "baseline scan failed");
+  uint64_t start = monotonic_ns();
+  for (int t = 0; t < ticks; ++ t) {
+    clear_procs_list(curr);
+    CHECK(parse_procs(curr) == MYTOP_OK, "tick %d failed", t);
+    calculate_procs_cpu(prev, curr, &lc);
+    proc_list_t *temp = prev;
+    prev = curr;
+    curr = temp;
+  }
+  double ms = (monotonic_ns() - start) / 1e6 / ticks;
+  *nprocs = prev->count;
+
+  // The watch holds references into this string table
+  if (w)
+    watch_free(w);
+  free_procs_list(prev);
+  free_procs_list(curr);
+  free_str_table(strtab);
+  return ms;
+}
+
+int main(int argc, char *argv[]) {
+  int nwatch = argc > 1 ? atoi(argv[1]) : 4;
+  int ticks = argc > 2 ? atoi(argv[2]) : 200;
+  if (nwatch < 1 || nwatch > WATCH_MAX_PROCS || ticks < 1) {
+    fprintf(stderr, "usage: %s [watched 1-%d] [ticks]\n", argv[0], WATCH_MAX_PROCS);
+    return 2;
+  }
+
+  static watch_t w;
+  pid_t parent = getpid();
+  pid_t *pids = calloc((size_t)nwatch, sizeof(pid_t));
+  if (!pids)
+    return 2;
+  for (int i = 0; i < nwatch; ++ i) {
+    pids[i] = fork();
+    if (pids[i] == 0) {
+      prctl(PR_SET_PDEATHSIG, SIGKILL);
+      if (getppid() != parent)
+        _exit(0);
+      for (;;)
+        pause();
+    }
+    char arg[32];
+    snprintf(arg, sizeof(arg), "%d", (int)pids[i]);
+    if (pids[i] == -1 || watch_add_pids(&w, arg) != MYTOP_OK)
+      return 2;
+  }
+
+  size_t nwatched, nall;
+  double watch_ms = time_ticks(&w, ticks, &nwatched);
+  double full_ms = time_ticks(NULL, ticks, &nall);
+  CHECK(nwatched == (size_t)nwatch, "%zu of %d processes watched", nwatched, nwatch);
+
+  printf("watch: %d ticks (scan and CPU deltas)\n", ticks);
+  printf("  watch list: %8.3f ms/tick, %zu processes\n", watch_ms, nwatched);
+  printf("  full scan:  %8.3f ms/tick, %zu processes\n", full_ms, nall);
+
+  for (int i = 0; i < nwatch; ++ i)
+    kill(pids[i], SIGKILL);
+  for (int i = 0; i < nwatch; ++ i)
+    waitpid(pids[i], NULL, 0);
+  free(pids);
+  return fixture_result("bench_watch");
+}
@@ -0,0 +1,122 @@
+/*
+** fixture.h -- Synthetic process lists and checks shared by tests/ and benchmarks
+*/
+
+#ifndef FIXTURE_H
+#define FIXTURE_H
+
+#include "mytop.h"
+#include "mytop_types.h"
+#include "utils.h"
+#include <dirent.h>
+#include <errno.h>
+#include <inttypes.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/prctl.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+static int fixture_failures;
+
+// Record a failed check without stopping the test
+#define CHECK(cond, fmt, ...)                                              \
+  do {                                                                     \
+    if (!(cond)) {                                                         \
+      fprintf(stderr, "%s:%d: FAIL: " fmt "\n", __FILE__, __LINE__,        \
+              ##__VA_ARGS__);                                              \
+      fixture_failures ++;                                                 \
+    }                                                                      \
+  } while (0)
+
+/**
+ * @brief Append a record with a command and return it (other fields zero).
+ */
+static inline proc_info_t *fixture_add(proc_list_t *list, uint64_t pid, const char *cmd) {
+  if (reserve_procs_list(list, list->count + 1) != MYTOP_OK) {
+    fprintf(stderr, "fixture: out of memory\n");
+    exit(2);
+  }
+
+  proc_info_t *p = &list->procs[list->count ++];
+  memset(p, 0, sizeof(*p));
+  p->pid = pid;
+  p->state = 'S';
+  p->processor = -1;
+  p->cmd = strtab_intern(list->strtab, cmd, strlen(cmd));
+
+  return p;
+}
+
+/**
+ * @brief Number of processes on the host.
+ */
+static inline size_t fixture_count_procs(void) {
+  DIR *dir = opendir("/proc");
+  if (!dir)
+    return 0;
+
+  size_t n = 0;
+  struct dirent *dt;
+  while ((dt = readdir(dir)) != NULL)
+    n += dt->d_name[0] >= '1' && dt->d_name[0] <= '9';
+  closedir(dir);
+
+  return n;
+}
+
+/**
+ * @brief Fork idle children (killed with the benchmark) until the host
+ *        runs target processes.
+ *
+ * @return Number of children started.
+ */
+static inline size_t fixture_spawn_idle(pid_t *pids, size_t target) {
+  size_t have = fixture_count_procs(), n = 0;
+  pid_t parent = getpid();
+
+  while (have + n < target) {
+    pid_t pid = fork();
+    if (pid == -1) {
+      fprintf(stderr, "spawn: fork failed after %zu children: %s\n", n, strerror(errno));
+      break;
+    }
+    if (pid == 0) {
+      prctl(PR_SET_PDEATHSIG, SIGKILL);
+      if (getppid() != parent)
+        _exit(0);
+      for (;;)
+        pause();
+    }
+    pids[n ++] = pid;
+  }
+
+  return n;
+}
+
+/**
+ * @brief Kill and reap the children of fixture_spawn_idle().
+ */
+static inline void fixture_reap_idle(const pid_t *pids, size_t n) {
+  for (size_t i = 0; i < n; ++ i)
+    kill(pids[i], SIGKILL);
+  for (size_t i = 0; i < n; ++ i)
+    waitpid(pids[i], NULL, 0);
+}
+
+/**
+ * @brief Exit status of a test: report and return non-zero on any failure.
+ */
+static inline int fixture_result(const char *name) {
+  if (fixture_failures) {
+    fprintf(stderr, "%s: %d check(s) failed\n", name, fixture_failures);
+    return 1;
+  }
+
+  printf("%s: ok\n", name);
+  return 0;
+}
+
+#endif // !FIXTURE_H
@@ -0,0 +1,117 @@
+/*
+** test_children.c -- Reaped children are charged to their parents once (--children)
+**
+** Two synthetic scans 1 s apart, jiffy accounting. Each case is a parent
+** whose cutime grows because it waited for children in the interval;
+** what the children had already shown themselves must not be counted
+** again, wherever in the process tree they left from.
+*/
+
+#include "fixture.h"
+#include <math.h>
+#include <unistd.h>
+
+#define SCAN_NS 1000000000ull
+
+/**
+ * Helper function
+ *
+ * @brief Append a process to a scan (CPU times in ticks).
+ */
+static proc_info_t *add(proc_list_t *list, uint64_t pid, uint64_t ppid, uint64_t starttime,
+                        uint64_t ticks, uint64_t child_ticks) {
+  proc_info_t *p = fixture_add(list, pid, "proc");
+  p->ppid = ppid;
+  p->starttime = starttime;
+  p->utime = ticks;
+  p->cutime = child_ticks;
+  p->sample_ns = list->sample_ns;
+  return p;
+}
+
+/**
+ * Helper function
+ *
+ * @brief CPU% of a PID in a scan.
+ */
+static double cpu_of(const proc_list_t *list, uint64_t pid) {
+  for (size_t i = 0; i < list->count; ++ i) {
+    if (list->procs[i].pid == pid)
+      return list->procs[i].cpu_percent;
+  }
+
+  return NAN;
+}
+
+/**
+ * Helper function
+ *
+ * @brief Both scans of the cases, with or without --children.
+ */
+static void run(bool children, long hz) {
+  str_table_t *strtab = create_str_table();
+  proc_list_t *prev = create_procs_list(0, strtab);
+  proc_list_t *curr = create_procs_list(0, strtab);
+  if (!strtab || !prev || !curr)
+    exit(2);
+  prev->children = curr->children = children;
+  prev->sample_ns = SCAN_NS;
+  curr->sample_ns = 2 * SCAN_NS;
+  uint64_t t = (uint64_t)hz / 10;  // A tenth of a second, in ticks
+
+  // 1. A child never seen: all of its time is new (shell at 1 + 5 tenths)
+  add(prev, 100, 1, 10, 0, 0);
+  add(curr, 100, 1, 10, 1 * t, 5 * t);
+
+  // 2. A child seen with 3 tenths that ran 1 more before exiting: 1 + 1
+  add(prev, 200, 1, 10, 0, 0);
+  add(prev, 201, 200, 20, 3 * t, 0);
+  add(curr, 200, 1, 10, 1 * t, 4 * t);
+
+  // 3. timeout (301) around a loop (302), both gone: only the loop's last
+  //    tenth and timeout's own are new to the shell (300): 0 + 2
+  add(prev, 300, 1, 10, 0, 0);
+  add(prev, 301, 300, 20, 0, 0);
+  add(prev, 302, 301, 30, 8 * t, 0);
+  add(curr, 300, 1, 10, 0, 10 * t);
+
+  // 4. The departed "child" is older than the parent: the parent's PID was
+  //    reused, nothing is given back (2 + 2)
+  add(prev, 400, 1, 50, 2 * t, 0);
+  add(prev, 401, 400, 40, 6 * t, 0);
+  add(curr, 400, 1, 50, 4 * t, 2 * t);
+
+  lifecycle_t lc = {0};
+  calculate_procs_cpu(prev, curr, &lc);
+
+  const char *mode = children ? "children" : "own";
+  const double expect[][2] = {
+    { 100, children ? 60 : 10 },
+    { 200, children ? 20 : 10 },
+    { 300, children ? 20 : 0 },
+    { 400, children ? 40 : 20 },
+  };
+  for (size_t k = 0; k < sizeof(expect) / sizeof(expect[0]); ++ k) {
+    uint64_t pid = (uint64_t)expect[k][0];
+    double got = cpu_of(curr, pid);
+    CHECK(fabs(got - expect[k][1]) < 1e-6, "%s: PID %" PRIu64 " at %.3f%%, expected %.0f%%",
+          mode, pid, got, expect[k][1]);
+  }
+  CHECK(lc.deaths == 4, "%s: %" PRIu64 " deaths, expected 4", mode, lc.deaths);
+
+  free_procs_list(prev);
+  free_procs_list(curr);
+  free_str_table(strtab);
+}
+
+int main(void) {
+  long hz = sysconf(_SC_CLK_TCK);
+  if (hz <= 0 || hz % 10 != 0) {
+    fprintf(stderr, "test_children: unexpected CLK_TCK %ld\n", hz);
+    return 2;
+  }
+
+  run(true, hz);
+  run(false, hz);
+  return fixture_result("test_children");
+}
@@ -0,0 +1,85 @@
+/*
+** test_cpu_interval.c -- CPU% is measured over each process's own interval
+**
+** Every process runs at a steady 50% of a core. The first scan reads them
+** all at once; the second starts 1 s later and takes a full second, so
+** the last process is read almost 2 s after its previous sample. Divided
+** by the 1 s between the scan starts it would show nearly 100%; divided
+** by its own interval it must show 50%, on the jiffy and the schedstat
+** path alike.
+*/
+
+#include "fixture.h"
+#include <math.h>
+#include <unistd.h>
+
+#define START_NS    5000000000ull  // First scan
+#define INTERVAL_NS 1000000000ull  // Between the scan starts
+#define SCAN_NS     1000000000ull  // Duration of the second scan
+
+/**
+ * Helper function
+ *
+ * @brief Build both scans for one accounting path and check every process.
+ */
+static void check_ramp(bool schedstat, long hz) {
+  str_table_t *strtab = create_str_table();
+  proc_list_t *prev = create_procs_list(0, strtab);
+  proc_list_t *curr = create_procs_list(0, strtab);
+  if (!strtab || !prev || !curr)
+    exit(2);
+
+  // One process every 2 ticks of the scan, so 50% is a whole number of ticks
+  size_t n = (size_t)hz / 2;
+  uint64_t step_ns = SCAN_NS / n;
+  prev->sample_ns = START_NS;
+  curr->sample_ns = START_NS + INTERVAL_NS;
+
+  for (size_t i = 0; i < n; ++ i) {
+    uint64_t pid = 100 + i;
+    proc_info_t *old = fixture_add(prev, pid, "ramp");
+    old->starttime = 1;
+    old->sample_ns = START_NS;
+    old->has_schedstat = schedstat;
+    old->utime = 1000;
+    old->stime = 1000;
+    old->run_ns = 20 * SCAN_NS;
+
+    uint64_t elapsed_ns = INTERVAL_NS + i * step_ns;
+    proc_info_t *p = fixture_add(curr, pid, "ramp");
+    p->starttime = 1;
+    p->sample_ns = START_NS + elapsed_ns;
+    p->has_schedstat = schedstat;
+    // Half of the elapsed time, split between user and kernel mode
+    uint64_t ticks = elapsed_ns * (uint64_t)hz / 1000000000ull / 2;
+    p->utime = old->utime + ticks / 2;
+    p->stime = old->stime + ticks - ticks / 2;
+    p->run_ns = old->run_ns + elapsed_ns / 2;
+  }
+
+  calculate_procs_cpu(prev, curr, NULL);
+
+  const char *path = schedstat ? "schedstat" : "jiffies";
+  for (size_t i = 0; i < curr->count; ++ i) {
+    const proc_info_t *p = &curr->procs[i];
+    CHECK(fabs(p->cpu_percent - 50) < 1e-6, "%s: PID %" PRIu64 " read %.3f s into the scan at %.3f%%",
+          path, p->pid, (p->sample_ns - curr->sample_ns) / 1e9, p->cpu_percent);
+  }
+  CHECK(curr->count == n, "%s: %zu of %zu processes", path, curr->count, n);
+
+  free_procs_list(prev);
+  free_procs_list(curr);
+  free_str_table(strtab);
+}
+
+int main(void) {
+  long hz = sysconf(_SC_CLK_TCK);
+  if (hz < 2 || hz % 2 != 0) {
+    fprintf(stderr, "test_cpu_interval: unexpected CLK_TCK %ld\n", hz);
+    return 2;
+  }
+
+  check_ramp(false, hz);
+  check_ramp(true, hz);
+  return fixture_result("test_cpu_interval");
+}
@@ -0,0 +1,74 @@
+/*
+** test_sampled.c -- Sampled scans keep a stale record only for the same process
+**
+** The previous scan is synthetic: SAMPLE_HOT_PROCS records of PIDs that
+** do not exist come first, so the two real processes after them (this
+** one and its parent) fall outside the hot set and outside the slice.
+** The parent is recorded with the inode of its /proc directory and its
+** start time, and must be carried over stale; this process is recorded
+** with another inode and start time, as if its PID had been reused
+** since, and must be read again.
+*/
+
+#include "fixture.h"
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define ABSENT_PID 0x7fffff00ull  // Above any pid_max
+
+int main(void) {
+  uint64_t self = (uint64_t)getpid(), parent = (uint64_t)getppid();
+  uint64_t self_start, parent_start;
+  char path[64];
+  struct stat self_dir, parent_dir;
+  snprintf(path, sizeof(path), "/proc/%" PRIu64, parent);
+  if (read_proc_starttime(self, &self_start) != MYTOP_OK ||
+      read_proc_starttime(parent, &parent_start) != MYTOP_OK ||
+      stat("/proc/self/", &self_dir) != 0 || stat(path, &parent_dir) != 0) {
+    fprintf(stderr, "test_sampled: cannot read start times\n");
+    return 2;
+  }
+
+  // A slice holding neither process
+  uint32_t slices = SAMPLE_MAX_SLICES;
+  uint64_t scan = 0;
+  while (scan % slices == self % slices || scan % slices == parent % slices)
+    scan ++;
+
+  str_table_t *strtab = create_str_table();
+  proc_list_t *prev = create_procs_list(0, strtab);
+  proc_list_t *curr = create_procs_list(0, strtab);
+  if (!strtab || !prev || !curr)
+    return 2;
+
+  for (size_t i = 0; i < SAMPLE_HOT_PROCS; ++ i)
+    fixture_add(prev, ABSENT_PID + i, "gone");
+  proc_info_t *p = fixture_add(prev, parent, "parent");
+  p->starttime = parent_start;
+  p->ino = parent_dir.st_ino;
+  p = fixture_add(prev, self, "previous owner");
+  p->starttime = self_start + 1;
+  p->ino = self_dir.st_ino + 1;
+
+  CHECK(parse_procs_sampled(curr, prev, slices, scan) == MYTOP_OK, "sampled scan failed");
+
+  const proc_info_t *got_self = NULL, *got_parent = NULL;
+  for (size_t i = 0; i < curr->count; ++ i) {
+    if (curr->procs[i].pid == self) got_self = &curr->procs[i];
+    if (curr->procs[i].pid == parent) got_parent = &curr->procs[i];
+  }
+
+  CHECK(got_parent && got_parent->stale, "unchanged process not carried over stale");
+  CHECK(got_parent && got_parent->starttime == parent_start, "parent start time changed");
+  CHECK(got_self && !got_self->stale, "reused PID carried over instead of read");
+  CHECK(got_self && got_self->starttime == self_start,
+        "reused PID has start time %" PRIu64 ", expected %" PRIu64,
+        got_self ? got_self->starttime : 0, self_start);
+  CHECK(got_self && strcmp(strtab_get(strtab, got_self->cmd), "previous owner") != 0,
+        "reused PID kept the previous command");
+
+  free_procs_list(prev);
+  free_procs_list(curr);
+  free_str_table(strtab);
+  return fixture_result("test_sampled");
+}
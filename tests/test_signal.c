@@ -0,0 +1,50 @@
+/*
+** test_signal.c -- Signals reach only the process that was scanned
+**
+** The target is not in the tracking table, as after startup on a busy
+** host before its pidfd is opened. A start time that no longer matches
+** stands for a reused PID: nothing may be sent. With the right start
+** time the signal must arrive, and an exited PID must report gone.
+*/
+
+#define _GNU_SOURCE
+#include "fixture.h"
+#include <signal.h>
+#include <sys/prctl.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+int main(void) {
+  pid_t parent = getpid();
+  pid_t pid = fork();
+  if (pid == 0) {
+    prctl(PR_SET_PDEATHSIG, SIGKILL);
+    if (getppid() != parent)
+      _exit(0);
+    for (;;)
+      pause();
+  }
+
+  proc_track_t *track = create_proc_track(16);
+  uint64_t start;
+  if (pid == -1 || !track || read_proc_starttime((uint64_t)pid, &start) != MYTOP_OK)
+    return 2;
+
+  // 1. Another process under the same PID: left alone
+  int status;
+  CHECK(track_signal(track, (uint64_t)pid, start + 1, SIGTERM) == MYTOP_NO_FILE,
+        "reused PID not detected");
+  CHECK(waitpid(pid, &status, WNOHANG) == 0, "reused PID was signalled");
+
+  // 2. The scanned process itself: signalled through a temporary pidfd
+  CHECK(track_signal(track, (uint64_t)pid, start, SIGTERM) == MYTOP_OK, "signal not sent");
+  CHECK(waitpid(pid, &status, 0) == pid && WIFSIGNALED(status) && WTERMSIG(status) == SIGTERM,
+        "child not terminated by SIGTERM");
+
+  // 3. Gone: reported as such
+  CHECK(track_signal(track, (uint64_t)pid, start, SIGTERM) == MYTOP_NO_FILE,
+        "exited process not reported");
+
+  free_proc_track(track);
+  return fixture_result("test_signal");
+}
@@ -0,0 +1,50 @@
+/*
+** test_sparkline.c -- CPU and RSS histories are both drawn
+**
+** One synthetic process is fed to the tracking table for HISTORY_LEN
+** ticks at a steady 50% CPU while its RSS grows from 1 to HISTORY_LEN
+** pages. The CPU sparkline must be flat at half height; the RSS one
+** must climb from the lowest block to the full one at the newest sample.
+*/
+
+#include "fixture.h"
+
+#define LOW  "▁"
+#define HALF "▅"
+#define FULL "█"
+
+int main(void) {
+  str_table_t *strtab = create_str_table();
+  proc_list_t *list = create_procs_list(0, strtab);
+  proc_track_t *track = create_proc_track(16);
+  if (!strtab || !list || !track)
+    return 2;
+
+  proc_info_t *p = fixture_add(list, 4242, "leaky");
+  p->starttime = 7;
+  p->cpu_percent = 50;
+  for (uint64_t t = 1; t <= HISTORY_LEN; ++ t) {
+    p->rss = t;
+    track_update(track, list);
+  }
+
+  const track_entry_t *e = track_lookup(track, 4242);
+  CHECK(e && e->len == HISTORY_LEN, "history not kept");
+
+  char cpu[HISTORY_LEN * 4 + 1], rss[HISTORY_LEN * 4 + 1], flat[HISTORY_LEN * 4 + 1] = "";
+  track_format_sparkline(e, SPARK_CPU, cpu, sizeof(cpu));
+  track_format_sparkline(e, SPARK_RSS, rss, sizeof(rss));
+  for (int i = 0; i < HISTORY_LEN; ++ i)
+    strcat(flat, HALF);
+
+  CHECK(strcmp(cpu, flat) == 0, "CPU sparkline \"%s\"", cpu);
+  size_t glyph = strlen(FULL);
+  CHECK(strncmp(rss, LOW, glyph) == 0, "RSS sparkline starts with \"%.*s\"", (int)glyph, rss);
+  CHECK(strlen(rss) == HISTORY_LEN * glyph && strcmp(rss + strlen(rss) - glyph, FULL) == 0,
+        "RSS sparkline \"%s\" does not end at its peak", rss);
+
+  free_proc_track(track);
+  free_procs_list(list);
+  free_str_table(strtab);
+  return fixture_result("test_sparkline");
+}
@@ -0,0 +1,66 @@
+/*
+** test_uring_fallback.c -- A failed io_uring submission falls back to read()
+**
+** Two lists share a ring, as the collector's do. The ring descriptor is
+** then replaced by /dev/null, so the next io_uring_enter() fails. The
+** scan must still read every process (this one included) with read(),
+** and both lists must stop using the ring.
+*/
+
+#include "fixture.h"
+#include <fcntl.h>
+
+/**
+ * Helper function
+ *
+ * @brief Whether a scan holds a PID.
+ */
+static bool has_pid(const proc_list_t *list, uint64_t pid) {
+  for (size_t i = 0; i < list->count; ++ i) {
+    if (list->procs[i].pid == pid)
+      return true;
+  }
+
+  return false;
+}
+
+int main(void) {
+  str_table_t *strtab = create_str_table();
+  proc_list_t *a = create_procs_list(0, strtab);
+  proc_list_t *b = create_procs_list(0, strtab);
+  if (!strtab || !a || !b)
+    return 2;
+
+  uring_t ring = { .fd = -1 };
+  if (!procs_attach_uring(&ring, a, b)) {
+    printf("test_uring_fallback: skipped (no io_uring)\n");
+    return 0;
+  }
+
+  uint64_t self = (uint64_t)getpid();
+  CHECK(parse_procs(a) == MYTOP_OK && has_pid(a, self), "scan through the ring failed");
+  size_t through_ring = a->count;
+
+  // Break the ring under both lists
+  int null = open("/dev/null", O_RDONLY);
+  if (null == -1 || dup2(null, ring.fd) == -1)
+    return 2;
+  close(null);
+
+  clear_procs_list(a);
+  CHECK(parse_procs(a) == MYTOP_OK, "scan after the failed submission failed");
+  CHECK(has_pid(a, self), "this process missing after the fallback");
+  // A few processes may come and go between the scans
+  CHECK(a->count + 8 >= through_ring, "%zu processes read, %zu before", a->count, through_ring);
+  CHECK(a->uring == NULL && ring.fd == -1, "ring still in use");
+
+  clear_procs_list(b);
+  CHECK(parse_procs(b) == MYTOP_OK && has_pid(b, self), "scan of the other list failed");
+  CHECK(b->uring == NULL, "other list still points at the ring");
+
+  uring_free(&ring);
+  free_procs_list(a);
+  free_procs_list(b);
+  free_str_table(strtab);
+  return fixture_result("test_uring_fallback");
+}
@@ -0,0 +1,104 @@
+/*
+** test_watch.c -- Watch lists follow the processes first found under -p PIDs
+**
+** Two idle children are watched with -p. The first must be read with
+** its command line and start time; the second must be dropped once it
+** exits. PID reuse cannot be forced, so it is simulated by changing the
+** start time recorded for the first child: at the next rescan its PID
+** must leave the watch list rather than be followed again.
+*/
+
+#define _GNU_SOURCE
+#include "fixture.h"
+#include <signal.h>
+#include <sys/prctl.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+/**
+ * Helper function
+ *
+ * @brief Fork a child that waits to be killed.
+ */
+static pid_t spawn_idle(void) {
+  pid_t parent = getpid();
+  pid_t pid = fork();
+  if (pid == 0) {
+    prctl(PR_SET_PDEATHSIG, SIGKILL);
+    if (getppid() != parent)
+      _exit(0);
+    for (;;)
+      pause();
+  }
+
+  return pid;
+}
+
+/**
+ * Helper function
+ *
+ * @brief Record of a PID in a scan, or NULL.
+ */
+static const proc_info_t *find(const proc_list_t *list, uint64_t pid) {
+  for (size_t i = 0; i < list->count; ++ i) {
+    if (list->procs[i].pid == pid)
+      return &list->procs[i];
+  }
+
+  return NULL;
+}
+
+int main(int argc, char *argv[]) {
+  (void)argc;
+  pid_t kept = spawn_idle(), gone = spawn_idle();
+  if (kept == -1 || gone == -1)
+    return 2;
+
+  static watch_t w;
+  char arg[64];
+  snprintf(arg, sizeof(arg), "%d,%d", (int)kept, (int)gone);
+  str_table_t *strtab = create_str_table();
+  proc_list_t *list = create_procs_list(0, strtab);
+  if (!strtab || !list || watch_add_pids(&w, arg) != MYTOP_OK)
+    return 2;
+  procs_attach_watch(&w, list, list);
+
+  // 1. Both children are read through their directory descriptors
+  uint64_t kept_start;
+  CHECK(read_proc_starttime((uint64_t)kept, &kept_start) == MYTOP_OK, "no start time");
+  CHECK(parse_procs(list) == MYTOP_OK, "first scan failed");
+  const proc_info_t *p = find(list, (uint64_t)kept);
+  CHECK(p && p->starttime == kept_start, "watched child not read");
+  // The children run with this program's command line
+  CHECK(p && strcmp(strtab_get(strtab, p->cmd), argv[0]) == 0,
+        "command line \"%s\"", p ? strtab_get(strtab, p->cmd) : "");
+  CHECK(find(list, (uint64_t)gone), "second child not read");
+
+  // 2. An exited process is dropped by the next scan
+  kill(gone, SIGKILL);
+  waitpid(gone, NULL, 0);
+  clear_procs_list(list);
+  CHECK(parse_procs(list) == MYTOP_OK, "second scan failed");
+  CHECK(!find(list, (uint64_t)gone), "exited child still read");
+  CHECK(find(list, (uint64_t)kept), "live child lost");
+
+  // 3. A PID now naming another process is no longer watched
+  for (size_t i = 0; i < w.npids; ++ i) {
+    if (w.pids[i] == (uint64_t)kept)
+      w.pid_starts[i] = kept_start + 1;
+  }
+  w.next_rescan_ns = 0;
+  clear_procs_list(list);
+  CHECK(parse_procs(list) == MYTOP_OK, "third scan failed");
+  CHECK(!find(list, (uint64_t)kept), "reused PID followed");
+  for (size_t i = 0; i < w.npids; ++ i)
+    CHECK(w.pids[i] != (uint64_t)kept, "reused PID still in the -p list");
+  CHECK(w.count == 0, "%zu processes still watched", w.count);
+
+  kill(kept, SIGKILL);
+  waitpid(kept, NULL, 0);
+  watch_free(&w);
+  free_procs_list(list);
+  free_str_table(strtab);
+  return fixture_result("test_watch");
+}